@@ -0,0 +1,522 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmrBench.cpp
+ * @brief: Benchmarks of the parser, dependency graph and generator hot paths
+ *
+ ***********************************************************/
+#include <benchmark/benchmark.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include "generators/CPPGenerator.hpp"
+#include "generators/Graph.hpp"
+#include "parsers/PapyrusParser.hpp"
+#include "parsers/StringPool.hpp"
+#include "parsers/XmiTokenizer.hpp"
+#include "tools/XmiSynth.hpp"
+
+using namespace XMR;
+using namespace std;
+
+// Internals of CPPGenerator.cpp, linked into the benchmark directly
+namespace XMR {
+string generateQualifedName(const CPPRenderContext& context, IdHandle handle, string_view fullName);
+vector<const ModuleNode*> flatten(const ModelNode* root, const vector<string>& targets);
+}  // namespace XMR
+
+// Every allocation in the process is counted so each benchmark can report allocations per
+// iteration, which the perf harness tracks next to time
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+namespace {
+
+// Reports the allocations made since start, averaged over the iterations. Allocations made
+// while timing is paused are included, benchmarks keep their paused work allocation free
+// or accept it as part of the count.
+void reportAllocations(benchmark::State& state, uint64_t start) {
+  state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocationCount.load() - start), benchmark::Counter::kAvgIterations);
+}
+
+// Discards everything written to it while counting the bytes, used as the generator output
+class CountingBuffer : public std::streambuf {
+ public:
+  size_t bytes() const { return bytes_; }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (c != traits_type::eof()) bytes_++;
+    return traits_type::not_eof(c);
+  }
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    bytes_ += count;
+    return count;
+  }
+
+ private:
+  size_t bytes_ = 0;
+};
+
+// The parser and generators log progress to cout, which would interleave with the benchmark
+// report. Silenced only for the duration of a benchmark body.
+class QuietCout {
+ public:
+  QuietCout() : previous_(cout.rdbuf(&sink_)) {}
+  ~QuietCout() { cout.rdbuf(previous_); }
+
+ private:
+  CountingBuffer sink_;
+  std::streambuf* previous_;
+};
+
+// Class count of a synthetic model is packages * classes per package, spread over 4 top level packages
+SynthOptions synthOptions(int64_t classes) {
+  SynthOptions options;
+  options.depth_ = 1;
+  options.packagesPerLevel_ = 4;
+  options.classesPerPackage_ = static_cast<unsigned>(std::max<int64_t>(1, classes / 4));
+  options.generalizationFanIn_ = 1;
+  return options;
+}
+
+// Synthetic inputs are written once per size and reused by every benchmark
+const string& corpusFile(int64_t classes) {
+  static map<int64_t, string> files;
+  auto found = files.find(classes);
+  if (found != files.end()) return found->second;
+
+  string path = (filesystem::temp_directory_path() / ("xmr_bench_" + to_string(getpid()) + "_" + to_string(classes) + ".uml")).string();
+  ofstream out(path);
+  XmiSynth(synthOptions(classes)).write(out);
+  return files[classes] = path;
+}
+
+void removeCorpus() {
+  for (auto& entry : filesystem::directory_iterator(filesystem::temp_directory_path())) {
+    if (entry.path().filename().string().starts_with("xmr_bench_" + to_string(getpid()) + "_")) {
+      filesystem::remove(entry.path());
+    }
+  }
+}
+
+// The tree has no owning destructors, release what the benchmarks parse so memory stays flat.
+// Types belong to the model's type table and go with the model.
+void freeModule(ModuleNode* module) {
+  for (auto& nested : module->modules_) freeModule(nested);
+  for (auto& op : module->operators_) {
+    for (auto& param : op->params_) delete param;
+    delete op->returnType_;
+    delete op;
+  }
+  for (auto& attribute : module->attributes_) delete attribute;
+  delete module;
+}
+
+void freePackage(Package* package) {
+  for (auto& nested : package->packages_) freePackage(nested);
+  for (auto& module : package->modules_) freeModule(module);
+  delete package;
+}
+
+void freeModel(ModelNode* model) {
+  for (auto& package : model->packages_) freePackage(package);
+  for (auto& module : model->modules_) freeModule(module);
+  delete model;
+}
+
+// Parsed models are shared by the graph and generator benchmarks, frozen like the driver does
+const ModelNode* parsedModel(int64_t classes) {
+  static map<int64_t, ModelNode*> models;
+  auto found = models.find(classes);
+  if (found != models.end()) return found->second;
+
+  QuietCout quiet;
+  PapyrusParser parser;
+  ModelNode* model = parser.setInputFile(corpusFile(classes).c_str()) ? parser.parse() : nullptr;
+  if (model != nullptr) model->freeze();
+  return models[classes] = model;
+}
+
+DependencyGraph hardDependencyGraph(const ModelNode* model, size_t& edges) {
+  DependencyGraph graph;
+  edges = 0;
+  for (auto& module : flatten(model, {})) {
+    for (auto& dep : module->hardDependencyList_) {
+      graph.addEdge(module->id_, dep.first);
+      edges++;
+    }
+  }
+  return graph;
+}
+
+void BM_PapyrusParse(benchmark::State& state) {
+  const string& file = corpusFile(state.range(0));
+  const int64_t bytes = static_cast<int64_t>(filesystem::file_size(file));
+  QuietCout quiet;
+  PapyrusParser parser;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    if (!parser.setInputFile(file.c_str())) {
+      state.SkipWithError("Failed to load synthetic model");
+      break;
+    }
+    ModelNode* model = parser.parse();
+    benchmark::DoNotOptimize(model);
+    state.PauseTiming();
+    freeModel(model);
+    state.ResumeTiming();
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_PapyrusParse)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+// FastXmiParser exports the same plugin entry points as PapyrusParser, it is loaded the way the
+// driver loads it. Freeing a model unmaps its document, so the plugin stays open until the end.
+void BM_FastXmiParse(benchmark::State& state) {
+  const string& file = corpusFile(state.range(0));
+  const int64_t bytes = static_cast<int64_t>(filesystem::file_size(file));
+  void* handle = dlopen(XMR_PARSER_DIR "libFastXmiParser.so", RTLD_LAZY);
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+    return;
+  }
+  auto create = (IParser * (*)()) dlsym(handle, "create_parser");
+  auto destroy = (void (*)(IParser*))dlsym(handle, "destroy_parser");
+
+  QuietCout quiet;
+  IParser* parser = create();
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    if (!parser->setInputFile(file.c_str())) {
+      state.SkipWithError("Failed to load synthetic model");
+      break;
+    }
+    ModelNode* model = parser->parse();
+    benchmark::DoNotOptimize(model);
+    state.PauseTiming();
+    freeModel(model);
+    state.ResumeTiming();
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * bytes);
+
+  destroy(parser);
+  dlclose(handle);
+}
+BENCHMARK(BM_FastXmiParse)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+// Attribute values of the 1000 class corpus as the DOM hands them out. The argument is the
+// percentage of values given a non ASCII character, Papyrus ids and names are practically all
+// ASCII but documentation and user names need not be.
+const vector<u16string>& attributeValues(int64_t nonAsciiPercent) {
+  static map<int64_t, vector<u16string>> corpora;
+  auto found = corpora.find(nonAsciiPercent);
+  if (found != corpora.end()) return found->second;
+
+  ifstream in(corpusFile(1000));
+  string document((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  XmiTokenizer tokenizer(document.data(), document.data() + document.size());
+  vector<u16string>& values = corpora[nonAsciiPercent];
+  for (XmiToken token = tokenizer.next(); token == XmiToken::START || token == XmiToken::END; token = tokenizer.next()) {
+    for (auto& attribute : tokenizer.attributes()) {
+      u16string value(attribute.value_, attribute.value_ + strlen(attribute.value_));
+      if (static_cast<int64_t>(values.size() % 100) < nonAsciiPercent) value += u"\u00e9";
+      values.push_back(std::move(value));
+    }
+  }
+  return values;
+}
+
+void BM_TranscodeXerces(benchmark::State& state) {
+  const vector<u16string>& values = attributeValues(state.range(0));
+  xercesc::XMLPlatformUtils::Initialize();
+  int64_t units = 0;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    for (auto& value : values) {
+      char* text = xercesc::XMLString::transcode(reinterpret_cast<const XMLCh*>(value.c_str()));
+      benchmark::DoNotOptimize(text);
+      xercesc::XMLString::release(&text);
+      units += static_cast<int64_t>(value.size());
+    }
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(values.size()));
+  state.SetBytesProcessed(units * 2);
+  xercesc::XMLPlatformUtils::Terminate();
+}
+BENCHMARK(BM_TranscodeXerces)->Arg(0)->Arg(10)->Unit(benchmark::kMicrosecond);
+
+// Same values into a string pool, as the parsers keep model names
+void BM_TranscodeSimd(benchmark::State& state) {
+  const vector<u16string>& values = attributeValues(state.range(0));
+  int64_t units = 0;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    StringPool pool;
+    for (auto& value : values) {
+      benchmark::DoNotOptimize(pool.transcode(value.data(), value.size()));
+      units += static_cast<int64_t>(value.size());
+    }
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(values.size()));
+  state.SetBytesProcessed(units * 2);
+}
+BENCHMARK(BM_TranscodeSimd)->Arg(0)->Arg(10)->Unit(benchmark::kMicrosecond);
+
+void BM_TopSort(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  size_t edges;
+  DependencyGraph graph = hardDependencyGraph(model, edges);
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(graph.topSort());
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * edges);
+}
+BENCHMARK(BM_TopSort)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+void BM_HasCycle(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  size_t edges;
+  DependencyGraph graph = hardDependencyGraph(model, edges);
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(graph.hasCycle());
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * edges);
+}
+BENCHMARK(BM_HasCycle)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+void BM_Flatten(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(flatten(model, {}));
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Flatten)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+// Resolution and ordering every generator shares, done once per model by the driver
+void BM_LowerModel(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  LoweredModel lowered;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    lowered.lower(model);
+    benchmark::DoNotOptimize(lowered.dependencyOrder().data());
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes"] = static_cast<double>(lowered.heapBytes());
+}
+BENCHMARK(BM_LowerModel)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+// Impact queries for one module in the middle of the model, against the index freeze() built
+void BM_TransitiveDependents(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  const DependencyIndex& index = model->dependencyIndex_;
+  const vector<string> changed = {index.module(static_cast<uint32_t>(index.size() / 2))->id_};
+  const uint64_t allocations = allocationCount.load();
+  size_t found = 0;
+  for (auto _ : state) {
+    found = index.dependents(changed, DependencyIndex::ANY, true).size();
+    benchmark::DoNotOptimize(found);
+  }
+  reportAllocations(state, allocations);
+  state.counters["dependents"] = static_cast<double>(found);
+}
+BENCHMARK(BM_TransitiveDependents)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+void BM_RegenerationSet(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  const DependencyIndex& index = model->dependencyIndex_;
+  const vector<string> changed = {index.module(static_cast<uint32_t>(index.size() / 2))->id_};
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index.regenerationSet(changed));
+  }
+  reportAllocations(state, allocations);
+}
+BENCHMARK(BM_RegenerationSet)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+
+// Qualified names are resolved against the id index of a model from the model namespace, like a
+// generate run resolves them
+void BM_GenerateQualifiedName(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  CPPGenerator generator;
+  LoweredModel lowered;
+  lowered.lower(model);
+  ModelView<ModuleState> view(model);
+  CPPRenderContext context{generator, model->ids_, lowered, view};
+  context.currentScope_.push_back(model->name_);
+
+  vector<pair<IdHandle, string_view>> ids;
+  for (auto& module : flatten(model, {})) ids.emplace_back(model->ids_.find(module->id_), module->id_);
+  size_t i = 0;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(generateQualifedName(context, ids[i].first, ids[i].second));
+    i = (i + 1) % ids.size();
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateQualifiedName)->Arg(1000);
+
+void BM_CPPGenerator(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  CountingBuffer sink;
+  ostream os(&sink);
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    CPPGenerator generator;
+    benchmark::DoNotOptimize(generator.generate(os, model));
+  }
+  reportAllocations(state, allocations);
+  state.counters["output"] = static_cast<double>(sink.bytes()) / state.iterations();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(static_cast<int64_t>(sink.bytes()));
+}
+BENCHMARK(BM_CPPGenerator)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+// BM_CPPGenerator with the forward declarations hoisted into one block, "output" is the bytes
+// generated per run in both
+void BM_CPPGeneratorHoisted(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  CountingBuffer sink;
+  ostream os(&sink);
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    CPPGenerator generator;
+    generator.setOption("forward-declarations", "hoisted");
+    benchmark::DoNotOptimize(generator.generate(os, model));
+  }
+  reportAllocations(state, allocations);
+  state.counters["output"] = static_cast<double>(sink.bytes()) / state.iterations();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(static_cast<int64_t>(sink.bytes()));
+}
+BENCHMARK(BM_CPPGeneratorHoisted)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+// BM_CPPGenerator with classes grouped into runs of one namespace, which hoists the forward
+// declarations too, includes planning the runs
+void BM_CPPGeneratorGrouped(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  QuietCout quiet;
+  CountingBuffer sink;
+  ostream os(&sink);
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    CPPGenerator generator;
+    generator.setOption("namespaces", "grouped");
+    benchmark::DoNotOptimize(generator.generate(os, model));
+  }
+  reportAllocations(state, allocations);
+  state.counters["output"] = static_cast<double>(sink.bytes()) / state.iterations();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(static_cast<int64_t>(sink.bytes()));
+}
+BENCHMARK(BM_CPPGeneratorGrouped)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+// JavaGenerator shares internal symbol names with CPPGenerator so it is loaded as the plugin the
+// driver uses. It writes one file per class under ./src, the run happens in a scratch directory
+// and the bytes it wrote are measured there.
+void BM_JavaGenerator(benchmark::State& state) {
+  const ModelNode* model = parsedModel(state.range(0));
+  void* handle = dlopen(XMR_GENERATOR_DIR "libJavaGenerator.so", RTLD_LAZY);
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+    return;
+  }
+  auto create = (IGenerator * (*)()) dlsym(handle, "create_generator");
+  auto destroy = (void (*)(IGenerator*))dlsym(handle, "destroy_generator");
+
+  const filesystem::path previous = filesystem::current_path();
+  const filesystem::path scratch = filesystem::temp_directory_path() / ("xmr_bench_java_" + to_string(getpid()));
+  filesystem::create_directories(scratch);
+  filesystem::current_path(scratch);
+
+  QuietCout quiet;
+  CountingBuffer sink;
+  ostream os(&sink);
+  int64_t bytes = 0;
+  const uint64_t allocations = allocationCount.load();
+  for (auto _ : state) {
+    IGenerator* generator = create();
+    benchmark::DoNotOptimize(generator->generate(os, model));
+    destroy(generator);
+
+    state.PauseTiming();
+    for (auto& entry : filesystem::recursive_directory_iterator("src")) {
+      if (entry.is_regular_file()) bytes += static_cast<int64_t>(entry.file_size());
+    }
+    filesystem::remove_all("src");
+    state.ResumeTiming();
+  }
+  reportAllocations(state, allocations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(bytes + static_cast<int64_t>(sink.bytes()));
+
+  filesystem::current_path(previous);
+  filesystem::remove_all(scratch);
+  dlclose(handle);
+}
+BENCHMARK(BM_JavaGenerator)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  removeCorpus();
+  return 0;
+}
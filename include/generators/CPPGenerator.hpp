@@ -18,19 +18,79 @@
  *
  ***********************************************************/
 #include <generators/IGenerator.hpp>
+#include <generators/ModelView.hpp>
 namespace XMR {
 
+// Bookkeeping of a module while it is generated, the annotation of the generator's view
+struct ModuleState {
+  // Its class is defined, so uses of it need no forward declaration
+  bool generated_ = false;
+};
+
+// State of one generate call. Every generator object renders with a context of its own, so
+// generators on different threads share nothing but the frozen model and its lowered form.
+struct CPPRenderContext {
+  const IGenerator& generator_;
+  const IdIndex& ids_;
+  const LoweredModel& model_;
+  // Modules being generated, annotated with what is generated so far
+  ModelView<ModuleState>& view_;
+  GenerationCache* cache_ = nullptr;
+  bool hoisted_ = false;
+  bool grouped_ = false;
+  std::vector<std::string> currentScope_;
+  std::ostream* definitions_ = nullptr;  // shard the operators of the module being rendered are defined in, nullptr unsharded
+};
+
 class CPPGenerator : public IGenerator {
  public:
   CPPGenerator() {}
 
   ~CPPGenerator() {}
 
-  bool generate(std::ostream& os, ModelNode* root) final;
-  bool check(ModelNode* root) final;
+  bool generate(std::ostream& os, const ModelNode* root) final;
+  bool check(const ModelNode* root) final;
+  const char* name() const final { return "CPPGenerator"; }
+  const char* version() const final { return "3"; }
+  bool setTargets(const std::vector<std::string>& targets) final {
+    targets_ = targets;
+    return true;
+  }
+  // forward-declarations=per-class (default) declares the soft dependencies not yet generated
+  // before each class, forward-declarations=hoisted declares each once in a block before all classes.
+  // namespaces=per-class (default) opens and closes the namespaces of each class around it,
+  // namespaces=grouped orders classes into runs of one namespace and opens it once per run, it
+  // hoists the forward declarations as they can not be declared from inside another namespace.
+  // shards=N splits the output into a shared header of the classes in dependency order and N
+  // translation units defining their operators, balanced by estimated compile cost. They are
+  // written to shard-prefix.hpp and shard-prefix_<i>.cpp next to the output, named after the output
+  // by default, and the output lists them relative to itself. Sharding hoists the forward
+  // declarations, return types included. output=<path> is the path of the output, set by the driver.
+  bool setOption(const std::string& key, const std::string& value) final;
 
  private:
+  bool hoisted() const { return hoistForwardDeclarations_ || groupNamespaces_ || shards_ > 0; }
+  // Bin packs the modules of order_ into the shards
+  void assignShards(const LoweredModel& model);
+
   bool checkCalled_ = false;
   bool modelValid_ = false;
+  // Modules of the lowered model in generation order, computed by check
+  std::vector<LoweredModel::Index> order_;
+  // The modules of order_ in the same order, annotated by generate
+  ModelView<ModuleState> view_;
+  // Qualified names to generate, all modules if empty
+  std::vector<std::string> targets_;
+  bool hoistForwardDeclarations_ = false;
+  bool groupNamespaces_ = false;
+  uint32_t shards_ = 0;  // 0 generates a single file
+  std::string shardPrefix_;
+  std::string output_;  // path of the output stream, empty if unknown
+  // Shard of each module of order_, and the modules and estimated cost of each shard
+  std::vector<uint32_t> shardOf_;
+  std::vector<uint32_t> shardModules_;
+  std::vector<uint64_t> shardCost_;
+  // Modules used softly before they are generated, grouped by namespace, computed by check if hoisted
+  std::vector<IdHandle> forwardDeclarations_;
 };
 }  // namespace XMR
\ No newline at end of file
@@ -0,0 +1,266 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: GenerationCache.hpp
+ * @brief: Content addressed on disk cache of rendered modules
+ *
+ ***********************************************************/
+#pragma once
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "parsers/ContentHash.hpp"
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// 128 bit key of a cache entry, see moduleCacheKey()
+using CacheKey = unsigned __int128;
+
+// On disk cache of rendered module text keyed by a content hash. Each entry is a single file
+// named after its key that starts with the key on a line of its own, a lookup only hits if that
+// line matches so an entry is never returned for another key. Entries are written to a temp file and renamed into place so concurrent
+// generator processes sharing the directory never observe a partially written entry. Recency
+// is tracked with the file modification time, which is refreshed on every hit, and the least
+// recently used entries are removed once the directory grows past its size budget.
+class GenerationCache {
+ public:
+  static constexpr uintmax_t DEFAULT_MAX_BYTES = 256 * 1024 * 1024;
+
+  GenerationCache(const std::filesystem::path& directory, uintmax_t maxBytes = DEFAULT_MAX_BYTES) : directory_(directory), maxBytes_(maxBytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+      std::cerr << "Failed to create generation cache directory " << directory_ << ": " << ec.message() << std::endl;
+      valid_ = false;
+      return;
+    }
+    currentBytes_ = scanBytes();
+  }
+
+  bool valid() const { return valid_; }
+
+  /**
+   * Looks up a rendered module
+   * @param[in] key: Cache key of the module, see moduleCacheKey()
+   * @param[out] text: Rendered text of the module on a hit
+   * @returns true on a cache hit
+   */
+  bool lookup(CacheKey key, std::string& text) {
+    if (!valid_) return false;
+
+    std::filesystem::path entry = entryPath(key);
+    std::ifstream in(entry, std::ios::binary);
+    std::string stored;
+    if (!in.is_open() || !std::getline(in, stored) || stored != keyName(key)) {
+      misses_++;
+      return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    text = contents.str();
+
+    // Refresh recency for LRU eviction. Another worker may have evicted it meanwhile which is fine.
+    std::error_code ec;
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+    hits_++;
+    return true;
+  }
+
+  /**
+   * Atomically stores a rendered module, evicting least recently used entries if over budget
+   * @param[in] key: Cache key of the module, see moduleCacheKey()
+   * @param[in] text: Rendered text of the module
+   * @returns true if the entry was written
+   */
+  bool store(CacheKey key, const std::string& text) {
+    if (!valid_) return false;
+
+    std::ostringstream tempName;
+    tempName << ".tmp." << getpid() << "." << std::this_thread::get_id() << "." << tempCounter_++;
+    std::filesystem::path temp = directory_ / tempName.str();
+    {
+      std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+        return false;
+      }
+      out << keyName(key) << '\n' << text;
+      if (!out.good()) {
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(temp, ec);
+        return false;
+      }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, entryPath(key), ec);
+    if (ec) {
+      std::filesystem::remove(temp, ec);
+      return false;
+    }
+
+    if ((currentBytes_ += text.size() + KEY_DIGITS + 1) > maxBytes_) {
+      evict();
+    }
+    return true;
+  }
+
+  /**
+   * Removes least recently used entries until the cache is below 90% of its budget
+   */
+  void evict() {
+    std::lock_guard<std::mutex> lock(evictMutex_);
+
+    struct Entry {
+      std::filesystem::path path_;
+      std::filesystem::file_time_type lastUsed_;
+      uintmax_t size_;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (auto& file : std::filesystem::directory_iterator(directory_, ec)) {
+      if (file.path().extension() != ENTRY_EXTENSION) continue;
+      std::error_code entryEc;
+      uintmax_t size = file.file_size(entryEc);
+      std::filesystem::file_time_type lastUsed = file.last_write_time(entryEc);
+      if (entryEc) continue;  // Removed by another worker
+      entries.push_back({file.path(), lastUsed, size});
+      total += size;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed_ < b.lastUsed_; });
+
+    const uintmax_t lowWatermark = maxBytes_ / 10 * 9;
+    for (size_t i = 0; i < entries.size() && total > lowWatermark; i++) {
+      std::filesystem::remove(entries[i].path_, ec);
+      total -= entries[i].size_;
+    }
+    currentBytes_ = total;
+  }
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  static constexpr const char* ENTRY_EXTENSION = ".xmrc";
+
+  std::filesystem::path directory_;
+  uintmax_t maxBytes_;
+  bool valid_ = true;
+  std::atomic<uintmax_t> currentBytes_ = 0;
+  std::atomic<size_t> tempCounter_ = 0;
+  std::atomic<size_t> hits_ = 0;
+  std::atomic<size_t> misses_ = 0;
+  std::mutex evictMutex_;
+
+  static constexpr size_t KEY_DIGITS = 32;
+
+  static std::string keyName(CacheKey key) {
+    char name[KEY_DIGITS + 1];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", static_cast<unsigned long long>(key >> 64), static_cast<unsigned long long>(key));
+    return name;
+  }
+
+  std::filesystem::path entryPath(CacheKey key) const { return directory_ / (keyName(key) + ENTRY_EXTENSION); }
+
+  uintmax_t scanBytes() const {
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (auto& file : std::filesystem::directory_iterator(directory_, ec)) {
+      if (file.path().extension() != ENTRY_EXTENSION) continue;
+      std::error_code entryEc;
+      uintmax_t size = file.file_size(entryEc);
+      if (!entryEc) total += size;
+    }
+    return total;
+  }
+};
+
+inline void collectReferencedIds(const ModuleNode* module, std::vector<std::string>& ids) {
+  for (auto& generalization : module->generalizations_) {
+    ids.push_back(generalization);
+  }
+
+  for (auto& op : module->operators_) {
+    for (auto& param : op->params_) {
+      if (!param->type_->isPrimitive_) ids.push_back(param->type_->type_);
+    }
+    if (op->returnType_ && !op->returnType_->type_->isPrimitive_) ids.push_back(op->returnType_->type_->type_);
+  }
+
+  for (auto& attribute : module->attributes_) {
+    if (!attribute->type_->isPrimitive_) ids.push_back(attribute->type_->type_);
+  }
+
+  for (auto& nested : module->modules_) {
+    ids.push_back(nested->id_);
+    collectReferencedIds(nested, ids);
+  }
+}
+
+/**
+ * Returns the sorted, unique xmi ids a module resolves through the id name map while being
+ * rendered, including the ids resolved by its nested modules.
+ */
+inline std::vector<std::string> referencedIds(const ModuleNode* module) {
+  std::vector<std::string> ids;
+  collectReferencedIds(module, ids);
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
+
+/**
+ * Starts a cache key for a module from the generator identity, the module's id and content hash
+ * and the names of every id the module resolves. A rename of a referenced class therefore misses
+ * even though the module itself didn't change. Generators add any other state their output
+ * depends on to the returned hasher before taking the digest.
+ */
+inline WideContentHasher moduleCacheKey(const char* generatorName, const char* generatorVersion, const ModuleNode* module,
+                                        const IdIndex& idIndex) {
+  WideContentHasher hasher;
+  hasher.add(generatorName).add(generatorVersion).add(module->id_).add(module->hash_);
+
+  std::vector<std::string> ids = referencedIds(module);
+  hasher.add(ids.size());
+  for (auto& id : ids) {
+    hasher.add(id);
+    const IdHandle handle = idIndex.find(id);
+    if (handle == NO_ID) {
+      hasher.add(UINT64_MAX);
+      continue;
+    }
+    hasher.add(idIndex.scope(handle).size());
+    idIndex.scope(handle).forEach([&hasher](std::string_view name) { hasher.add(name); });
+  }
+  return hasher;
+}
+
+}  // namespace XMR
@@ -17,8 +17,13 @@
  * @brief:
  *
  ***********************************************************/
+#pragma once
+#include <generators/GenerationCache.hpp>
+#include <generators/LoweredModel.hpp>
 #include <ostream>
 #include <parsers/Node.hpp>
+#include <string>
+#include <vector>
 
 namespace XMR {
 class IGenerator {
@@ -28,15 +33,65 @@ class IGenerator {
    */
   virtual ~IGenerator() = default;
 
-  virtual bool generate(std::ostream& os, ModelNode* root) = 0;
+  virtual bool generate(std::ostream& os, const ModelNode* root) = 0;
 
   /**
-   * Checks if the model is generateble for the implementing IGenerator. This
-   * methods preprocesses the tree as needed. After this method returns true
+   * Checks if the model is generateble for the implementing IGenerator. The model
+   * is frozen and may be shared with other generators, so any preprocessing is kept
+   * in the generator, i.e. in a ModelView. After this method returns true
    * the same implementing IGenerator *should* be able to generate valued source
    * code with a subsequent call to generate. If check hasn't already been called
    * generate will call it.
    */
-  virtual bool check(ModelNode* root) = 0;
+  virtual bool check(const ModelNode* root) = 0;
+
+  /**
+   * Name and version of the generator, these key the generation cache so the version must be
+   * bumped whenever the generated output changes for the same model.
+   */
+  virtual const char* name() const = 0;
+  virtual const char* version() const = 0;
+
+  /**
+   * Sets the cache of rendered modules to check before rendering a module. The cache is
+   * not owned by the generator. nullptr disables caching.
+   */
+  virtual void setCache(GenerationCache* cache) { cache_ = cache; }
+
+  /**
+   * Restricts generation to the modules named by qualified name, i.e. Model::Pkg::Class, or
+   * below a named package, plus the modules they hard depend on. Anything else is at most
+   * forward declared. Must be called before check, an empty list generates the whole model.
+   * @returns false if the generator always generates the whole model
+   */
+  virtual bool setTargets(const std::vector<std::string>& targets) { return false; }
+
+  /**
+   * Sets an option only some generators have, i.e. the C++ forward-declarations=hoisted. Must
+   * be called before check.
+   * @returns false if the generator has no such option or the value is not one of its values
+   */
+  virtual bool setOption(const std::string& key, const std::string& value) { return false; }
+
+  /**
+   * Sets the lowered form of the model to generate from, so generators running on the same
+   * model share one. Not owned by the generator and must be lowered from the model passed to
+   * check and generate. nullptr makes a generator that needs one lower the model itself.
+   */
+  virtual void setLowered(const LoweredModel* lowered) { lowered_ = lowered; }
+
+ protected:
+  GenerationCache* cache_ = nullptr;
+  const LoweredModel* lowered_ = nullptr;
+
+  // The lowered model set for root, else one the generator lowers itself once and keeps
+  const LoweredModel& lowered(const ModelNode* root) {
+    if (lowered_ != nullptr && lowered_->model() == root) return *lowered_;
+    if (ownLowered_.model() != root) ownLowered_.lower(root);
+    return ownLowered_;
+  }
+
+ private:
+  LoweredModel ownLowered_;
 };
 }  // namespace XMR
\ No newline at end of file
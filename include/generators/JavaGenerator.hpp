@@ -29,14 +29,22 @@ class JavaGenerator : public IGenerator {
 
   ~JavaGenerator() {}
 
-  bool generate(std::ostream& os, ModelNode* root) final;
-  bool check(ModelNode* root) final {
+  bool generate(std::ostream& os, const ModelNode* root) final;
+  bool check(const ModelNode* root) final {
     //!@todo: Lucas work this
     checkCalled_ = true;
     return true;
   }
+  const char* name() const final { return "JavaGenerator"; }
+  const char* version() const final { return "3"; }
+  bool setTargets(const std::vector<std::string>& targets) final {
+    targets_ = targets;
+    return true;
+  }
 
  private:
   bool checkCalled_ = false;
+  // Qualified names to generate, all modules if empty
+  std::vector<std::string> targets_;
 };
 }  // namespace XMR
\ No newline at end of file
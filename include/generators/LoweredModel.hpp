@@ -0,0 +1,393 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: LoweredModel.hpp
+ * @brief: Resolved form of a frozen model shared by the generators
+ *
+ ***********************************************************/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// A param, attribute or return type with its reference resolved and its multiplicity decoded
+struct TypeUse {
+  const Scope* scope_ = &Scope::EMPTY;     // qualified name of the module named, empty for primitives and unknown ids
+  IdHandle handle_ = NO_ID;                // module named in the model's IdIndex
+  Primitive primitive_ = Primitive::NONE;  // NONE unless a primitive
+  bool optional_ = false;                  // lower bound 0
+  bool many_ = false;                      // upper bound unlimited
+  uint32_t extent_ = 0;                    // fixed upper bound above 1, 0 for none
+
+  bool isPrimitive() const { return primitive_ != Primitive::NONE; }
+  // Whether the use only needs the type declared, see ModuleNode's dependency lists
+  bool soft() const { return optional_ || many_; }
+};
+
+struct LoweredParam {
+  const Param* param_ = nullptr;
+  TypeUse type_;
+};
+
+struct LoweredAttribute {
+  const Attribute* attribute_ = nullptr;
+  TypeUse type_;
+};
+
+struct LoweredOperator {
+  const Operator* operator_ = nullptr;
+  uint32_t params_ = 0;  // first param in the lowered model
+  uint32_t numParams_ = 0;
+  bool hasReturn_ = false;  // the return type follows the params
+};
+
+// Everything generators look up on a frozen model, resolved once: the type every param and
+// attribute names with its primitive kind and multiplicity, the modules every module depends
+// on as id handles, and the orders modules are generated in. Generators only print from it, so
+// several generators on one model share the lookups instead of each doing them again. Modules,
+// nested ones included, are numbered in document order like the DependencyIndex numbers them.
+// Members are lowered in the order of their MemberTable, so the members of one visibility are
+// a range here too. The lowered model points into the model and lives no longer than it.
+class LoweredModel {
+ public:
+  using Index = uint32_t;
+  static constexpr Index NONE = UINT32_MAX;
+
+  struct Module {
+    const ModuleNode* module_ = nullptr;
+    IdHandle handle_ = NO_ID;
+    Index parent_ = NONE;  // NONE for an outermost module
+    uint32_t attributes_ = 0;
+    uint32_t operators_ = 0;
+    uint32_t nested_ = 0;
+    uint32_t dependencies_ = 0;  // hard dependencies then soft ones
+    uint32_t numHard_ = 0;
+    uint32_t numSoft_ = 0;
+    bool cyclic_ = false;  // part of a cycle of hard dependencies
+  };
+
+  LoweredModel() = default;
+  explicit LoweredModel(const ModelNode* model) { lower(model); }
+
+  /**
+   * Lowers a frozen model, replacing what was lowered before
+   * @param[in] model frozen model, types and generalizations resolved to handles
+   */
+  void lower(const ModelNode* model);
+
+  const ModelNode* model() const { return model_; }
+  size_t size() const { return modules_.size(); }
+  const Module& module(Index index) const { return modules_[index]; }
+
+  // NONE if the module is not part of the model
+  Index find(const ModuleNode* module) const {
+    auto found = index_.find(module);
+    return found == index_.end() ? NONE : found->second;
+  }
+
+  // Module an id handle names, NONE for ids of anything else
+  Index find(IdHandle handle) const { return handle < byHandle_.size() ? byHandle_[handle] : NONE; }
+
+  std::span<const LoweredAttribute> attributes(Index index, Visibility visibility) const {
+    return bucket(attributes_, modules_[index].attributes_, modules_[index].module_->attributes_, visibility);
+  }
+  std::span<const LoweredOperator> operators(Index index, Visibility visibility) const {
+    return bucket(operators_, modules_[index].operators_, modules_[index].module_->operators_, visibility);
+  }
+  std::span<const Index> nested(Index index, Visibility visibility) const { return bucket(nested_, modules_[index].nested_, modules_[index].module_->modules_, visibility); }
+
+  std::span<const LoweredParam> params(const LoweredOperator& op) const { return {params_.data() + op.params_, op.numParams_}; }
+  // nullptr for an operator returning nothing
+  const LoweredParam* returnType(const LoweredOperator& op) const { return op.hasReturn_ ? &params_[op.params_ + op.numParams_] : nullptr; }
+
+  // Modules the module depends on in the order of its dependency lists, ids no module of the
+  // model has are dropped
+  std::span<const IdHandle> hardDependencies(Index index) const { return {dependencies_.data() + modules_[index].dependencies_, modules_[index].numHard_}; }
+  std::span<const IdHandle> softDependencies(Index index) const {
+    return {dependencies_.data() + modules_[index].dependencies_ + modules_[index].numHard_, modules_[index].numSoft_};
+  }
+
+  // Outermost modules in document order, modules of packages first, what ModelView::flatten() gives
+  const std::vector<Index>& flattened() const { return flattened_; }
+
+  // Outermost modules ordered so each comes after the modules it hard depends on: modules without
+  // hard dependencies first, in reverse document order, then the others dependencies first.
+  // Modules of a hard cycle are adjacent and marked cyclic_.
+  const std::vector<Index>& dependencyOrder() const { return dependencyOrder_; }
+
+  // Whether any param or attribute names the primitive, for generators to include what it maps to
+  bool uses(Primitive primitive) const { return primitives_[static_cast<size_t>(primitive)]; }
+
+  // Estimated heap bytes held, the module table estimated like libstdc++ lays it out
+  uint64_t heapBytes() const {
+    uint64_t bytes = modules_.capacity() * sizeof(Module) + attributes_.capacity() * sizeof(LoweredAttribute) + operators_.capacity() * sizeof(LoweredOperator);
+    bytes += params_.capacity() * sizeof(LoweredParam) + (nested_.capacity() + flattened_.capacity() + dependencyOrder_.capacity() + byHandle_.capacity()) * sizeof(Index);
+    bytes += dependencies_.capacity() * sizeof(IdHandle);
+    bytes += index_.bucket_count() * sizeof(void*) + index_.size() * (sizeof(decltype(index_)::value_type) + sizeof(void*) + sizeof(size_t));
+    return bytes;
+  }
+
+ private:
+  const ModelNode* model_ = nullptr;
+  std::vector<Module> modules_;
+  std::vector<LoweredAttribute> attributes_;
+  std::vector<LoweredOperator> operators_;
+  std::vector<LoweredParam> params_;
+  std::vector<Index> nested_;
+  std::vector<IdHandle> dependencies_;
+  std::vector<Index> flattened_;
+  std::vector<Index> dependencyOrder_;
+  std::vector<Index> byHandle_;
+  std::unordered_map<const ModuleNode*, Index> index_;
+  std::array<bool, NUM_PRIMITIVES> primitives_{};
+
+  // Lowered members of one visibility, at the offset the members have in the module's table
+  template <typename Lowered, typename T>
+  static std::span<const Lowered> bucket(const std::vector<Lowered>& lowered, uint32_t first, const MemberTable<T>& table, Visibility visibility) {
+    std::span<T* const> members = table.of(visibility);
+    return {lowered.data() + first + (members.data() - table.all().data()), members.size()};
+  }
+
+  TypeUse lowerUse(const Type* type, bool nilable, bool unlimited, unsigned int multiplicity) {
+    TypeUse use;
+    use.primitive_ = type->primitive_;
+    primitives_[static_cast<size_t>(use.primitive_)] = true;
+    if (!type->isPrimitive_) {
+      use.handle_ = type->handle_;
+      use.scope_ = &model_->ids_.scope(type->handle_);
+    }
+    use.optional_ = nilable;
+    use.many_ = unlimited;
+    use.extent_ = !unlimited && multiplicity > 1 ? multiplicity : 0;
+    return use;
+  }
+
+  void lowerDependencies(const std::unordered_map<std::string, std::string>& list, uint32_t& count) {
+    for (auto& dependency : list) {
+      const IdHandle handle = model_->ids_.find(dependency.first);
+      if (handle == NO_ID) continue;
+      dependencies_.push_back(handle);
+      count++;
+    }
+  }
+
+  Index lowerModule(const ModuleNode* module, Index parent) {
+    const Index index = static_cast<Index>(modules_.size());
+    Module& lowered = modules_.emplace_back();
+    lowered.module_ = module;
+    lowered.handle_ = model_->ids_.find(module->id_);
+    lowered.parent_ = parent;
+    lowered.attributes_ = static_cast<uint32_t>(attributes_.size());
+    lowered.operators_ = static_cast<uint32_t>(operators_.size());
+    lowered.dependencies_ = static_cast<uint32_t>(dependencies_.size());
+    index_.emplace(module, index);
+
+    for (auto& attribute : module->attributes_) {
+      attributes_.push_back({attribute, lowerUse(attribute->type_, attribute->nilable_, attribute->unlimited_, attribute->multiplicity_)});
+    }
+    for (auto& op : module->operators_) {
+      operators_.push_back({op, static_cast<uint32_t>(params_.size()), static_cast<uint32_t>(op->params_.size()), op->returnType_ != nullptr});
+      for (auto& param : op->params_) {
+        params_.push_back({param, lowerUse(param->type_, param->nilable_, param->unlimited_, param->multiplicity_)});
+      }
+      if (op->returnType_ != nullptr) {
+        const Param* param = op->returnType_;
+        params_.push_back({param, lowerUse(param->type_, param->nilable_, param->unlimited_, param->multiplicity_)});
+      }
+    }
+    uint32_t numHard = 0;
+    uint32_t numSoft = 0;
+    lowerDependencies(module->hardDependencyList_, numHard);
+    lowerDependencies(module->softDependencyList_, numSoft);
+    modules_[index].numHard_ = numHard;
+    modules_[index].numSoft_ = numSoft;
+
+    // Nested modules are numbered below their parent, their indices are gathered once all are
+    std::vector<Index> nested;
+    nested.reserve(module->modules_.size());
+    for (auto& child : module->modules_) {
+      nested.push_back(lowerModule(child, index));
+    }
+    modules_[index].nested_ = static_cast<uint32_t>(nested_.size());
+    nested_.insert(nested_.end(), nested.begin(), nested.end());
+    return index;
+  }
+
+  // Counts what the model holds so every table is allocated once
+  void count(const ModuleNode* module, size_t& modules, size_t& attributes, size_t& operators, size_t& params) const {
+    modules++;
+    attributes += module->attributes_.size();
+    operators += module->operators_.size();
+    for (auto& op : module->operators_) {
+      params += op->params_.size() + (op->returnType_ != nullptr);
+    }
+    for (auto& nested : module->modules_) {
+      count(nested, modules, attributes, operators, params);
+    }
+  }
+
+  void count(const Package* package, size_t& modules, size_t& attributes, size_t& operators, size_t& params) const {
+    for (auto& module : package->modules_) {
+      count(module, modules, attributes, operators, params);
+    }
+    for (auto& nested : package->packages_) {
+      count(nested, modules, attributes, operators, params);
+    }
+  }
+
+  void lowerPackage(const Package* package) {
+    for (auto& module : package->modules_) {
+      flattened_.push_back(lowerModule(module, NONE));
+    }
+    for (auto& nested : package->packages_) {
+      lowerPackage(nested);
+    }
+  }
+
+  // Outermost module with hard dependencies a hard dependency leads to, NONE otherwise
+  Index hardTarget(IdHandle handle) const {
+    const Index target = find(handle);
+    if (target == NONE || modules_[target].parent_ != NONE || modules_[target].module_->hardDependencyList_.empty()) return NONE;
+    return target;
+  }
+
+  void sortDependencies();
+};
+
+inline void LoweredModel::lower(const ModelNode* model) {
+  model_ = model;
+  modules_.clear();
+  attributes_.clear();
+  operators_.clear();
+  params_.clear();
+  nested_.clear();
+  dependencies_.clear();
+  flattened_.clear();
+  dependencyOrder_.clear();
+  index_.clear();
+  primitives_.fill(false);
+
+  size_t modules = 0;
+  size_t attributes = 0;
+  size_t operators = 0;
+  size_t params = 0;
+  for (auto& package : model->packages_) {
+    count(package, modules, attributes, operators, params);
+  }
+  for (auto& module : model->modules_) {
+    count(module, modules, attributes, operators, params);
+  }
+  modules_.reserve(modules);
+  attributes_.reserve(attributes);
+  operators_.reserve(operators);
+  params_.reserve(params);
+  nested_.reserve(modules);
+  flattened_.reserve(modules);
+  dependencyOrder_.reserve(modules);
+  index_.reserve(modules);
+
+  for (auto& package : model->packages_) {
+    lowerPackage(package);
+  }
+  for (auto& module : model->modules_) {
+    flattened_.push_back(lowerModule(module, NONE));
+  }
+
+  byHandle_.assign(model->ids_.size(), NONE);
+  for (Index i = 0; i < modules_.size(); i++) {
+    if (modules_[i].handle_ != NO_ID) byHandle_[modules_[i].handle_] = i;
+  }
+  sortDependencies();
+}
+
+// Strongly connected components of the hard dependency graph (Tarjan), which come out with the
+// dependencies of a component before it. A component of more than one module, or a module
+// depending on itself, is a cycle C++ can not generate.
+inline void LoweredModel::sortDependencies() {
+  for (auto it = flattened_.rbegin(); it != flattened_.rend(); ++it) {
+    if (modules_[*it].module_->hardDependencyList_.empty()) dependencyOrder_.push_back(*it);
+  }
+
+  constexpr uint32_t UNVISITED = UINT32_MAX;
+  std::vector<uint32_t> number(modules_.size(), UNVISITED);
+  std::vector<uint32_t> low(modules_.size(), 0);
+  std::vector<char> onStack(modules_.size(), false);
+  std::vector<Index> stack;
+  struct Frame {
+    Index module_;
+    uint32_t next_;
+  };
+  std::vector<Frame> frames;
+  uint32_t counter = 0;
+
+  auto visit = [&](Index module) {
+    number[module] = low[module] = counter++;
+    stack.push_back(module);
+    onStack[module] = true;
+    frames.push_back({module, 0});
+  };
+
+  for (Index root : flattened_) {
+    if (modules_[root].module_->hardDependencyList_.empty() || number[root] != UNVISITED) continue;
+    visit(root);
+    while (!frames.empty()) {
+      Frame& frame = frames.back();
+      const Index module = frame.module_;
+      std::span<const IdHandle> dependencies = hardDependencies(module);
+      if (frame.next_ < dependencies.size()) {
+        const Index target = hardTarget(dependencies[frame.next_++]);
+        if (target == NONE) continue;
+        if (target == module) {
+          modules_[module].cyclic_ = true;
+        } else if (number[target] == UNVISITED) {
+          visit(target);
+        } else if (onStack[target]) {
+          low[module] = std::min(low[module], number[target]);
+        }
+        continue;
+      }
+
+      frames.pop_back();
+      if (!frames.empty()) {
+        const Index parent = frames.back().module_;
+        low[parent] = std::min(low[parent], low[module]);
+      }
+      if (low[module] != number[module]) continue;
+
+      const size_t first = dependencyOrder_.size();
+      Index member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        onStack[member] = false;
+        dependencyOrder_.push_back(member);
+      } while (member != module);
+      if (dependencyOrder_.size() - first > 1) {
+        for (size_t i = first; i < dependencyOrder_.size(); i++) {
+          modules_[dependencyOrder_[i]].cyclic_ = true;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace XMR
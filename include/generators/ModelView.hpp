@@ -0,0 +1,186 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ModelView.hpp
+ * @brief: Generator private ordering and annotation of a frozen model
+ *
+ ***********************************************************/
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// A generator's own view of a frozen model. The model is shared read only between generators,
+// possibly running on different threads, so any reordering, flattening or per module bookkeeping
+// a generator needs lives here instead of in the tree. Only pointers are held so building a view
+// never copies the model.
+template <typename Annotation = std::monostate>
+class ModelView {
+ public:
+  ModelView() = default;
+  explicit ModelView(const ModelNode* root) : root_(root) {}
+
+  const ModelNode* root() const { return root_; }
+
+  /**
+   * Orders the view as every module of the model in document order, modules of packages
+   * (including nested packages) first followed by the modules at the root of the model.
+   * Modules nested in other modules are left to their parent.
+   */
+  void flatten() {
+    std::vector<const ModuleNode*> modules;
+    for (auto& package : root_->packages_) {
+      flattenPackage(package, modules);
+    }
+    modules.insert(modules.end(), root_->modules_.begin(), root_->modules_.end());
+    setOrder(std::move(modules));
+  }
+
+  /**
+   * Narrows the view to the modules the targets name and the modules those hard depend on,
+   * keeping the current order. A target is a qualified name such as Model::Pkg::Class and
+   * selects the module of that name or every module below the package or model of that name.
+   * Dependencies are only followed from selected modules, a dependency on a nested module
+   * selects its outermost module in the view. Resets all annotations.
+   * @param[in] targets qualified names to keep
+   * @returns targets that named nothing in the view
+   */
+  std::vector<std::string> select(const std::vector<std::string>& targets) {
+    // Every module in the view and below it with the index of its outermost module, grouped by
+    // outermost module starting at first
+    std::unordered_map<std::string_view, size_t> owners;
+    std::vector<std::pair<const ModuleNode*, size_t>> all;
+    std::vector<size_t> first(modules_.size() + 1);
+    for (size_t i = 0; i < modules_.size(); i++) {
+      first[i] = all.size();
+      collect(modules_[i], i, all);
+    }
+    first[modules_.size()] = all.size();
+    owners.reserve(all.size());
+    for (auto& [module, owner] : all) {
+      owners.emplace(module->id_, owner);
+    }
+
+    std::vector<char> selected(modules_.size(), false);
+    std::vector<size_t> pending;
+    std::vector<std::string> unmatched;
+    for (auto& target : targets) {
+      bool matched = false;
+      for (auto& [module, owner] : all) {
+        if (!names(*module->scope_, target)) continue;
+        matched = true;
+        if (!selected[owner]) {
+          selected[owner] = true;
+          pending.push_back(owner);
+        }
+      }
+      if (!matched) unmatched.push_back(target);
+    }
+
+    while (!pending.empty()) {
+      const size_t next = pending.back();
+      pending.pop_back();
+      for (size_t i = first[next]; i < first[next + 1]; i++) {
+        for (auto& dependency : all[i].first->hardDependencyList_) {
+          auto found = owners.find(dependency.first);
+          if (found == owners.end() || selected[found->second]) continue;
+          selected[found->second] = true;
+          pending.push_back(found->second);
+        }
+      }
+    }
+
+    std::vector<const ModuleNode*> modules;
+    for (size_t i = 0; i < modules_.size(); i++) {
+      if (selected[i]) modules.push_back(modules_[i]);
+    }
+    setOrder(std::move(modules));
+    return unmatched;
+  }
+
+  /**
+   * Replaces the order of the view, resetting all annotations
+   */
+  void setOrder(std::vector<const ModuleNode*> modules) {
+    modules_ = std::move(modules);
+    annotations_.assign(modules_.size(), Annotation());
+    index_.clear();
+    index_.reserve(modules_.size());
+    for (size_t i = 0; i < modules_.size(); i++) {
+      index_.emplace(modules_[i], i);
+    }
+  }
+
+  // Resets every annotation, keeping the order
+  void clearAnnotations() { annotations_.assign(modules_.size(), Annotation()); }
+
+  const std::vector<const ModuleNode*>& modules() const { return modules_; }
+  size_t size() const { return modules_.size(); }
+  bool empty() const { return modules_.empty(); }
+  const ModuleNode* operator[](size_t i) const { return modules_[i]; }
+  auto begin() const { return modules_.begin(); }
+  auto end() const { return modules_.end(); }
+
+  bool contains(const ModuleNode* module) const { return index_.contains(module); }
+
+  Annotation& annotation(size_t i) { return annotations_[i]; }
+  const Annotation& annotation(size_t i) const { return annotations_[i]; }
+
+  // nullptr if the module is not part of the view
+  Annotation* annotation(const ModuleNode* module) {
+    auto found = index_.find(module);
+    return found == index_.end() ? nullptr : &annotations_[found->second];
+  }
+  const Annotation* annotation(const ModuleNode* module) const {
+    auto found = index_.find(module);
+    return found == index_.end() ? nullptr : &annotations_[found->second];
+  }
+
+ private:
+  const ModelNode* root_ = nullptr;
+  std::vector<const ModuleNode*> modules_;
+  std::vector<Annotation> annotations_;
+  std::unordered_map<const ModuleNode*, size_t> index_;
+
+  static void collect(const ModuleNode* module, size_t owner, std::vector<std::pair<const ModuleNode*, size_t>>& all) {
+    all.emplace_back(module, owner);
+    for (auto& nested : module->modules_) {
+      collect(nested, owner, all);
+    }
+  }
+
+  // Whether target is the qualified name of scope or of one of the scopes enclosing it
+  static bool names(const Scope& scope, std::string_view target) {
+    std::string_view name = scope.joined(Scope::CPP);
+    if (!name.starts_with(target)) return false;
+    return name.size() == target.size() || name.substr(target.size(), 2) == "::";
+  }
+
+  static void flattenPackage(const Package* package, std::vector<const ModuleNode*>& modules) {
+    modules.insert(modules.end(), package->modules_.begin(), package->modules_.end());
+    for (auto& nested : package->packages_) {
+      flattenPackage(nested, modules);
+    }
+  }
+};
+
+}  // namespace XMR
@@ -0,0 +1,38 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: SnapshotGenerator.hpp
+ * @brief: Writes the parsed model as a binary .xmrb snapshot
+ *
+ ***********************************************************/
+#pragma once
+#include "generators/IGenerator.hpp"
+
+namespace XMR {
+
+// Rather than source code this generator writes the XMR tree itself in the snapshot format so
+// later runs can load it with the SnapshotParser instead of parsing the XMI again.
+class SnapshotGenerator : public IGenerator {
+ public:
+  SnapshotGenerator() {}
+
+  ~SnapshotGenerator() {}
+
+  bool generate(std::ostream& os, const ModelNode* root) final;
+  bool check(const ModelNode* root) final { return root != nullptr; }
+  const char* name() const final { return "SnapshotGenerator"; }
+  const char* version() const final { return "1"; }
+};
+}  // namespace XMR
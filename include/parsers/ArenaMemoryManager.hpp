@@ -0,0 +1,122 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ArenaMemoryManager.hpp
+ * @brief: Monotonic arena Xerces memory manager for per document allocations
+ *
+ ***********************************************************/
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "parsers/MemoryStats.hpp"
+#include "xercesc/framework/MemoryManager.hpp"
+#include "xercesc/util/PlatformUtils.hpp"
+
+namespace XMR {
+
+// Hands out memory by bumping a pointer through large blocks and ignores deallocate, so building
+// a DOM costs a handful of mallocs and throwing it away is a single reset. Everything allocated
+// from the arena dies with reset(), only per document data such as the DOM, the parser scanning
+// it and scratch transcodes may live here. Not thread safe, one arena per parser.
+class ArenaMemoryManager : public xercesc::MemoryManager {
+ public:
+  explicit ArenaMemoryManager(size_t blockSize = 1 << 20) : blockSize_(blockSize) {}
+
+  ~ArenaMemoryManager() {
+    for (auto& block : blocks_) ::operator delete(block.memory_);
+  }
+
+  ArenaMemoryManager(const ArenaMemoryManager&) = delete;
+  ArenaMemoryManager& operator=(const ArenaMemoryManager&) = delete;
+
+  void* allocate(XMLSize_t size) override {
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if (current_ == blocks_.size() || blocks_[current_].used_ + size > blocks_[current_].size_) {
+      nextBlock(size);
+    }
+    Block& block = blocks_[current_];
+    void* memory = block.memory_ + block.used_;
+    block.used_ += size;
+    stats_.allocations_++;
+    stats_.bytes_ += size;
+    return memory;
+  }
+
+  // Memory is only ever released all at once by reset()
+  void deallocate(void*) override {}
+
+  // Exceptions can outlive the document that raised them
+  xercesc::MemoryManager* getExceptionMemoryManager() override { return xercesc::XMLPlatformUtils::fgMemoryManager; }
+
+  /**
+   * Releases everything allocated since the last reset. The first standard sized block is kept
+   * for the next document, oversized blocks are returned to the heap.
+   */
+  void reset() {
+    size_t kept = 0;
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      if (kept == 0 && blocks_[i].size_ == blockSize_) {
+        blocks_[i].used_ = 0;
+        std::swap(blocks_[0], blocks_[i]);
+        kept = 1;
+      }
+    }
+    for (size_t i = kept; i < blocks_.size(); i++) {
+      ::operator delete(blocks_[i].memory_);
+      stats_.liveBytes_ -= blocks_[i].size_;
+    }
+    blocks_.resize(kept);
+    current_ = 0;
+  }
+
+  // Live bytes are the blocks held, not what was handed out of them
+  const MemoryStats& stats() const { return stats_; }
+
+ private:
+  static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+  struct Block {
+    char* memory_;
+    size_t size_;
+    size_t used_;
+  };
+
+  // Moves on to the next empty block, allocating one if needed. Requests larger than a block get
+  // a block of their own.
+  void nextBlock(size_t size) {
+    if (current_ + 1 < blocks_.size() && blocks_[current_ + 1].size_ >= size) {
+      current_++;
+      return;
+    }
+    if (current_ < blocks_.size() && blocks_[current_].used_ == 0 && blocks_[current_].size_ >= size) {
+      return;
+    }
+    const size_t blockSize = size > blockSize_ ? size : blockSize_;
+    Block block{static_cast<char*>(::operator new(blockSize)), blockSize, 0};
+    current_ = blocks_.empty() ? 0 : current_ + 1;
+    blocks_.insert(blocks_.begin() + current_, block);
+    stats_.liveBytes_ += blockSize;
+    if (stats_.liveBytes_ > stats_.peakLiveBytes_) stats_.peakLiveBytes_ = stats_.liveBytes_;
+  }
+
+  size_t blockSize_;
+  std::vector<Block> blocks_;
+  size_t current_ = 0;
+  MemoryStats stats_;
+};
+
+}  // namespace XMR
@@ -0,0 +1,108 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ContentHash.hpp
+ * @brief: Stable content hashing of XMR tree nodes
+ *
+ ***********************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace XMR {
+
+// FNV-1a offset basis and prime by state width
+template <typename State>
+struct FnvParameters;
+
+template <>
+struct FnvParameters<uint64_t> {
+  static constexpr uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+  static constexpr uint64_t PRIME = 1099511628211ULL;
+};
+
+template <>
+struct FnvParameters<unsigned __int128> {
+  static constexpr unsigned __int128 OFFSET_BASIS = (static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) | 0x62b821756295c58dULL;
+  static constexpr unsigned __int128 PRIME = (static_cast<unsigned __int128>(0x0000000001000000ULL) << 64) | 0x000000000000013bULL;
+};
+
+// FNV-1a hasher used to fingerprint subtrees of the XMR tree.
+// std::hash is not guaranteed to be the same between runs or standard library
+// implementations, so it can't be persisted or compared between two parses of
+// a model. Every value is length or type prefixed so that adjacent fields can't
+// alias each other, i.e. ("ab", "c") and ("a", "bc") hash differently.
+template <typename State>
+class BasicContentHasher {
+ public:
+  static constexpr State OFFSET_BASIS = FnvParameters<State>::OFFSET_BASIS;
+  static constexpr State PRIME = FnvParameters<State>::PRIME;
+
+  BasicContentHasher& addBytes(const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) {
+      state_ ^= bytes[i];
+      state_ *= PRIME;
+    }
+    return *this;
+  }
+
+  template <typename T>
+    requires std::is_integral_v<T> || std::is_enum_v<T>
+  BasicContentHasher& add(T value) {
+    uint64_t widened = static_cast<uint64_t>(value);
+    return addBytes(&widened, sizeof(widened));
+  }
+
+  // A null string is hashed differently from an empty one
+  BasicContentHasher& add(const char* str) {
+    if (str == nullptr) {
+      return add(UINT64_MAX);
+    }
+    size_t length = std::strlen(str);
+    add(length);
+    return addBytes(str, length);
+  }
+
+  BasicContentHasher& add(char* str) { return add(static_cast<const char*>(str)); }
+
+  BasicContentHasher& add(const std::string& str) {
+    add(str.size());
+    return addBytes(str.data(), str.size());
+  }
+
+  BasicContentHasher& add(std::string_view str) {
+    add(str.size());
+    return addBytes(str.data(), str.size());
+  }
+
+  State digest() const { return state_; }
+
+ private:
+  State state_ = OFFSET_BASIS;
+};
+
+// 64 bit hashes of the tree, compared within a process or between two parses of a model
+using ContentHasher = BasicContentHasher<uint64_t>;
+
+// 128 bit hashes for keys shared between machines, i.e. a generation cache used by many CI jobs,
+// where a 64 bit collision is too likely to be left unchecked
+using WideContentHasher = BasicContentHasher<unsigned __int128>;
+
+}  // namespace XMR
@@ -0,0 +1,99 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: FastXmiParser.hpp
+ * @brief: Papyrus XMI parser over a SIMD pull tokenizer, without a DOM
+ *
+ ***********************************************************/
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parsers/IParser.hpp"
+#include "parsers/XmiTokenizer.hpp"
+
+namespace XMR {
+
+// Builds the same tree as PapyrusParser in a single pass over the mapped file. Names are not
+// copied, they point at attribute values decoded in place in the mapping, which the returned
+// model keeps alive through its storage. UTF-8 documents are parsed as they are, UTF-16 ones are
+// transcoded to UTF-8 up front. There is no validation against the UML schema.
+class FastXmiParser : public IParser {
+  // Mapped document, ownership moves to the returned model
+  std::shared_ptr<void> mapping_;
+  char* begin_ = nullptr;
+  char* end_ = nullptr;
+  XmiTokenizer tokenizer_{nullptr, nullptr};
+  // Absent attributes read as this empty string, the same as DOMElement::getAttribute. Nothing
+  // writes through model names so one per model is enough, it moves to the model with the mapping.
+  std::shared_ptr<char[]> empty_;
+
+  // Same values and order as PapyrusParser so diagnostics print the same ids
+  enum UmlType { PACKAGE, PACKAGE_IMPORT, CLASS, INTERACTION, ASSOCIATION, PROPERTY, OPERATION, PRIMITIVE, GENERALIZATION };
+
+  // What PapyrusParser looks up among an element's descendants
+  struct TypedElement {
+    bool hasTypeElement_ = false;
+    char* typeHref_ = nullptr;  // href of the first <type> descendant
+    size_t lowerCount_ = 0;
+    char* lowerValue_ = nullptr;
+    size_t upperCount_ = 0;
+    char* upperValue_ = nullptr;
+  };
+
+  IdIndex ids_;
+  std::shared_ptr<ScopeTree> scopes_;
+  std::shared_ptr<TypeTable> types_;
+  const Scope* currentScope_ = nullptr;
+
+  static UmlType umlType(const char* type);
+  static Visibility visibility(const char* visibility);
+
+  // Attribute of the current start tag, "" if absent as with a DOM
+  char* attribute(const char* name) const;
+  bool tokenizerError();
+  bool transcodeDocument();
+
+  ModelNode* parseModel();
+  Package* parsePackage();
+  ModuleNode* parseModule();
+  Operator* parseOperator();
+  Attribute* parseAttribute();
+  Param* parseParam(char* operatorName, bool& isReturn);
+  bool readTypedElement(TypedElement& element);
+
+  /**
+   * Applies lowerValue and upperValue the way PapyrusParser does
+   *
+   * @param[out] node param or attribute to set multiplicity on
+   * @param[in] element bounds read from the node's element
+   * @param[in] kind what the node is, for diagnostics
+   * @returns false if the element has more than one bound of a kind
+   */
+  template <typename T>
+  static bool applyBounds(T* node, const TypedElement& element, const char* kind);
+
+ public:
+  FastXmiParser() = default;
+
+  ~FastXmiParser() = default;
+
+  bool setInputFile(const char* fileName) final;
+
+  ModelNode* parse() final;
+};
+
+}  // namespace XMR
@@ -17,8 +17,10 @@
  * @brief:
  *
  ***********************************************************/
+#pragma once
 #include <string>
 
+#include "parsers/MemoryStats.hpp"
 #include "parsers/Node.hpp"
 
 namespace XMR {
@@ -40,6 +42,21 @@ class IParser {
    * @returns true if file was able to be opened, false otherwise
    */
   virtual bool setInputFile(const char* fileName) = 0;
+
+  /**
+   * Memory the parser's backend allocated outside of the model, such as a DOM
+   * @param[out] stats: Counters since the backend was initialized
+   * @returns false if the parser does not track its memory
+   */
+  virtual bool memoryStats(MemoryStats& stats) const { return false; }
+
+  /**
+   * Lets the parser spread one parse over several threads, the model it returns is the same
+   * whatever the thread count
+   * @param[in] threads: Threads to use, 1 parses on the calling thread only
+   * @returns false if the parser only ever parses on the calling thread
+   */
+  virtual bool setParallelism(unsigned threads) { return false; }
 };
 
 }  // namespace XMR
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: IdIndex.hpp
+ * @brief: Model owned index from xmi ids to dense handles
+ *
+ ***********************************************************/
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "parsers/ScopeTree.hpp"
+
+namespace XMR {
+
+class ModuleNode;
+
+// Dense handle of an id in an IdIndex
+using IdHandle = uint32_t;
+constexpr IdHandle NO_ID = UINT32_MAX;
+
+// Maps the xmi id of every module a model can name to a handle, from which the id, the qualified
+// name and the module are an array access away. Ids are hashed once, when added or looked up by
+// text, the tree keeps the handles its types resolve to so generators never hash them again.
+// Ids and names are not copied, they point into the modules and the model's scopes. The index
+// belongs to its model and is only ever moved.
+class IdIndex {
+ public:
+  struct Entry {
+    const char* id_ = nullptr;
+    const Scope* scope_ = &Scope::EMPTY;  // qualified name, the module inclusive
+    const ModuleNode* module_ = nullptr;               // nullptr until known, i.e. ids of a snapshot
+  };
+
+  IdIndex() = default;
+  IdIndex(const IdIndex&) = delete;
+  IdIndex& operator=(const IdIndex&) = delete;
+  IdIndex(IdIndex&&) = default;
+  IdIndex& operator=(IdIndex&&) = default;
+
+  /**
+   * Adds an id, a later add of the same id takes its handle over as parsers let the last
+   * element with an id win
+   * @param[in] id xmi id, must live as long as the model
+   * @param[in] scope qualified name, must live as long as the model
+   * @param[in] module module with the id if there is one in memory
+   * @returns handle of the id
+   */
+  IdHandle add(const char* id, const Scope* scope, const ModuleNode* module = nullptr) {
+    auto [found, inserted] = handles_.try_emplace(id, static_cast<IdHandle>(entries_.size()));
+    if (inserted) {
+      entries_.push_back(Entry{id, scope, module});
+    } else {
+      entries_[found->second] = Entry{id, scope, module};
+    }
+    return found->second;
+  }
+
+  // Adds a module under its own id and qualified name
+  template <typename Module>
+  IdHandle add(const Module* module) {
+    return add(module->id_, module->scope_, module);
+  }
+
+  // Sets the module of an id added without one, the module must have the id
+  template <typename Module>
+  void link(IdHandle handle, const Module* module) {
+    entries_[handle].module_ = module;
+  }
+
+  // NO_ID if the id is not in the index
+  IdHandle find(std::string_view id) const {
+    auto found = handles_.find(id);
+    return found == handles_.end() ? NO_ID : found->second;
+  }
+
+  bool contains(std::string_view id) const { return handles_.contains(id); }
+
+  const Entry& entry(IdHandle handle) const { return entries_[handle]; }
+  const char* id(IdHandle handle) const { return entries_[handle].id_; }
+  const ModuleNode* module(IdHandle handle) const { return handle == NO_ID ? nullptr : entries_[handle].module_; }
+
+  // Qualified name of the id, empty for NO_ID like a lookup of an unknown id in a map
+  const Scope& scope(IdHandle handle) const { return handle == NO_ID ? Scope::EMPTY : *entries_[handle].scope_; }
+  const Scope& scope(std::string_view id) const { return scope(find(id)); }
+
+  size_t size() const { return entries_.size(); }
+  std::span<const Entry> entries() const { return entries_; }
+
+  void reserve(size_t size) {
+    entries_.reserve(size);
+    handles_.reserve(size);
+  }
+
+  // Estimated heap bytes held, the hash table estimated like libstdc++ lays it out
+  uint64_t heapBytes() const {
+    uint64_t bytes = entries_.capacity() * sizeof(Entry);
+    bytes += handles_.bucket_count() * sizeof(void*) + handles_.size() * (sizeof(decltype(handles_)::value_type) + sizeof(void*) + sizeof(size_t));
+    return bytes;
+  }
+
+  // Same ids with the same qualified names, handles may differ
+  bool sameIds(const IdIndex& other) const {
+    if (size() != other.size()) return false;
+    for (auto& entry : entries_) {
+      const IdHandle handle = other.find(entry.id_);
+      if (handle == NO_ID || other.scope(handle) != *entry.scope_) return false;
+    }
+    return true;
+  }
+
+ private:
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string_view, IdHandle> handles_;  // keys point at the entries' ids
+};
+
+}  // namespace XMR
@@ -0,0 +1,32 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: MemoryStats.hpp
+ * @brief: Memory counters reported by parsers for --stats
+ *
+ ***********************************************************/
+#pragma once
+#include <cstdint>
+
+namespace XMR {
+
+struct MemoryStats {
+  uint64_t allocations_ = 0;
+  uint64_t bytes_ = 0;  // total requested, including memory already released
+  uint64_t liveBytes_ = 0;
+  uint64_t peakLiveBytes_ = 0;
+};
+
+}  // namespace XMR
@@ -0,0 +1,103 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ModelDiff.hpp
+ * @brief: Diff two parsed models by module content hash
+ *
+ ***********************************************************/
+#pragma once
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// Result of diffing two versions of a model. All lists hold xmi ids of modules and are sorted.
+struct ModelDiff {
+  std::vector<std::string> added_;    // in the new model only
+  std::vector<std::string> removed_;  // in the old model only
+  std::vector<std::string> changed_;  // in both models but with a different content hash
+
+  bool empty() const { return added_.empty() && removed_.empty() && changed_.empty(); }
+};
+
+inline void collectModuleHashes(const ModuleNode* module, std::unordered_map<std::string, uint64_t>& hashes) {
+  hashes[module->id_] = module->hash_;
+  for (auto& nested : module->modules_) {
+    collectModuleHashes(nested, hashes);
+  }
+}
+
+inline void collectModuleHashes(const Package* package, std::unordered_map<std::string, uint64_t>& hashes) {
+  for (auto& nested : package->packages_) {
+    collectModuleHashes(nested, hashes);
+  }
+  for (auto& module : package->modules_) {
+    collectModuleHashes(module, hashes);
+  }
+}
+
+/**
+ * Collects the content hash of every module in the model keyed by xmi id, including modules
+ * nested in packages and in other modules.
+ */
+inline std::unordered_map<std::string, uint64_t> collectModuleHashes(const ModelNode* model) {
+  std::unordered_map<std::string, uint64_t> hashes;
+  for (auto& package : model->packages_) {
+    collectModuleHashes(package, hashes);
+  }
+  for (auto& module : model->modules_) {
+    collectModuleHashes(module, hashes);
+  }
+  return hashes;
+}
+
+/**
+ * Diffs two parsed versions of a model by module content hash. A module whose nested module changed
+ * is reported as changed as well since its hash covers the nested module.
+ * @param[in] before: Previous version of the model
+ * @param[in] after: Current version of the model
+ * @returns the added, removed and changed module ids
+ */
+inline ModelDiff diffModels(const ModelNode* before, const ModelNode* after) {
+  ModelDiff diff;
+  std::unordered_map<std::string, uint64_t> beforeHashes = collectModuleHashes(before);
+  std::unordered_map<std::string, uint64_t> afterHashes = collectModuleHashes(after);
+
+  for (auto& pair : afterHashes) {
+    auto found = beforeHashes.find(pair.first);
+    if (found == beforeHashes.end()) {
+      diff.added_.push_back(pair.first);
+    } else if (found->second != pair.second) {
+      diff.changed_.push_back(pair.first);
+    }
+  }
+
+  for (auto& pair : beforeHashes) {
+    if (!afterHashes.contains(pair.first)) {
+      diff.removed_.push_back(pair.first);
+    }
+  }
+
+  std::sort(diff.added_.begin(), diff.added_.end());
+  std::sort(diff.removed_.begin(), diff.removed_.end());
+  std::sort(diff.changed_.begin(), diff.changed_.end());
+  return diff;
+}
+
+}  // namespace XMR
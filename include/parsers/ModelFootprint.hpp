@@ -0,0 +1,151 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ModelFootprint.hpp
+ * @brief: Per node kind memory accounting of a parsed model
+ *
+ ***********************************************************/
+#pragma once
+#include <array>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// Estimated heap bytes held by a model tree, split by what holds them. Node kinds count the
+// node objects and their own containers, the string categories count the text they refer to.
+// Estimates follow libstdc++: short strings are stored inline, hash nodes cache their hash.
+struct ModelFootprint {
+  enum Kind { MODEL, PACKAGE, MODULE, OPERATOR, ATTRIBUTE, PARAM, TYPE, NAMES, QUALIFIED_NAMES, DEPENDENCIES, ID_INDEX, DEPENDENCY_INDEX, NUM_KINDS };
+
+  static constexpr const char* KIND_NAMES[NUM_KINDS] = {"model", "package", "module", "operator", "attribute", "param", "type", "names", "qualified names", "dependencies", "id index", "dependency index"};
+
+  struct Usage {
+    uint64_t count_ = 0;
+    uint64_t bytes_ = 0;
+  };
+
+  std::array<Usage, NUM_KINDS> usage_{};
+
+  uint64_t totalBytes() const {
+    uint64_t total = 0;
+    for (auto& usage : usage_) total += usage.bytes_;
+    return total;
+  }
+
+  static ModelFootprint of(const ModelNode* model) {
+    ModelFootprint footprint;
+    footprint.addModel(model);
+    return footprint;
+  }
+
+ private:
+  void add(Kind kind, uint64_t bytes, uint64_t count = 1) {
+    usage_[kind].count_ += count;
+    usage_[kind].bytes_ += bytes;
+  }
+
+  static uint64_t heapBytes(const std::string& string) { return string.capacity() > 15 ? string.capacity() + 1 : 0; }
+
+  template <typename T>
+  static uint64_t heapBytes(const std::vector<T>& vector) {
+    return vector.capacity() * sizeof(T);
+  }
+
+  template <typename T>
+  static uint64_t heapBytes(const MemberTable<T>& table) {
+    return table.capacity() * sizeof(T*);
+  }
+
+  template <typename Map>
+  static uint64_t tableBytes(const Map& map) {
+    return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + sizeof(void*) + sizeof(size_t));
+  }
+
+  void addName(const char* name) {
+    if (name != nullptr) add(NAMES, std::strlen(name) + 1);
+  }
+
+  void addDependencies(const std::unordered_map<std::string, std::string>& dependencies) {
+    uint64_t bytes = tableBytes(dependencies);
+    for (auto& dependency : dependencies) bytes += heapBytes(dependency.first) + heapBytes(dependency.second);
+    add(DEPENDENCIES, bytes, dependencies.size());
+  }
+
+  void addParam(const Param* param) {
+    add(PARAM, sizeof(Param));
+    addName(param->name_);
+    addName(param->id_);
+  }
+
+  void addOperator(const Operator* op) {
+    add(OPERATOR, sizeof(Operator) + heapBytes(op->params_));
+    addName(op->name_);
+    addName(op->id_);
+    for (auto& param : op->params_) addParam(param);
+    if (op->returnType_ != nullptr) addParam(op->returnType_);
+  }
+
+  void addAttribute(const Attribute* attribute) {
+    add(ATTRIBUTE, sizeof(Attribute));
+    addName(attribute->name_);
+    addName(attribute->id_);
+  }
+
+  void addModule(const ModuleNode* module) {
+    uint64_t bytes = sizeof(ModuleNode) + heapBytes(module->generalizations_);
+    bytes += heapBytes(module->modules_) + heapBytes(module->operators_) + heapBytes(module->attributes_);
+    add(MODULE, bytes);
+
+    addName(module->name_);
+    addName(module->id_);
+    for (auto& generalization : module->generalizations_) addName(generalization);
+    addDependencies(module->softDependencyList_);
+    addDependencies(module->hardDependencyList_);
+
+    for (auto& nested : module->modules_) addModule(nested);
+    for (auto& op : module->operators_) addOperator(op);
+    for (auto& attribute : module->attributes_) addAttribute(attribute);
+  }
+
+  void addPackage(const Package* package) {
+    add(PACKAGE, sizeof(Package) + heapBytes(package->packages_) + heapBytes(package->modules_) + heapBytes(package->relationships_));
+    addName(package->name_);
+    addName(package->id_);
+    for (auto& nested : package->packages_) addPackage(nested);
+    for (auto& module : package->modules_) addModule(module);
+  }
+
+  void addModel(const ModelNode* model) {
+    add(MODEL, sizeof(ModelNode) + heapBytes(model->packageImports_) + heapBytes(model->packages_) + heapBytes(model->modules_) + heapBytes(model->relationships_));
+    addName(model->name_);
+    addName(model->id_);
+    for (auto& package : model->packages_) addPackage(package);
+    for (auto& module : model->modules_) addModule(module);
+
+    // Qualified names are shared, the scope tree holds them all once
+    if (model->scopes_ != nullptr) add(QUALIFIED_NAMES, model->scopes_->heapBytes(), model->scopes_->size());
+    // So are types, the table holds each distinct one with its reference
+    if (model->types_ != nullptr) add(TYPE, model->types_->heapBytes(), model->types_->size());
+    add(ID_INDEX, model->ids_.heapBytes(), model->ids_.size());
+    add(DEPENDENCY_INDEX, model->dependencyIndex_.heapBytes(), model->dependencyIndex_.size());
+  }
+};
+
+}  // namespace XMR
@@ -0,0 +1,406 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ModelSet.hpp
+ * @brief: Several XMI resources loaded into one id resolution space
+ *
+ ***********************************************************/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "parsers/IParser.hpp"
+
+namespace XMR {
+
+// Ids of every resource of a ModelSet, filled from several loader threads at once. Sharded so
+// loaders finishing together rarely wait on each other. When more than one resource defines an
+// id the resource given first wins, whatever order the loads finished in.
+class SharedIdIndex {
+ public:
+  struct Entry {
+    size_t resource_ = 0;
+    const Scope* scope_ = nullptr;  // points into the defining model
+  };
+
+  /**
+   * Adds every id of a model, the model must outlive the index and its ids must not change
+   * @param[in] resource index of the model in its set
+   * @param[in] model parsed model of the resource
+   * @returns number of ids some other resource defines too
+   */
+  size_t insert(size_t resource, const ModelNode* model) {
+    size_t duplicates = 0;
+    for (auto& entry : model->ids_.entries()) {
+      Shard& shard = shardOf(entry.id_);
+      std::lock_guard<std::mutex> lock(shard.mutex_);
+      auto [found, inserted] = shard.ids_.try_emplace(entry.id_, Entry{resource, entry.scope_});
+      if (inserted) continue;
+      duplicates++;
+      if (resource < found->second.resource_) found->second = Entry{resource, entry.scope_};
+    }
+    return duplicates;
+  }
+
+  // false if no resource defines the id
+  bool find(std::string_view id, Entry& entry) const {
+    const Shard& shard = shardOf(id);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    auto found = shard.ids_.find(id);
+    if (found == shard.ids_.end()) return false;
+    entry = found->second;
+    return true;
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex_);
+      size += shard.ids_.size();
+    }
+    return size;
+  }
+
+ private:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  struct Shard {
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string_view, Entry> ids_;  // keys point into the models
+  };
+
+  Shard& shardOf(std::string_view id) { return shards_[std::hash<std::string_view>()(id) % NUM_SHARDS]; }
+  const Shard& shardOf(std::string_view id) const { return shards_[std::hash<std::string_view>()(id) % NUM_SHARDS]; }
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+// Loads several XMI resources with one parser plugin and resolves the references between them.
+// The resources given are parsed in parallel, then every resource another one references through
+// an href (<type href="Common.uml#_id"/>) is loaded as a library, once however many resources
+// reference it. Types referring to elements of other resources are then pointed at the element's
+// id like a type of the same document, so generators see one model through combine().
+//
+// Nodes are shared between the set's models and the combined model, none of them are freed.
+class ModelSet {
+ public:
+  struct Resource {
+    std::filesystem::path path_;
+    ModelNode* model_ = nullptr;
+    bool library_ = false;  // only loaded because another resource references it
+  };
+
+  // What a loader thread is about to do, so callers can attribute allocations
+  enum Stage { LOAD, BUILD };
+
+  ModelSet(IParser* (*create)(), void (*destroy)(IParser*)) : create_(create), destroy_(destroy) {}
+
+  ModelSet(const ModelSet&) = delete;
+  ModelSet& operator=(const ModelSet&) = delete;
+
+  // Resources parsed at once, parsers that can split a document get the threads left over
+  void setParallelism(unsigned threads) { threads_ = std::max(1u, threads); }
+
+  // Called on the loader thread before a resource is loaded and before its tree is built
+  void setStageHook(void (*hook)(Stage)) { stageHook_ = hook; }
+
+  /**
+   * Parses the given files, loads the libraries they reference and resolves references
+   * across all of them
+   * @param[in] files resources to generate from, a file given twice is loaded once
+   * @returns false if one of the files could not be parsed, missing libraries only leave their
+   * references unresolved
+   */
+  bool parseAll(const std::vector<std::string>& files) {
+    for (auto& file : files) {
+      addResource(std::filesystem::weakly_canonical(file), false);
+    }
+    if (resources_.empty() || !load(0)) return false;
+
+    // Libraries may reference further libraries, scan until every referenced resource is loaded
+    for (size_t scanned = 0; scanned < resources_.size();) {
+      const size_t loaded = resources_.size();
+      for (; scanned < loaded; scanned++) {
+        collectReferences(scanned);
+      }
+      if (resources_.size() > loaded) load(loaded);
+    }
+
+    forEachResource([this](size_t resource) { resolve(resource); });
+
+    if (duplicates_ > 0) {
+      std::cerr << duplicates_ << " ids are defined by more than one resource, the first resource given wins" << std::endl;
+    }
+    if (unresolved_ > 0) {
+      std::cerr << unresolved_ << " references to other resources could not be resolved" << std::endl;
+    }
+    return true;
+  }
+
+  /**
+   * Builds the model generators run on. A set of one resource is that resource's model, otherwise
+   * the packages and modules of every resource given to parseAll are gathered under a model
+   * named after the first one, libraries only contribute their ids.
+   * @returns nullptr if nothing was parsed
+   */
+  ModelNode* combine() const {
+    if (resources_.empty() || resources_[0].model_ == nullptr) return nullptr;
+    if (resources_.size() == 1) return resources_[0].model_;
+
+    const ModelNode* first = resources_[0].model_;
+    ModelNode* root = new ModelNode(first->name_, first->id_, first->scope_);
+    root->scopes_ = first->scopes_;
+    root->types_ = first->types_;
+    auto storage = std::make_shared<std::vector<std::shared_ptr<void>>>();
+    for (auto& resource : resources_) {
+      ModelNode* model = resource.model_;
+      if (model == nullptr) continue;
+      storage->push_back(model->storage_);
+      storage->push_back(model->scopes_);
+      storage->push_back(model->types_);
+      for (auto& entry : model->ids_.entries()) {
+        if (!root->ids_.contains(entry.id_)) root->ids_.add(entry.id_, entry.scope_, entry.module_);
+      }
+      if (resource.library_) continue;
+      for (auto& packageImport : model->packageImports_) root->addPackageImport(packageImport);
+      for (auto& package : model->packages_) root->addPackage(package);
+      for (auto& module : model->modules_) root->addModule(module);
+      for (auto& relationship : model->relationships_) root->addRelationship(relationship);
+    }
+    root->storage_ = std::move(storage);
+    return root;
+  }
+
+  const std::vector<Resource>& resources() const { return resources_; }
+  const SharedIdIndex& ids() const { return ids_; }
+  size_t unresolved() const { return unresolved_; }
+
+  // Only known for a set of one resource, parsers report counters of their whole backend
+  bool memoryStats(MemoryStats& stats) const {
+    stats = stats_;
+    return hasStats_;
+  }
+
+ private:
+  IParser* (*create_)();
+  void (*destroy_)(IParser*);
+  void (*stageHook_)(Stage) = nullptr;
+  unsigned threads_ = 1;
+
+  std::vector<Resource> resources_;
+  std::unordered_map<std::string, size_t> loaded_;  // canonical path to resource
+  std::unordered_set<std::string> missing_;         // referenced but not on disk, reported once
+  SharedIdIndex ids_;
+  std::atomic<size_t> duplicates_{0};
+  std::atomic<size_t> unresolved_{0};
+  MemoryStats stats_;
+  bool hasStats_ = false;
+
+  // How a type is used by its module, which decides the dependency it becomes once resolved
+  enum Use { RETURN, SOFT, HARD };
+
+  void addResource(const std::filesystem::path& path, bool library) {
+    if (!loaded_.emplace(path.string(), resources_.size()).second) return;
+    resources_.push_back(Resource{path, nullptr, library});
+  }
+
+  // Runs f for every resource, spread over the set's threads
+  void forEachResource(const std::function<void(size_t)>& f) {
+    const size_t workers = std::min<size_t>(threads_, resources_.size());
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+      for (size_t i = next++; i < resources_.size(); i = next++) f(i);
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++) threads.emplace_back(work);
+    work();
+    for (auto& thread : threads) thread.join();
+  }
+
+  /**
+   * Parses resources from first on, each loader thread with a parser of its own
+   * @returns false if a resource given to parseAll failed
+   */
+  bool load(size_t first) {
+    const size_t workers = std::min<size_t>(threads_, resources_.size() - first);
+    // Parsers are created and destroyed on this thread, Xerces backed ones initialize and
+    // terminate the platform which is not thread safe
+    std::vector<IParser*> parsers(workers);
+    for (auto& parser : parsers) {
+      parser = create_();
+      parser->setParallelism(threads_ / workers);
+    }
+
+    std::atomic<size_t> next{first};
+    std::atomic<bool> failed{false};
+    auto work = [&](IParser* parser) {
+      for (size_t i = next++; i < resources_.size(); i = next++) {
+        Resource& resource = resources_[i];
+        if (stageHook_ != nullptr) stageHook_(LOAD);
+        if (!parser->setInputFile(resource.path_.c_str())) {
+          std::cerr << "Failed to load " << resource.path_.string() << std::endl;
+          if (!resource.library_) failed = true;
+          continue;
+        }
+        if (stageHook_ != nullptr) stageHook_(BUILD);
+        resource.model_ = parser->parse();
+        if (resource.model_ == nullptr) {
+          std::cerr << "Failed to parse " << resource.path_.string() << std::endl;
+          if (!resource.library_) failed = true;
+          continue;
+        }
+        duplicates_ += ids_.insert(i, resource.model_);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; i++) threads.emplace_back(work, parsers[i]);
+    work(parsers[0]);
+    for (auto& thread : threads) thread.join();
+
+    hasStats_ = resources_.size() == 1 && parsers[0]->memoryStats(stats_);
+    for (auto& parser : parsers) destroy_(parser);
+    return !failed;
+  }
+
+  /**
+   * Splits an href to an element of another resource, i.e. Common.uml#_x1, into the resource's
+   * path and the element id. Hrefs with a scheme, such as the pathmap:// ones of the UML primitive
+   * types, do not name resources of the set.
+   * @param[in] href reference as parsed
+   * @param[in] from resource the reference is in, relative paths start from its directory
+   * @param[out] path canonical path of the referenced resource
+   * @param[out] id element id, points into href
+   * @returns false if href does not reference a resource of the set
+   */
+  static bool splitReference(const char* href, const std::filesystem::path& from, std::filesystem::path& path, const char*& id) {
+    const char* hash = std::strchr(href, '#');
+    if (hash == nullptr || hash[1] == '\0') return false;
+    const std::string_view resource(href, hash - href);
+    const size_t colon = resource.find(':');
+    if (colon != std::string_view::npos && colon < resource.find('/')) return false;
+
+    // Papyrus escapes hrefs like URIs
+    std::string decoded;
+    for (size_t i = 0; i < resource.size(); i++) {
+      if (resource[i] == '%' && i + 2 < resource.size() && std::isxdigit(static_cast<unsigned char>(resource[i + 1])) && std::isxdigit(static_cast<unsigned char>(resource[i + 2]))) {
+        decoded += static_cast<char>(std::stoi(std::string(resource.substr(i + 1, 2)), nullptr, 16));
+        i += 2;
+      } else {
+        decoded += resource[i];
+      }
+    }
+    path = decoded.empty() ? from : std::filesystem::weakly_canonical(from.parent_path() / decoded);
+    id = hash + 1;
+    return true;
+  }
+
+  // f may point a use at another type, types are shared so they are never changed in place
+  template <typename F>
+  static void forEachType(ModuleNode* module, const F& f) {
+    for (auto& nested : module->modules_) forEachType(nested, f);
+    for (auto& op : module->operators_) {
+      for (auto& param : op->params_) f(module, param->type_, param->nilable_ || param->unlimited_ ? SOFT : HARD);
+      if (op->returnType_ != nullptr) f(module, op->returnType_->type_, RETURN);
+    }
+    for (auto& attribute : module->attributes_) f(module, attribute->type_, attribute->nilable_ || attribute->unlimited_ ? SOFT : HARD);
+  }
+
+  template <typename F>
+  static void forEachType(Package* package, const F& f) {
+    for (auto& nested : package->packages_) forEachType(nested, f);
+    for (auto& module : package->modules_) forEachType(module, f);
+  }
+
+  template <typename F>
+  static void forEachType(ModelNode* model, const F& f) {
+    for (auto& package : model->packages_) forEachType(package, f);
+    for (auto& module : model->modules_) forEachType(module, f);
+  }
+
+  // Queues the libraries a resource references that are not part of the set yet
+  void collectReferences(size_t resource) {
+    ModelNode* model = resources_[resource].model_;
+    if (model == nullptr) return;
+    const std::filesystem::path from = resources_[resource].path_;
+    forEachType(model, [&](ModuleNode*, Type*& type, Use) {
+      std::filesystem::path path;
+      const char* id;
+      if (!type->isPrimitive_ || !splitReference(type->type_, from, path, id)) return;
+      if (loaded_.contains(path.string()) || missing_.contains(path.string())) return;
+      if (!std::filesystem::exists(path)) {
+        std::cerr << "Referenced resource not found: " << path.string() << std::endl;
+        missing_.insert(path.string());
+        return;
+      }
+      addResource(path, true);
+    });
+  }
+
+  // Points the resource's references to other resources at the ids they name
+  void resolve(size_t resource) {
+    ModelNode* model = resources_[resource].model_;
+    if (model == nullptr) return;
+    const std::filesystem::path& from = resources_[resource].path_;
+    if (model->types_ == nullptr) model->types_ = std::make_shared<TypeTable>();
+    size_t resolved = 0;
+    forEachType(model, [&](ModuleNode* module, Type*& type, Use use) {
+      std::filesystem::path path;
+      const char* id;
+      if (!type->isPrimitive_ || !splitReference(type->type_, from, path, id)) return;
+      SharedIdIndex::Entry entry;
+      if (!ids_.find(id, entry)) {
+        unresolved_++;
+        return;
+      }
+      type = model->types_->intern(id);
+      if (use != RETURN) module->addDependency(type->type_, use == SOFT);
+      resolved++;
+    });
+    if (resolved > 0) rehash(model);
+  }
+
+  // Types are part of the content hashes, which parsers computed before resolution
+  static void rehash(ModuleNode* module) {
+    for (auto& nested : module->modules_) rehash(nested);
+    module->computeHash();
+  }
+
+  static void rehash(Package* package) {
+    for (auto& nested : package->packages_) rehash(nested);
+    for (auto& module : package->modules_) rehash(module);
+    package->computeHash();
+  }
+
+  static void rehash(ModelNode* model) {
+    for (auto& package : model->packages_) rehash(package);
+    for (auto& module : model->modules_) rehash(module);
+  }
+};
+
+}  // namespace XMR
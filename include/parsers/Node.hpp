@@ -18,15 +18,26 @@
  *
  ***********************************************************/
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "parsers/ContentHash.hpp"
+#include "parsers/IdIndex.hpp"
+#include "parsers/ScopeTree.hpp"
+#include "parsers/TypeTable.hpp"
+
 #define MAX_STRING_SIZE 100
 
 namespace XMR {
@@ -41,25 +52,66 @@ class Node {
    */
   virtual void generate(std::ostream& os) = 0;
 
+  bool isFrozen() const { return frozen_; }
+
  protected:
   Node() = default;
-  ~Node() = default;
+  virtual ~Node() = default;
+
+  // Set by ModelNode::freeze() once parsing is done. A frozen tree is shared read only between
+  // generators, so nodes refuse any further additions.
+  bool frozen_ = false;
+
+  bool rejectIfFrozen(const char* what) const {
+    if (frozen_) {
+      std::cerr << "Cannot add " << what << " to a frozen model" << std::endl;
+    }
+    return frozen_;
+  }
 };
 
 enum Visibility { PUBLIC, PROTECTED, PRIVATE, PACKAGE };
 enum Direction { IN, OUT };
 
-class PackageImport : public Node {};
+constexpr size_t NUM_VISIBILITIES = 4;
 
-class Relationship : public Node {};
-
-class Type {
+// Members of one kind owned by a module, i.e. its operators. They are kept in a single array
+// bucketed by visibility in the order of the Visibility enum, so every member is one pass over
+// contiguous memory and the members of a visibility are a range of it. Members keep the order
+// they were added in within their visibility.
+template <typename T>
+class MemberTable {
  public:
-  char* type_;
-  bool isPrimitive_;
-  Type(char* type, bool isPrimitive = false) : type_(type), isPrimitive_(isPrimitive) {}
+  void add(T* member, Visibility visibility) {
+    items_.insert(items_.begin() + ends_[visibility], member);
+    for (size_t i = visibility; i < NUM_VISIBILITIES; i++) {
+      ends_[i]++;
+    }
+  }
+
+  // Members of one visibility
+  std::span<T* const> of(Visibility visibility) const {
+    const uint32_t begin = visibility == PUBLIC ? 0 : ends_[visibility - 1];
+    return {items_.data() + begin, ends_[visibility] - begin};
+  }
+
+  std::span<T* const> all() const { return items_; }
+  auto begin() const { return items_.begin(); }
+  auto end() const { return items_.end(); }
+  size_t size() const { return items_.size(); }
+  bool empty() const { return items_.empty(); }
+  T* operator[](size_t i) const { return items_[i]; }
+  size_t capacity() const { return items_.capacity(); }
+
+ private:
+  std::vector<T*> items_;
+  std::array<uint32_t, NUM_VISIBILITIES> ends_{};
 };
 
+class PackageImport : public Node {};
+
+class Relationship : public Node {};
+
 class Param {
  public:
   char* name_ = nullptr;
@@ -72,6 +124,11 @@ class Param {
 
   Param(char* name, char* id, Type* type, Direction direction = Direction::IN) : name_(name), id_(id), type_(type), direction_(direction) {}
 
+  void addToHash(ContentHasher& hasher) const {
+    hasher.add(name_).add(id_).add(direction_).add(nilable_).add(unlimited_).add(multiplicity_);
+    type_->addToHash(hasher);
+  }
+
   friend std::ostream& operator<<(std::ostream& os, const Param node) {
     os << "Param Name: " << node.name_ << " Param ID: " << node.id_ << " Param Type: " << node.type_->type_ << " Param Direction: " << node.direction_ << std::endl;
     return os;
@@ -93,8 +150,27 @@ class Operator : public Node {
     os << *this << std::endl;
   }
 
-  void addParam(Param* param) { params_.push_back(param); }
-  void addReturnType(Param* returnType) { returnType_ = returnType; }
+  void addParam(Param* param) {
+    if (rejectIfFrozen("param")) return;
+    params_.push_back(param);
+  }
+  void addReturnType(Param* returnType) {
+    if (rejectIfFrozen("return type")) return;
+    returnType_ = returnType;
+  }
+
+  void freeze() { frozen_ = true; }
+
+  void addToHash(ContentHasher& hasher) const {
+    hasher.add(name_).add(id_).add(visibility_).add(params_.size());
+    for (size_t i = 0; i < params_.size(); i++) {
+      params_[i]->addToHash(hasher);
+    }
+    hasher.add(returnType_ != nullptr);
+    if (returnType_) {
+      returnType_->addToHash(hasher);
+    }
+  }
 
   friend std::ostream& operator<<(std::ostream& os, const Operator node) {
     os << "Operator Name: " << node.name_ << std::endl;
@@ -122,6 +198,13 @@ class Attribute : public Node {
 
   Attribute(char* name, char* id, Type* type, Visibility visibility = Visibility::PUBLIC) : name_(name), id_(id), type_(type), visibility_(visibility) {}
 
+  void addToHash(ContentHasher& hasher) const {
+    hasher.add(name_).add(id_).add(visibility_).add(nilable_).add(unlimited_).add(multiplicity_);
+    type_->addToHash(hasher);
+  }
+
+  void freeze() { frozen_ = true; }
+
   void generate(std::ostream& os) final {
     os << "Called Attribute Generate for Attribute Node: " << std::endl;
     os << *this << std::endl;
@@ -142,20 +225,12 @@ class ModuleNode : public Node {
   char* id_ = nullptr;
   Visibility visibility_;
   std::vector<char*> generalizations_;
+  std::vector<IdHandle> generalizationHandles_;  // generalizations_ in the model's IdIndex, resolved by ModelNode::freeze()
 
-  std::vector<ModuleNode*> publicModules_;
-  std::vector<ModuleNode*> privateModules_;
-  std::vector<ModuleNode*> protectedModules_;
-  std::vector<ModuleNode*> packageModules_;
-
-  std::vector<Operator*> publicOperators_;
-  std::vector<Operator*> protectedOperators_;
-  std::vector<Operator*> privateOperators_;
-  std::vector<Operator*> packageOperators_;
-  std::vector<Attribute*> publicAttributes_;
-  std::vector<Attribute*> protectedAttributes_;
-  std::vector<Attribute*> privateAttributes_;
-  std::vector<Attribute*> packageAttributes_;
+  // Nested modules, operators and attributes, each bucketed by visibility
+  MemberTable<ModuleNode> modules_;
+  MemberTable<Operator> operators_;
+  MemberTable<Attribute> attributes_;
 
   // We delineate two types of dependencies in XMR.
   // 1.) Soft dependency: A soft dependency is when the type signature of the
@@ -177,14 +252,20 @@ class ModuleNode : public Node {
   // of the modules based on hard dependencies. This assumes that there is no "hard" circular dependencies in the XMR tree.
   std::unordered_map<std::string, std::string> softDependencyList_;
   std::unordered_map<std::string, std::string> hardDependencyList_;
-  std::vector<std::string> fullyQualified_;  // this module inclusive
+  const Scope* scope_ = &Scope::EMPTY;  // this module inclusive
+
+  // Stable content hash of this module and everything it owns, see computeHash().
+  // 0 until computed, parsers compute it once the module is fully parsed.
+  uint64_t hash_ = 0;
 
   //!@todo: Do we want to default visibility if not set? Will it never be not
   //! set in the metadata?
-  ModuleNode(char* name, char* id, std::vector<std::string> fullyQualified, Visibility visibility = Visibility::PUBLIC)
-      : name_(name), id_(id), fullyQualified_(fullyQualified), visibility_(visibility) {}
+  ModuleNode(char* name, char* id, const Scope* scope, Visibility visibility = Visibility::PUBLIC) : name_(name), id_(id), scope_(scope), visibility_(visibility) {}
+
+  // Qualified name as a list of names, prefer iterating scope_
+  std::vector<std::string> fullyQualified() const { return scope_->strings(); }
 
-  std::vector<std::string> getSoftDependencies() {
+  std::vector<std::string> getSoftDependencies() const {
     std::vector<std::string> result;
     for (auto& pair : softDependencyList_) {
       result.push_back(pair.first);
@@ -192,7 +273,7 @@ class ModuleNode : public Node {
     return result;
   }
 
-  std::vector<std::string> getHardDependencies() {
+  std::vector<std::string> getHardDependencies() const {
     std::vector<std::string> result;
     for (auto& pair : hardDependencyList_) {
       result.push_back(pair.first);
@@ -200,29 +281,35 @@ class ModuleNode : public Node {
     return result;
   }
 
-  const size_t getNumHardDependencies() { return hardDependencyList_.size(); }
+  size_t getNumHardDependencies() const { return hardDependencyList_.size(); }
 
-  const size_t getNumSoftDependencies() { return softDependencyList_.size(); }
+  size_t getNumSoftDependencies() const { return softDependencyList_.size(); }
 
   void addGeneralization(char* generalization) {
+    if (rejectIfFrozen("generalization")) return;
     // Generalizations are always hard dependencies
     hardDependencyList_[generalization] = generalization;
     generalizations_.push_back(generalization);
   }
 
-  void addModule(ModuleNode* module) {
-    if (module->visibility_ == Visibility::PUBLIC) {
-      publicModules_.push_back(module);
-    } else if (module->visibility_ == Visibility::PRIVATE) {
-      privateModules_.push_back(module);
-    } else if (module->visibility_ == Visibility::PROTECTED) {
-      protectedModules_.push_back(module);
+  // Records a dependency found after the operator or attribute using it was added, i.e. a type
+  // that referenced another resource of a ModelSet until it was resolved
+  void addDependency(char* id, bool soft) {
+    if (rejectIfFrozen("dependency")) return;
+    if (soft) {
+      softDependencyList_[id] = id;
     } else {
-      packageModules_.push_back(module);
+      hardDependencyList_[id] = id;
     }
   }
 
+  void addModule(ModuleNode* module) {
+    if (rejectIfFrozen("module")) return;
+    modules_.add(module, module->visibility_);
+  }
+
   void addOperator(Operator* op) {
+    if (rejectIfFrozen("operator")) return;
     for (size_t i = 0; i < op->params_.size(); i++) {
       if (!op->params_[i]->type_->isPrimitive_) {
         // Nilable and unlimited params are "soft" dependencies
@@ -233,19 +320,11 @@ class ModuleNode : public Node {
         }
       }
     }
-    if (op->visibility_ == Visibility::PRIVATE) {
-      privateOperators_.push_back(op);
-
-    } else if (op->visibility_ == Visibility::PROTECTED) {
-      protectedOperators_.push_back(op);
-    } else if (op->visibility_ == Visibility::PACKAGE) {
-      packageOperators_.push_back(op);
-    } else {
-      publicOperators_.push_back(op);
-    }
+    operators_.add(op, op->visibility_);
   }
 
   void addAttribute(Attribute* attribute) {
+    if (rejectIfFrozen("attribute")) return;
     if (!attribute->type_->isPrimitive_) {
       if (attribute->nilable_ || attribute->unlimited_) {
         softDependencyList_[attribute->type_->type_] = attribute->type_->type_;
@@ -253,14 +332,64 @@ class ModuleNode : public Node {
         hardDependencyList_[attribute->type_->type_] = attribute->type_->type_;
       }
     }
-    if (attribute->visibility_ == Visibility::PRIVATE) {
-      privateAttributes_.push_back(attribute);
-    } else if (attribute->visibility_ == Visibility::PROTECTED) {
-      protectedAttributes_.push_back(attribute);
-    } else if (attribute->visibility_ == Visibility::PACKAGE) {
-      packageAttributes_.push_back(attribute);
-    } else {
-      publicAttributes_.push_back(attribute);
+    attributes_.add(attribute, attribute->visibility_);
+  }
+
+  /**
+   * Computes and stores the content hash of this module. Covers the name, id, visibility,
+   * scope, generalizations, attributes, operators and the hashes of the nested modules, so
+   * nested modules must have their hash computed first.
+   * @returns the computed hash
+   */
+  uint64_t computeHash() {
+    ContentHasher hasher;
+    hasher.add(name_).add(id_).add(visibility_);
+
+    hasher.add(scope_->size());
+    scope_->forEach([&hasher](std::string_view name) { hasher.add(name); });
+
+    hasher.add(generalizations_.size());
+    for (auto& generalization : generalizations_) {
+      hasher.add(generalization);
+    }
+
+    // Nested modules are hashed private before protected as they always were, so hashes
+    // persisted in snapshots and generation caches stay valid
+    for (Visibility visibility : {PUBLIC, PRIVATE, PROTECTED, PACKAGE}) {
+      hasher.add(modules_.of(visibility).size());
+      for (auto& module : modules_.of(visibility)) {
+        hasher.add(module->hash_);
+      }
+    }
+
+    for (Visibility visibility : {PUBLIC, PROTECTED, PRIVATE, PACKAGE}) {
+      hasher.add(operators_.of(visibility).size());
+      for (auto& op : operators_.of(visibility)) {
+        op->addToHash(hasher);
+      }
+    }
+
+    for (Visibility visibility : {PUBLIC, PROTECTED, PRIVATE, PACKAGE}) {
+      hasher.add(attributes_.of(visibility).size());
+      for (auto& attribute : attributes_.of(visibility)) {
+        attribute->addToHash(hasher);
+      }
+    }
+
+    hash_ = hasher.digest();
+    return hash_;
+  }
+
+  void freeze() {
+    frozen_ = true;
+    for (auto& module : modules_) {
+      module->freeze();
+    }
+    for (auto& op : operators_) {
+      op->freeze();
+    }
+    for (auto& attribute : attributes_) {
+      attribute->freeze();
     }
   }
 
@@ -284,15 +413,66 @@ class Package : public Node {
   std::vector<Package*> packages_;
   std::vector<ModuleNode*> modules_;
   std::vector<Relationship*> relationships_;
-  std::vector<std::string> fullyQualified_;  // This package inclusive
+  const Scope* scope_ = &Scope::EMPTY;  // This package inclusive
+
+  // Stable content hash of this package and everything it owns, see computeHash()
+  uint64_t hash_ = 0;
+
+  Package(char* name, char* id, const Scope* scope) : name_(name), id_(id), scope_(scope) {}
+
+  // Qualified name as a list of names, prefer iterating scope_
+  std::vector<std::string> fullyQualified() const { return scope_->strings(); }
 
-  Package(char* name, char* id, std::vector<std::string> fullyQualified) : name_(name), id_(id), fullyQualified_(fullyQualified) {}
+  inline void addPackage(Package* package) {
+    if (rejectIfFrozen("package")) return;
+    packages_.push_back(package);
+  }
+
+  inline void addModule(ModuleNode* module) {
+    if (rejectIfFrozen("module")) return;
+    modules_.push_back(module);
+  }
+
+  inline void addRelationship(Relationship* relationship) {
+    if (rejectIfFrozen("relationship")) return;
+    relationships_.push_back(relationship);
+  }
 
-  inline void addPackage(Package* package) { packages_.push_back(package); }
+  void freeze() {
+    frozen_ = true;
+    for (auto& package : packages_) {
+      package->freeze();
+    }
+    for (auto& module : modules_) {
+      module->freeze();
+    }
+  }
+
+  /**
+   * Computes and stores the content hash of this package from its name, id, scope and
+   * the hashes of its nested packages and modules, so those must be computed first.
+   * @returns the computed hash
+   */
+  uint64_t computeHash() {
+    ContentHasher hasher;
+    hasher.add(name_).add(id_);
+
+    hasher.add(scope_->size());
+    scope_->forEach([&hasher](std::string_view name) { hasher.add(name); });
+
+    hasher.add(packages_.size());
+    for (auto& package : packages_) {
+      hasher.add(package->hash_);
+    }
 
-  inline void addModule(ModuleNode* module) { modules_.push_back(module); }
+    hasher.add(modules_.size());
+    for (auto& module : modules_) {
+      hasher.add(module->hash_);
+    }
 
-  inline void addRelationship(Relationship* relationship) { relationships_.push_back(relationship); }
+    hash_ = hasher.digest();
+    return hash_;
+  }
 
   void generate(std::ostream& os) final {
     os << "Called Package Generate for Package Node: " << std::endl;
@@ -306,6 +486,171 @@ class Package : public Node {
   }
 };
 
+// Reverse of the modules' dependency lists, built once the model is frozen. Modules, nested ones
+// included, are numbered in document order and the modules depending on each module are stored
+// back to back (CSR), one array for hard and one for soft dependencies. Answers "what depends on
+// this class" without scanning the model.
+class DependencyIndex {
+ public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  enum Kind { SOFT = 1, HARD = 2, ANY = SOFT | HARD };
+
+  /**
+   * Numbers every module below the given packages and modules and inverts their dependency lists.
+   * Dependencies on ids that are not modules, i.e. primitive or unresolved types, are dropped.
+   */
+  void build(const std::vector<Package*>& packages, const std::vector<ModuleNode*>& modules);
+
+  size_t size() const { return modules_.size(); }
+
+  // Estimated heap bytes held, the id table estimated like libstdc++ lays it out
+  uint64_t heapBytes() const {
+    uint64_t bytes = modules_.capacity() * sizeof(const ModuleNode*) + owners_.capacity() * sizeof(uint32_t);
+    bytes += index_.bucket_count() * sizeof(void*) + index_.size() * (sizeof(decltype(index_)::value_type) + sizeof(void*) + sizeof(size_t));
+    for (const Csr* csr : {&hard_, &soft_}) {
+      bytes += (csr->offsets_.capacity() + csr->edges_.capacity()) * sizeof(uint32_t);
+    }
+    return bytes;
+  }
+
+  const ModuleNode* module(uint32_t index) const { return modules_[index]; }
+
+  // Index of the module with the given id, NONE if no module has it
+  uint32_t find(std::string_view id) const {
+    auto found = index_.find(id);
+    return found == index_.end() ? NONE : found->second;
+  }
+
+  // Outermost module of a nested module, what generators render as one unit
+  uint32_t owner(uint32_t index) const { return owners_[index]; }
+
+  // Modules with a dependency of the given kind on the module, ascending
+  std::span<const uint32_t> hardDependents(uint32_t index) const { return {hard_.edges_.data() + hard_.offsets_[index], hard_.edges_.data() + hard_.offsets_[index + 1]}; }
+  std::span<const uint32_t> softDependents(uint32_t index) const { return {soft_.edges_.data() + soft_.offsets_[index], soft_.edges_.data() + soft_.offsets_[index + 1]}; }
+
+  /**
+   * Modules that depend on any of the given ids
+   * @param[in] ids module ids, ids of anything else are ignored
+   * @param[in] kind dependencies to follow
+   * @param[in] transitive also the modules depending on those, and so on
+   * @returns module indices, ascending
+   */
+  std::vector<uint32_t> dependents(const std::vector<std::string>& ids, Kind kind = ANY, bool transitive = false) const {
+    std::vector<char> seen(modules_.size(), false);
+    std::vector<uint32_t> pending;
+    for (auto& id : ids) {
+      const uint32_t index = find(id);
+      if (index != NONE) pending.push_back(index);
+    }
+    std::vector<uint32_t> result;
+    while (!pending.empty()) {
+      const uint32_t index = pending.back();
+      pending.pop_back();
+      for (const Csr* csr : {&hard_, &soft_}) {
+        if (!(kind & (csr == &hard_ ? HARD : SOFT))) continue;
+        for (uint32_t i = csr->offsets_[index]; i < csr->offsets_[index + 1]; i++) {
+          const uint32_t dependent = csr->edges_[i];
+          if (seen[dependent]) continue;
+          seen[dependent] = true;
+          result.push_back(dependent);
+          if (transitive) pending.push_back(dependent);
+        }
+      }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  /**
+   * Smallest set of modules to render again after the given modules changed. A rendered module
+   * holds its own content and the names of the modules it references, so this is the outermost
+   * module of each changed module and of each module directly depending on one.
+   * @param[in] changed ids of modules that changed
+   * @returns indices of outermost modules, ascending
+   */
+  std::vector<uint32_t> regenerationSet(const std::vector<std::string>& changed) const {
+    std::vector<uint32_t> result;
+    for (auto& id : changed) {
+      const uint32_t index = find(id);
+      if (index != NONE) result.push_back(owners_[index]);
+    }
+    for (uint32_t dependent : dependents(changed)) {
+      result.push_back(owners_[dependent]);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+ private:
+  struct Csr {
+    std::vector<uint32_t> offsets_;  // size() + 1 entries, dependents of i are edges_[offsets_[i], offsets_[i + 1])
+    std::vector<uint32_t> edges_;
+  };
+
+  std::vector<const ModuleNode*> modules_;
+  std::vector<uint32_t> owners_;
+  std::unordered_map<std::string_view, uint32_t> index_;  // keys point at the modules' ids
+  Csr hard_;
+  Csr soft_;
+
+  void number(const ModuleNode* module, uint32_t owner) {
+    const uint32_t index = static_cast<uint32_t>(modules_.size());
+    modules_.push_back(module);
+    owners_.push_back(owner == NONE ? index : owner);
+    index_.emplace(module->id_, index);
+    for (auto& nested : module->modules_) {
+      number(nested, owners_.back());
+    }
+  }
+
+  void number(const Package* package) {
+    for (auto& module : package->modules_) {
+      number(module, NONE);
+    }
+    for (auto& nested : package->packages_) {
+      number(nested);
+    }
+  }
+
+  // Counting pass then filling pass, sources are visited in ascending order so every list is sorted
+  void invert(Csr& csr, std::unordered_map<std::string, std::string> ModuleNode::*list) {
+    csr.offsets_.assign(modules_.size() + 1, 0);
+    for (auto& module : modules_) {
+      for (auto& dependency : module->*list) {
+        const uint32_t target = find(dependency.first);
+        if (target != NONE) csr.offsets_[target + 1]++;
+      }
+    }
+    for (size_t i = 1; i < csr.offsets_.size(); i++) {
+      csr.offsets_[i] += csr.offsets_[i - 1];
+    }
+    csr.edges_.resize(csr.offsets_.back());
+    std::vector<uint32_t> next(csr.offsets_.begin(), csr.offsets_.end() - 1);
+    for (uint32_t source = 0; source < modules_.size(); source++) {
+      for (auto& dependency : modules_[source]->*list) {
+        const uint32_t target = find(dependency.first);
+        if (target != NONE) csr.edges_[next[target]++] = source;
+      }
+    }
+  }
+};
+
+inline void DependencyIndex::build(const std::vector<Package*>& packages, const std::vector<ModuleNode*>& modules) {
+  modules_.clear();
+  owners_.clear();
+  index_.clear();
+  for (auto& package : packages) {
+    number(package);
+  }
+  for (auto& module : modules) {
+    number(module, NONE);
+  }
+  invert(hard_, &ModuleNode::hardDependencyList_);
+  invert(soft_, &ModuleNode::softDependencyList_);
+}
+
 class ModelNode : public Node {
  public:
   char* name_ = nullptr;
@@ -314,31 +659,114 @@ class ModelNode : public Node {
   std::vector<Package*> packages_;
   std::vector<ModuleNode*> modules_;
   std::vector<Relationship*> relationships_;
-  std::vector<std::string> fullyQualified_;  // This model inclusive
+  const Scope* scope_ = &Scope::EMPTY;  // This model inclusive
+
+  // Every module the model can name by xmi id, filled by the parser. Generators look type names
+  // up through it, the handles types resolve to are set by freeze().
+  IdIndex ids_;
+
+  // Keeps alive memory the names in this tree point into when they are not individually
+  // allocated, i.e. a mapped snapshot.
+  std::shared_ptr<void> storage_;
+
+  // Who depends on each module, empty until freeze()
+  DependencyIndex dependencyIndex_;
+
+  // Owns the scopes of the tree, shared with the models of a set that are combined into this one
+  std::shared_ptr<ScopeTree> scopes_;
 
-  // used to by copied at the end of parse so during code generation step
-  // can be used to lookup type names by xmi id
-  std::unordered_map<std::string, std::vector<std::string>> idNameMap_;
+  // Owns the types params and attributes share, like scopes_ shared with combined models
+  std::shared_ptr<TypeTable> types_;
 
-  ModelNode(char* name, char* id, std::vector<std::string> fullyQualified) : name_(name), id_(id), fullyQualified_(fullyQualified) {}
+  ModelNode(char* name, char* id, const Scope* scope) : name_(name), id_(id), scope_(scope) {}
 
-  inline void addPackageImport(PackageImport* packageImport) { packageImports_.push_back(packageImport); }
+  // Qualified name as a list of names, prefer iterating scope_
+  std::vector<std::string> fullyQualified() const { return scope_->strings(); }
 
-  inline void addPackage(Package* package) { packages_.push_back(package); }
+  inline void addPackageImport(PackageImport* packageImport) {
+    if (rejectIfFrozen("package import")) return;
+    packageImports_.push_back(packageImport);
+  }
 
-  inline void addModule(ModuleNode* module) { modules_.push_back(module); }
+  inline void addPackage(Package* package) {
+    if (rejectIfFrozen("package")) return;
+    packages_.push_back(package);
+  }
 
-  inline void addRelationship(Relationship* relationship) { relationships_.push_back(relationship); }
+  inline void addModule(ModuleNode* module) {
+    if (rejectIfFrozen("module")) return;
+    modules_.push_back(module);
+  }
+
+  inline void addRelationship(Relationship* relationship) {
+    if (rejectIfFrozen("relationship")) return;
+    relationships_.push_back(relationship);
+  }
+
+  /**
+   * Makes the whole tree logically immutable. Called once parsing is done, after which the
+   * tree is only handed out as const and may be read by any number of generator threads
+   * without locking. Generators keep their own ordering and bookkeeping in a ModelView.
+   * Dependency lists can no longer change, so the reverse dependency index is built here, and
+   * ids referenced by types and generalizations are resolved to handles in ids_.
+   */
+  void freeze() {
+    frozen_ = true;
+    for (auto& package : packages_) {
+      package->freeze();
+      resolveHandles(package);
+    }
+    for (auto& module : modules_) {
+      module->freeze();
+      resolveHandles(module);
+    }
+    dependencyIndex_.build(packages_, modules_);
+  }
 
   void generate(std::ostream& os) final {
     os << "Called Model Generate for Model Node: " << std::endl;
     os << *this << std::endl;
   }
 
-  friend std::ostream& operator<<(std::ostream& os, const ModelNode node) {
+  friend std::ostream& operator<<(std::ostream& os, const ModelNode& node) {
     os << "Model Name: " << node.name_ << std::endl;
     os << "Model Id: " << node.id_ << std::endl;
     return os;
   }
+
+ private:
+  void resolveHandles(Type* type) {
+    if (!type->isPrimitive_) type->handle_ = ids_.find(type->type_);
+  }
+
+  void resolveHandles(ModuleNode* module) {
+    const IdHandle self = ids_.find(module->id_);
+    if (self != NO_ID && ids_.module(self) == nullptr) ids_.link(self, module);
+    module->generalizationHandles_.clear();
+    for (auto& generalization : module->generalizations_) {
+      module->generalizationHandles_.push_back(ids_.find(generalization));
+    }
+    for (auto& nested : module->modules_) {
+      resolveHandles(nested);
+    }
+    for (auto& op : module->operators_) {
+      for (auto& param : op->params_) {
+        resolveHandles(param->type_);
+      }
+      if (op->returnType_ != nullptr) resolveHandles(op->returnType_->type_);
+    }
+    for (auto& attribute : module->attributes_) {
+      resolveHandles(attribute->type_);
+    }
+  }
+
+  void resolveHandles(Package* package) {
+    for (auto& nested : package->packages_) {
+      resolveHandles(nested);
+    }
+    for (auto& module : package->modules_) {
+      resolveHandles(module);
+    }
+  }
 };
 }  // namespace XMR
\ No newline at end of file
@@ -17,11 +17,17 @@
  * @brief:
  *
  ***********************************************************/
+#include <memory>
+#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "parsers/ArenaMemoryManager.hpp"
 #include "parsers/IParser.hpp"
+#include "parsers/ScopeTree.hpp"
+#include "parsers/StringPool.hpp"
 #include "xercesc/dom/DOMElement.hpp"
 #include "xercesc/parsers/XercesDOMParser.hpp"
 #include "xercesc/util/XMLChar.hpp"
@@ -31,8 +37,16 @@
 namespace XMR {
 
 class PapyrusParser : public IParser {
+  // Backs the DOM parser, the DOM and scratch strings of the current document
+  ArenaMemoryManager documentArena_;
   xercesc::XercesDOMParser* parser_ = nullptr;
   xercesc::ErrorHandler* errHandler_ = nullptr;
+  // Worker pools are absorbed into this one, handed to the model as its storage
+  std::shared_ptr<StringPool> strings_;
+  // Scopes of the model, shared by the workers and handed to the model
+  std::shared_ptr<ScopeTree> scopes_;
+  // Types of the model, interned by the workers
+  std::shared_ptr<TypeTable> types_;
 
   // const char* packageElementTag_ = "packagedElement";
   XMLCh* idKey_;
@@ -47,6 +61,7 @@ class PapyrusParser : public IParser {
   XMLCh* lowerValueAttrKey_;
   XMLCh* upperValueAttrKey_;
   XMLCh* valueKey_;
+  XMLCh* directionKey_;
   // Various values returned from "xmi:type" key in XML DOM
   std::string packageType_ = "uml:Package";
   std::string packageImportType_ = "uml:PackageImport";
@@ -63,16 +78,48 @@ class PapyrusParser : public IParser {
                                                               {interactionType_, UmlType::INTERACTION}, {associationType_, UmlType::ASSOCIATION},      {propertyType_, UmlType::PROPERTY},
                                                               {operationType_, UmlType::OPERATION},     {primitiveType_, UmlType::PRIMITIVE},          {generalType_, UmlType::GENERALIZATION}};
 
-  // used to store XMI id to name mapping to be used when
-  // user defined modules are also used for attributes and param types.
-  std::unordered_map<std::string, std::vector<std::string>> idNameMap_;
-  std::vector<std::string> currentScope_;
+  // Everything parsing one child of the model produces, results are merged in document order so
+  // the tree, the id index and the output do not depend on which thread parsed what
+  struct ParseResult {
+    xercesc::DOMElement* element_ = nullptr;
+    Package* package_ = nullptr;
+    ModuleNode* module_ = nullptr;
+    // Modules to index in the order they were parsed, a later module with the same id wins on merge
+    std::vector<const ModuleNode*> ids_;
+    std::string out_;
+    std::string err_;
+    bool ok_ = false;
+  };
 
+  // Per thread parse state. The DOM is only ever read while building the tree so workers can
+  // share it, everything written lives here.
+  struct ParseContext {
+    const Scope* currentScope_ = nullptr;
+    ArenaMemoryManager scratch_{64 << 10};
+    StringPool strings_;
+    ParseResult* result_ = nullptr;
+    std::ostringstream out_;
+    std::ostringstream err_;
+  };
+
+  // Threads parsing the children of the model, 1 parses on the calling thread
+  unsigned parallelism_ = 1;
+
+  void createDocumentParser();
+  void releaseDocument();
+  // Transcodes into the context's scratch arena, for strings that are not kept in the model
+  char* scratch(ParseContext& context, const XMLCh* text);
+  // Transcodes into the context's string pool, which ends up in the model's storage
+  char* keep(ParseContext& context, const XMLCh* text);
+  UmlType umlType(const char* type) const;
+
+  ModelNode* parseDocument();
   ModelNode* parseModel(xercesc::DOMNode* model);
-  Package* parsePackage(xercesc::DOMElement* package);
-  ModuleNode* parseModule(xercesc::DOMElement* module);
-  Operator* parseOperator(xercesc::DOMElement* op);
-  Attribute* parseAttribute(xercesc::DOMElement* attribute);
+  void parseModelChild(ParseContext& context, ParseResult& result);
+  Package* parsePackage(ParseContext& context, xercesc::DOMElement* package);
+  ModuleNode* parseModule(ParseContext& context, xercesc::DOMElement* module);
+  Operator* parseOperator(ParseContext& context, xercesc::DOMElement* op);
+  Attribute* parseAttribute(ParseContext& context, xercesc::DOMElement* attribute);
 
  public:
   // Constructor
@@ -85,6 +132,10 @@ class PapyrusParser : public IParser {
 
   // Main parse function
   ModelNode* parse() final;
+
+  bool memoryStats(MemoryStats& stats) const final;
+
+  bool setParallelism(unsigned threads) final;
 };
 
 }  // namespace XMR
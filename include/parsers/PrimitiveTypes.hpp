@@ -0,0 +1,98 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: PrimitiveTypes.hpp
+ * @brief: Primitive types of the UML and Papyrus libraries
+ *
+ ***********************************************************/
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace XMR {
+
+// Primitive a primitive type reference names, decoded from the fragment of its href. Generators
+// map it to their language with a table indexed by it, so new kinds go before UNKNOWN.
+enum class Primitive : uint8_t { NONE, BOOLEAN, INTEGER, REAL, STRING, UNLIMITED_NATURAL, BYTE, CHAR, SHORT, LONG, FLOAT, UNKNOWN };
+
+inline constexpr size_t NUM_PRIMITIVES = static_cast<size_t>(Primitive::UNKNOWN) + 1;
+
+struct PrimitiveName {
+  std::string_view name_;
+  Primitive primitive_;
+};
+
+// Element names of the primitive type libraries Papyrus references, i.e. the fragment of
+// pathmap://UML_LIBRARIES/<library>.library.uml#<name>. The names do not clash between
+// libraries, so the fragment alone decides the primitive.
+inline constexpr std::array<PrimitiveName, 30> PRIMITIVE_NAMES = {{
+    // UMLPrimitiveTypes, also the OMG PrimitiveTypes.xmi
+    {"Boolean", Primitive::BOOLEAN},
+    {"Integer", Primitive::INTEGER},
+    {"Real", Primitive::REAL},
+    {"String", Primitive::STRING},
+    {"UnlimitedNatural", Primitive::UNLIMITED_NATURAL},
+    // EcorePrimitiveTypes, the boxed EJavaClass ones map like their primitive
+    {"EBoolean", Primitive::BOOLEAN},
+    {"EBooleanObject", Primitive::BOOLEAN},
+    {"EByte", Primitive::BYTE},
+    {"EByteObject", Primitive::BYTE},
+    {"EChar", Primitive::CHAR},
+    {"ECharacterObject", Primitive::CHAR},
+    {"EShort", Primitive::SHORT},
+    {"EShortObject", Primitive::SHORT},
+    {"EInt", Primitive::INTEGER},
+    {"EIntegerObject", Primitive::INTEGER},
+    {"ELong", Primitive::LONG},
+    {"ELongObject", Primitive::LONG},
+    {"EFloat", Primitive::FLOAT},
+    {"EFloatObject", Primitive::FLOAT},
+    {"EDouble", Primitive::REAL},
+    {"EDoubleObject", Primitive::REAL},
+    {"EString", Primitive::STRING},
+    // JavaPrimitiveTypes
+    {"boolean", Primitive::BOOLEAN},
+    {"byte", Primitive::BYTE},
+    {"char", Primitive::CHAR},
+    {"short", Primitive::SHORT},
+    {"int", Primitive::INTEGER},
+    {"long", Primitive::LONG},
+    {"float", Primitive::FLOAT},
+    {"double", Primitive::REAL},
+}};
+
+/**
+ * Primitive an href names, e.g. pathmap://UML_LIBRARIES/UMLPrimitiveTypes.library.uml#Real
+ * @param[in] href href of a primitive type
+ * @returns the primitive after the '#', UNKNOWN if it is none of the libraries above
+ */
+constexpr Primitive decodePrimitive(std::string_view href) {
+  const size_t hash = href.find('#');
+  if (hash == std::string_view::npos) return Primitive::UNKNOWN;
+  const std::string_view name = href.substr(hash + 1);
+  for (auto& primitive : PRIMITIVE_NAMES) {
+    if (primitive.name_ == name) return primitive.primitive_;
+  }
+  return Primitive::UNKNOWN;
+}
+
+static_assert(decodePrimitive("pathmap://UML_LIBRARIES/UMLPrimitiveTypes.library.uml#Boolean") == Primitive::BOOLEAN);
+static_assert(decodePrimitive("pathmap://UML_LIBRARIES/EcorePrimitiveTypes.library.uml#EDouble") == Primitive::REAL);
+static_assert(decodePrimitive("pathmap://UML_LIBRARIES/JavaPrimitiveTypes.library.uml#long") == Primitive::LONG);
+static_assert(decodePrimitive("Integer") == Primitive::UNKNOWN);
+
+}  // namespace XMR
@@ -0,0 +1,183 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: ScopeTree.hpp
+ * @brief: Qualified names stored as a tree of shared prefixes
+ *
+ ***********************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parsers/StringPool.hpp"
+
+namespace XMR {
+
+class ScopeTree;
+
+// A qualified name such as Model::Pkg::Class. A scope only holds its own name segment and the
+// scope enclosing it, so every name below a package shares the package's scope instead of
+// copying its path. Scopes are created by a ScopeTree and live as long as it does.
+class Scope {
+ public:
+  // Renderings of the whole name a scope caches, joined with :: . and /
+  enum Separator { CPP, DOT, PATH, NUM_SEPARATORS };
+  static constexpr std::string_view SEPARATORS[NUM_SEPARATORS] = {"::", ".", "/"};
+
+  // Scope of no names, what an unknown id resolves to
+  static const Scope EMPTY;
+
+  Scope(const Scope* parent, std::string_view name, ScopeTree* tree) : parent_(parent), name_(name), depth_(parent == nullptr ? 1 : parent->depth_ + 1), tree_(tree) {}
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  // nullptr for an outermost scope
+  const Scope* parent() const { return parent_; }
+
+  // Last segment, NUL terminated
+  std::string_view name() const { return name_; }
+  std::string_view back() const { return name_; }
+
+  // Number of segments, the scope inclusive
+  size_t size() const { return depth_; }
+  bool empty() const { return depth_ == 0; }
+
+  // The enclosing scope of the given size, this scope for its own size
+  const Scope* ancestor(size_t size) const {
+    const Scope* scope = this;
+    while (scope != nullptr && scope->depth_ > size) scope = scope->parent_;
+    return scope;
+  }
+
+  // Segment i counted from the outermost one
+  std::string_view operator[](size_t i) const { return ancestor(i + 1)->name_; }
+
+  /**
+   * Calls f with every segment, outermost first
+   * @param[in] f callable taking a std::string_view
+   */
+  template <typename F>
+  void forEach(F&& f) const {
+    if (depth_ == 0) return;
+    if (parent_ != nullptr) parent_->forEach(f);
+    f(name_);
+  }
+
+  // The segments as the vector of names nodes used to hold
+  std::vector<std::string> strings() const {
+    std::vector<std::string> names;
+    names.reserve(depth_);
+    forEach([&names](std::string_view name) { names.emplace_back(name); });
+    return names;
+  }
+
+  /**
+   * Whole name joined with a separator, rendered once and kept by the tree. Safe to call from
+   * any number of threads.
+   * @param[in] separator separator between segments
+   * @returns NUL terminated rendering, empty for an empty scope
+   */
+  std::string_view joined(Separator separator) const;
+
+  // Same segments, the scopes may belong to different trees
+  bool operator==(const Scope& other) const {
+    if (this == &other) return true;
+    if (depth_ != other.depth_ || name_ != other.name_) return false;
+    if (parent_ == nullptr || other.parent_ == nullptr) return parent_ == other.parent_;
+    return *parent_ == *other.parent_;
+  }
+
+ private:
+  friend class ScopeTree;
+
+  Scope() = default;
+
+  const Scope* parent_ = nullptr;
+  std::string_view name_;
+  uint32_t depth_ = 0;
+  ScopeTree* tree_ = nullptr;
+  mutable std::atomic<const char*> joined_[NUM_SEPARATORS] = {};
+};
+
+inline const Scope Scope::EMPTY{};
+
+// Creates and owns the scopes of a model. A node of the tree adds its scope once, below the
+// scope of its parent, so names are stored once however deep the tree is. Scopes may be added
+// from several threads, e.g. while packages are parsed in parallel; once added they are only read.
+class ScopeTree {
+ public:
+  ScopeTree() = default;
+  ScopeTree(const ScopeTree&) = delete;
+  ScopeTree& operator=(const ScopeTree&) = delete;
+
+  /**
+   * Adds the scope named name inside parent
+   * @param[in] parent enclosing scope, nullptr for an outermost one
+   * @param[in] name last segment, copied into the tree
+   * @returns the new scope, valid as long as the tree
+   */
+  const Scope* add(const Scope* parent, std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return &scopes_.emplace_back(parent, std::string_view(strings_.copy(name), name.size()), this);
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scopes_.size();
+  }
+
+  // Estimated heap bytes held, renderings included
+  uint64_t heapBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scopes_.size() * sizeof(Scope) + strings_.bytes();
+  }
+
+ private:
+  friend class Scope;
+
+  const char* render(const Scope& scope, Scope::Separator separator) {
+    std::string text;
+    if (scope.parent_ != nullptr) {
+      text = scope.parent_->joined(separator);
+      text += Scope::SEPARATORS[separator];
+    }
+    text += scope.name_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char* cached = scope.joined_[separator].load(std::memory_order_acquire);
+    if (cached != nullptr) return cached;
+    cached = strings_.copy(text);
+    scope.joined_[separator].store(cached, std::memory_order_release);
+    return cached;
+  }
+
+  mutable std::mutex mutex_;
+  std::deque<Scope> scopes_;
+  StringPool strings_;  // names and renderings
+};
+
+inline std::string_view Scope::joined(Separator separator) const {
+  if (tree_ == nullptr) return {};
+  const char* cached = joined_[separator].load(std::memory_order_acquire);
+  if (cached == nullptr) cached = tree_->render(*this, separator);
+  return cached;
+}
+
+}  // namespace XMR
@@ -0,0 +1,131 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: SimdScan.hpp
+ * @brief: Vectorized byte scanning kernels with runtime dispatch
+ *
+ ***********************************************************/
+#pragma once
+#include <cstddef>
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define XMR_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace XMR {
+namespace simd {
+
+// Kernels return the first position in [p, end) holding a match, or end. Every kernel has a
+// scalar version, SSE2 (baseline on x86-64) and AVX2 versions are picked at runtime.
+
+inline const char* findAny4Scalar(const char* p, const char* end, char a, char b, char c, char d) {
+  for (; p < end; p++) {
+    const char x = *p;
+    if (x == a || x == b || x == c || x == d) return p;
+  }
+  return end;
+}
+
+// Stops on the closing quote, an entity reference or any control character (tab and line breaks
+// included), anything that needs a slow path in an attribute value
+inline const char* findValueEndScalar(const char* p, const char* end, char quote) {
+  for (; p < end; p++) {
+    const unsigned char x = static_cast<unsigned char>(*p);
+    if (x == static_cast<unsigned char>(quote) || x == '&' || x < 0x20) return p;
+  }
+  return end;
+}
+
+#ifdef XMR_SIMD_X86
+
+inline const char* findAny4Sse2(const char* p, const char* end, char a, char b, char c, char d) {
+  const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+  for (; end - p >= 16; p += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)), _mm_or_si128(_mm_cmpeq_epi8(x, vc), _mm_cmpeq_epi8(x, vd)));
+    const int mask = _mm_movemask_epi8(m);
+    if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+  }
+  return findAny4Scalar(p, end, a, b, c, d);
+}
+
+inline const char* findValueEndSse2(const char* p, const char* end, char quote) {
+  const __m128i vq = _mm_set1_epi8(quote), va = _mm_set1_epi8('&'), vc = _mm_set1_epi8(0x1F);
+  for (; end - p >= 16; p += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // x <= 0x1F unsigned, min(x, 0x1F) == x
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(x, vc), x);
+    const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, vq), _mm_cmpeq_epi8(x, va)), control);
+    const int mask = _mm_movemask_epi8(m);
+    if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+  }
+  return findValueEndScalar(p, end, quote);
+}
+
+__attribute__((target("avx2"))) inline const char* findAny4Avx2(const char* p, const char* end, char a, char b, char c, char d) {
+  const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c), vd = _mm256_set1_epi8(d);
+  for (; end - p >= 32; p += 32) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i m =
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb)), _mm256_or_si256(_mm256_cmpeq_epi8(x, vc), _mm256_cmpeq_epi8(x, vd)));
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+  return findAny4Sse2(p, end, a, b, c, d);
+}
+
+__attribute__((target("avx2"))) inline const char* findValueEndAvx2(const char* p, const char* end, char quote) {
+  const __m256i vq = _mm256_set1_epi8(quote), va = _mm256_set1_epi8('&'), vc = _mm256_set1_epi8(0x1F);
+  for (; end - p >= 32; p += 32) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(x, vc), x);
+    const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, vq), _mm256_cmpeq_epi8(x, va)), control);
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+  return findValueEndSse2(p, end, quote);
+}
+
+#endif
+
+struct ScanKernels {
+  const char* name_;
+  const char* (*findAny4_)(const char*, const char*, char, char, char, char);
+  const char* (*findValueEnd_)(const char*, const char*, char);
+};
+
+inline ScanKernels selectScanKernels() {
+#ifdef XMR_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return {"avx2", findAny4Avx2, findValueEndAvx2};
+  return {"sse2", findAny4Sse2, findValueEndSse2};
+#else
+  return {"scalar", findAny4Scalar, findValueEndScalar};
+#endif
+}
+
+// Kernels for this CPU, selected once
+inline const ScanKernels& scanKernels() {
+  static const ScanKernels kernels = selectScanKernels();
+  return kernels;
+}
+
+inline const char* findAny4(const char* p, const char* end, char a, char b, char c, char d) { return scanKernels().findAny4_(p, end, a, b, c, d); }
+inline const char* findByte(const char* p, const char* end, char c) { return scanKernels().findAny4_(p, end, c, c, c, c); }
+inline const char* findValueEnd(const char* p, const char* end, char quote) { return scanKernels().findValueEnd_(p, end, quote); }
+
+}  // namespace simd
+}  // namespace XMR
@@ -0,0 +1,501 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: Snapshot.hpp
+ * @brief: Binary snapshot format of a parsed XMR tree (.xmrb)
+ *
+ ***********************************************************/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "parsers/Node.hpp"
+
+namespace XMR {
+
+// Layout of a snapshot file:
+//
+//   SnapshotHeader | records | string table
+//
+// Records are fixed size, 8 byte aligned structs that reference each other and the
+// null terminated strings of the string table through self relative offsets. Nothing in
+// the file depends on where it is loaded, so a mapped file can be walked in place with the
+// Snapshot* views below without first deserializing it. Strings are deduplicated.
+//
+// SNAPSHOT_VERSION must be bumped on any change to the records below.
+constexpr char SNAPSHOT_MAGIC[4] = {'X', 'M', 'R', 'B'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr const char* SNAPSHOT_EXTENSION = ".xmrb";
+
+// Offset relative to the address of the offset itself, 0 is null. Only valid in place
+// so copying is disabled.
+template <typename T>
+struct RelPtr {
+  int32_t offset_;
+
+  RelPtr() = delete;
+  RelPtr(const RelPtr&) = delete;
+  RelPtr& operator=(const RelPtr&) = delete;
+
+  const T* get() const { return offset_ == 0 ? nullptr : reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset_); }
+};
+
+template <typename T>
+struct RelArray {
+  RelPtr<T> data_;
+  uint32_t size_;
+
+  const T* begin() const { return data_.get(); }
+  const T* end() const { return data_.get() + size_; }
+  const T& operator[](size_t i) const { return data_.get()[i]; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+};
+
+using RelString = RelPtr<char>;
+
+struct SnapshotType {
+  RelString type_;
+  uint32_t isPrimitive_;
+};
+
+struct SnapshotParam {
+  RelString name_;
+  RelString id_;
+  SnapshotType type_;
+  uint32_t direction_;
+  uint32_t nilable_;
+  uint32_t unlimited_;
+  uint32_t multiplicity_;
+};
+
+struct SnapshotOperator {
+  RelString name_;
+  RelString id_;
+  uint32_t visibility_;
+  uint32_t hasReturnType_;
+  SnapshotParam returnType_;
+  RelArray<SnapshotParam> params_;
+};
+
+struct SnapshotAttribute {
+  RelString name_;
+  RelString id_;
+  SnapshotType type_;
+  uint32_t visibility_;
+  uint32_t nilable_;
+  uint32_t unlimited_;
+  uint32_t multiplicity_;
+};
+
+struct SnapshotModule {
+  RelString name_;
+  RelString id_;
+  uint64_t hash_;
+  uint32_t visibility_;
+  uint32_t reserved_;
+  RelArray<RelString> fullyQualified_;
+  RelArray<RelString> generalizations_;
+  RelArray<SnapshotModule> modules_;  // nested modules of every visibility
+  RelArray<SnapshotOperator> operators_;
+  RelArray<SnapshotAttribute> attributes_;
+  RelArray<RelString> softDependencies_;
+  RelArray<RelString> hardDependencies_;
+};
+
+struct SnapshotPackage {
+  RelString name_;
+  RelString id_;
+  uint64_t hash_;
+  RelArray<RelString> fullyQualified_;
+  RelArray<SnapshotPackage> packages_;
+  RelArray<SnapshotModule> modules_;
+};
+
+struct SnapshotIdName {
+  RelString id_;
+  RelArray<RelString> names_;
+};
+
+struct SnapshotModel {
+  RelString name_;
+  RelString id_;
+  RelArray<RelString> fullyQualified_;
+  RelArray<SnapshotPackage> packages_;
+  RelArray<SnapshotModule> modules_;
+  RelArray<SnapshotIdName> idNameMap_;
+};
+
+struct SnapshotHeader {
+  char magic_[4];
+  uint32_t version_;
+  uint64_t fileSize_;
+  uint64_t stringTableOffset_;
+  uint64_t stringTableSize_;
+  RelPtr<SnapshotModel> model_;
+  uint32_t reserved_;
+};
+
+// Walks every record of a mapped snapshot before it is used. The loader follows the offsets
+// blindly, so every record and array has to lie inside the mapping, be aligned for its type,
+// and every string has to start inside the string table and end there with a NUL.
+class SnapshotValidator {
+ public:
+  SnapshotValidator(const char* data, size_t size, const char* strings, size_t stringsSize)
+      : begin_(data), end_(data + size), strings_(strings), stringsEnd_(strings + stringsSize), budget_(size) {}
+
+  bool model(const SnapshotHeader& header) {
+    const SnapshotModel* model = record(header.model_.get());
+    return model != nullptr && string(model->name_) && string(model->id_) && strings(model->fullyQualified_) && each(model->packages_, &SnapshotValidator::package) &&
+           each(model->modules_, &SnapshotValidator::module) && each(model->idNameMap_, &SnapshotValidator::idName);
+  }
+
+ private:
+  const char* begin_;
+  const char* end_;
+  const char* strings_;
+  const char* stringsEnd_;
+  size_t budget_;  // bytes of records left to visit, the writer never shares records so a valid file never runs out
+
+  template <typename T>
+  const T* record(const T* pointer, size_t count = 1) {
+    const char* address = reinterpret_cast<const char*>(pointer);
+    if (address == nullptr || address < begin_ || address > end_ || reinterpret_cast<uintptr_t>(address) % alignof(T) != 0) return nullptr;
+    if (count > static_cast<size_t>(end_ - address) / sizeof(T) || count * sizeof(T) > budget_) return nullptr;
+    budget_ -= count * sizeof(T);
+    return pointer;
+  }
+
+  template <typename T>
+  bool array(const RelArray<T>& array) {
+    return array.empty() || record(array.data_.get(), array.size()) != nullptr;
+  }
+
+  template <typename T>
+  bool each(const RelArray<T>& items, bool (SnapshotValidator::*check)(const T&)) {
+    if (!array(items)) return false;
+    for (auto& item : items) {
+      if (!(this->*check)(item)) return false;
+    }
+    return true;
+  }
+
+  // Null strings are written for absent names
+  bool string(const RelString& string) {
+    const char* str = string.get();
+    return str == nullptr || (str >= strings_ && str < stringsEnd_ && std::memchr(str, '\0', stringsEnd_ - str) != nullptr);
+  }
+
+  bool strings(const RelArray<RelString>& strings) { return each(strings, &SnapshotValidator::string); }
+
+  bool type(const SnapshotType& type) { return string(type.type_); }
+
+  bool param(const SnapshotParam& param) { return string(param.name_) && string(param.id_) && type(param.type_); }
+
+  bool op(const SnapshotOperator& op) {
+    return string(op.name_) && string(op.id_) && (!op.hasReturnType_ || param(op.returnType_)) && each(op.params_, &SnapshotValidator::param);
+  }
+
+  bool attribute(const SnapshotAttribute& attribute) { return string(attribute.name_) && string(attribute.id_) && type(attribute.type_); }
+
+  bool module(const SnapshotModule& module) {
+    return string(module.name_) && string(module.id_) && strings(module.fullyQualified_) && strings(module.generalizations_) && each(module.modules_, &SnapshotValidator::module) &&
+           each(module.operators_, &SnapshotValidator::op) && each(module.attributes_, &SnapshotValidator::attribute) && strings(module.softDependencies_) &&
+           strings(module.hardDependencies_);
+  }
+
+  bool package(const SnapshotPackage& package) {
+    return string(package.name_) && string(package.id_) && strings(package.fullyQualified_) && each(package.packages_, &SnapshotValidator::package) &&
+           each(package.modules_, &SnapshotValidator::module);
+  }
+
+  bool idName(const SnapshotIdName& idName) { return string(idName.id_) && strings(idName.names_); }
+};
+
+/**
+ * Checks that a buffer holds a snapshot this build can read and that every offset in it stays
+ * inside the buffer
+ * @param[in] data: Start of the snapshot, must be 8 byte aligned
+ * @param[in] size: Size of the buffer in bytes
+ * @returns the header on success, nullptr otherwise
+ */
+inline const SnapshotHeader* validateSnapshot(const void* data, size_t size) {
+  if (size < sizeof(SnapshotHeader)) {
+    std::cerr << "Snapshot is smaller than its header" << std::endl;
+    return nullptr;
+  }
+  const SnapshotHeader* header = static_cast<const SnapshotHeader*>(data);
+  if (std::memcmp(header->magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+    std::cerr << "Not an XMR snapshot" << std::endl;
+    return nullptr;
+  }
+  if (header->version_ != SNAPSHOT_VERSION) {
+    std::cerr << "Unsupported snapshot version: " << header->version_ << " expected: " << SNAPSHOT_VERSION << std::endl;
+    return nullptr;
+  }
+  if (header->fileSize_ != size || header->stringTableOffset_ > size || header->stringTableSize_ > size - header->stringTableOffset_) {
+    std::cerr << "Snapshot is truncated or corrupt" << std::endl;
+    return nullptr;
+  }
+  const char* begin = static_cast<const char*>(data);
+  SnapshotValidator validator(begin, size, begin + header->stringTableOffset_, header->stringTableSize_);
+  if (!validator.model(*header)) {
+    std::cerr << "Snapshot record out of bounds" << std::endl;
+    return nullptr;
+  }
+  return header;
+}
+
+// Serializes an XMR tree into the snapshot format
+class SnapshotWriter {
+ public:
+  std::vector<char> write(const ModelNode* model) {
+    buffer_.clear();
+    strings_.clear();
+    stringOffsets_.clear();
+    stringFixups_.clear();
+    overflow_ = false;
+
+    const size_t header = allocate<SnapshotHeader>(1);
+    const size_t modelPos = allocate<SnapshotModel>(1);
+    setRel(header + offsetof(SnapshotHeader, model_), modelPos);
+    writeModel(modelPos, model);
+
+    // Append string table and resolve every string reference into it
+    const size_t stringTable = buffer_.size();
+    buffer_.insert(buffer_.end(), strings_.begin(), strings_.end());
+    for (auto& fixup : stringFixups_) {
+      setRel(fixup.first, stringTable + fixup.second);
+    }
+    buffer_.resize(align(buffer_.size()), 0);
+    if (overflow_) {
+      std::cerr << "Model is too large for a snapshot, offsets exceed 2 GiB" << std::endl;
+      buffer_.clear();
+      return {};
+    }
+
+    std::memcpy(&buffer_[header + offsetof(SnapshotHeader, magic_)], SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    put<uint32_t>(header + offsetof(SnapshotHeader, version_), SNAPSHOT_VERSION);
+    put<uint64_t>(header + offsetof(SnapshotHeader, fileSize_), buffer_.size());
+    put<uint64_t>(header + offsetof(SnapshotHeader, stringTableOffset_), stringTable);
+    put<uint64_t>(header + offsetof(SnapshotHeader, stringTableSize_), strings_.size());
+    return std::move(buffer_);
+  }
+
+ private:
+  std::vector<char> buffer_;
+  std::string strings_;
+  std::unordered_map<std::string, uint32_t> stringOffsets_;
+  std::vector<std::pair<size_t, uint32_t>> stringFixups_;  // field position, string table offset
+  bool overflow_ = false;
+
+  static size_t align(size_t pos) { return (pos + 7) & ~size_t(7); }
+
+  // Appends count zeroed records and returns the position of the first one. Positions stay valid
+  // across allocations, pointers into buffer_ do not.
+  template <typename T>
+  size_t allocate(size_t count) {
+    const size_t pos = align(buffer_.size());
+    buffer_.resize(pos + sizeof(T) * count, 0);
+    return pos;
+  }
+
+  template <typename T>
+  void put(size_t pos, T value) {
+    std::memcpy(&buffer_[pos], &value, sizeof(T));
+  }
+
+  // Offsets that do not fit are reported once the whole tree is written
+  void setRel(size_t field, size_t target) {
+    const int64_t offset = static_cast<int64_t>(target) - static_cast<int64_t>(field);
+    if (offset < INT32_MIN || offset > INT32_MAX) {
+      overflow_ = true;
+      return;
+    }
+    put<int32_t>(field, static_cast<int32_t>(offset));
+  }
+
+  void setString(size_t field, const char* str) {
+    if (str == nullptr) return;
+    auto found = stringOffsets_.find(str);
+    uint32_t offset;
+    if (found != stringOffsets_.end()) {
+      offset = found->second;
+    } else {
+      offset = static_cast<uint32_t>(strings_.size());
+      strings_.append(str);
+      strings_.push_back('\0');
+      stringOffsets_.emplace(str, offset);
+    }
+    stringFixups_.emplace_back(field, offset);
+  }
+
+  template <typename T>
+  size_t setArray(size_t field, size_t count) {
+    put<uint32_t>(field + offsetof(RelArray<T>, size_), static_cast<uint32_t>(count));
+    if (count == 0) return 0;
+    const size_t data = allocate<T>(count);
+    setRel(field + offsetof(RelArray<T>, data_), data);
+    return data;
+  }
+
+  // Scopes are stored in full, names of a scope are NUL terminated
+  void writeScope(size_t field, const Scope& scope) {
+    const size_t data = setArray<RelString>(field, scope.size());
+    size_t i = 0;
+    scope.forEach([&](std::string_view name) { setString(data + i++ * sizeof(RelString), name.data()); });
+  }
+
+  void writeStrings(size_t field, const std::vector<char*>& strings) {
+    const size_t data = setArray<RelString>(field, strings.size());
+    for (size_t i = 0; i < strings.size(); i++) {
+      setString(data + i * sizeof(RelString), strings[i]);
+    }
+  }
+
+  // Sorted so the same model always gives the same bytes whatever the hash order
+  void writeDependencies(size_t field, const std::unordered_map<std::string, std::string>& dependencies) {
+    std::vector<const std::string*> sorted;
+    sorted.reserve(dependencies.size());
+    for (auto& pair : dependencies) {
+      sorted.push_back(&pair.first);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    const size_t data = setArray<RelString>(field, sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+      setString(data + i * sizeof(RelString), sorted[i]->c_str());
+    }
+  }
+
+  void writeType(size_t pos, const Type* type) {
+    setString(pos + offsetof(SnapshotType, type_), type->type_);
+    put<uint32_t>(pos + offsetof(SnapshotType, isPrimitive_), type->isPrimitive_);
+  }
+
+  void writeParam(size_t pos, const Param* param) {
+    setString(pos + offsetof(SnapshotParam, name_), param->name_);
+    setString(pos + offsetof(SnapshotParam, id_), param->id_);
+    writeType(pos + offsetof(SnapshotParam, type_), param->type_);
+    put<uint32_t>(pos + offsetof(SnapshotParam, direction_), param->direction_);
+    put<uint32_t>(pos + offsetof(SnapshotParam, nilable_), param->nilable_);
+    put<uint32_t>(pos + offsetof(SnapshotParam, unlimited_), param->unlimited_);
+    put<uint32_t>(pos + offsetof(SnapshotParam, multiplicity_), param->multiplicity_);
+  }
+
+  void writeOperator(size_t pos, const Operator* op) {
+    setString(pos + offsetof(SnapshotOperator, name_), op->name_);
+    setString(pos + offsetof(SnapshotOperator, id_), op->id_);
+    put<uint32_t>(pos + offsetof(SnapshotOperator, visibility_), op->visibility_);
+    put<uint32_t>(pos + offsetof(SnapshotOperator, hasReturnType_), op->returnType_ != nullptr);
+    if (op->returnType_) {
+      writeParam(pos + offsetof(SnapshotOperator, returnType_), op->returnType_);
+    }
+    const size_t params = setArray<SnapshotParam>(pos + offsetof(SnapshotOperator, params_), op->params_.size());
+    for (size_t i = 0; i < op->params_.size(); i++) {
+      writeParam(params + i * sizeof(SnapshotParam), op->params_[i]);
+    }
+  }
+
+  void writeAttribute(size_t pos, const Attribute* attribute) {
+    setString(pos + offsetof(SnapshotAttribute, name_), attribute->name_);
+    setString(pos + offsetof(SnapshotAttribute, id_), attribute->id_);
+    writeType(pos + offsetof(SnapshotAttribute, type_), attribute->type_);
+    put<uint32_t>(pos + offsetof(SnapshotAttribute, visibility_), attribute->visibility_);
+    put<uint32_t>(pos + offsetof(SnapshotAttribute, nilable_), attribute->nilable_);
+    put<uint32_t>(pos + offsetof(SnapshotAttribute, unlimited_), attribute->unlimited_);
+    put<uint32_t>(pos + offsetof(SnapshotAttribute, multiplicity_), attribute->multiplicity_);
+  }
+
+  void writeModule(size_t pos, const ModuleNode* module) {
+    setString(pos + offsetof(SnapshotModule, name_), module->name_);
+    setString(pos + offsetof(SnapshotModule, id_), module->id_);
+    put<uint64_t>(pos + offsetof(SnapshotModule, hash_), module->hash_);
+    put<uint32_t>(pos + offsetof(SnapshotModule, visibility_), module->visibility_);
+    writeScope(pos + offsetof(SnapshotModule, fullyQualified_), *module->scope_);
+    writeStrings(pos + offsetof(SnapshotModule, generalizations_), module->generalizations_);
+
+    // Members are written in table order, the loader buckets them by visibility again
+    const size_t modulesPos = setArray<SnapshotModule>(pos + offsetof(SnapshotModule, modules_), module->modules_.size());
+    for (size_t i = 0; i < module->modules_.size(); i++) {
+      writeModule(modulesPos + i * sizeof(SnapshotModule), module->modules_[i]);
+    }
+
+    const size_t operatorsPos = setArray<SnapshotOperator>(pos + offsetof(SnapshotModule, operators_), module->operators_.size());
+    for (size_t i = 0; i < module->operators_.size(); i++) {
+      writeOperator(operatorsPos + i * sizeof(SnapshotOperator), module->operators_[i]);
+    }
+
+    const size_t attributesPos = setArray<SnapshotAttribute>(pos + offsetof(SnapshotModule, attributes_), module->attributes_.size());
+    for (size_t i = 0; i < module->attributes_.size(); i++) {
+      writeAttribute(attributesPos + i * sizeof(SnapshotAttribute), module->attributes_[i]);
+    }
+
+    writeDependencies(pos + offsetof(SnapshotModule, softDependencies_), module->softDependencyList_);
+    writeDependencies(pos + offsetof(SnapshotModule, hardDependencies_), module->hardDependencyList_);
+  }
+
+  void writePackage(size_t pos, const Package* package) {
+    setString(pos + offsetof(SnapshotPackage, name_), package->name_);
+    setString(pos + offsetof(SnapshotPackage, id_), package->id_);
+    put<uint64_t>(pos + offsetof(SnapshotPackage, hash_), package->hash_);
+    writeScope(pos + offsetof(SnapshotPackage, fullyQualified_), *package->scope_);
+
+    const size_t packages = setArray<SnapshotPackage>(pos + offsetof(SnapshotPackage, packages_), package->packages_.size());
+    for (size_t i = 0; i < package->packages_.size(); i++) {
+      writePackage(packages + i * sizeof(SnapshotPackage), package->packages_[i]);
+    }
+    const size_t modules = setArray<SnapshotModule>(pos + offsetof(SnapshotPackage, modules_), package->modules_.size());
+    for (size_t i = 0; i < package->modules_.size(); i++) {
+      writeModule(modules + i * sizeof(SnapshotModule), package->modules_[i]);
+    }
+  }
+
+  void writeModel(size_t pos, const ModelNode* model) {
+    setString(pos + offsetof(SnapshotModel, name_), model->name_);
+    setString(pos + offsetof(SnapshotModel, id_), model->id_);
+    writeScope(pos + offsetof(SnapshotModel, fullyQualified_), *model->scope_);
+
+    const size_t packages = setArray<SnapshotPackage>(pos + offsetof(SnapshotModel, packages_), model->packages_.size());
+    for (size_t i = 0; i < model->packages_.size(); i++) {
+      writePackage(packages + i * sizeof(SnapshotPackage), model->packages_[i]);
+    }
+    const size_t modules = setArray<SnapshotModule>(pos + offsetof(SnapshotModel, modules_), model->modules_.size());
+    for (size_t i = 0; i < model->modules_.size(); i++) {
+      writeModule(modules + i * sizeof(SnapshotModule), model->modules_[i]);
+    }
+
+    // Ids are written sorted, the index keeps them in parse order
+    std::vector<const IdIndex::Entry*> ids;
+    ids.reserve(model->ids_.size());
+    for (auto& id : model->ids_.entries()) {
+      ids.push_back(&id);
+    }
+    std::sort(ids.begin(), ids.end(), [](const IdIndex::Entry* a, const IdIndex::Entry* b) { return std::strcmp(a->id_, b->id_) < 0; });
+    const size_t idNames = setArray<SnapshotIdName>(pos + offsetof(SnapshotModel, idNameMap_), ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+      const size_t entry = idNames + i * sizeof(SnapshotIdName);
+      setString(entry + offsetof(SnapshotIdName, id_), ids[i]->id_);
+      writeScope(entry + offsetof(SnapshotIdName, names_), *ids[i]->scope_);
+    }
+  }
+};
+
+}  // namespace XMR
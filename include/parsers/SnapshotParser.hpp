@@ -0,0 +1,58 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: SnapshotParser.hpp
+ * @brief: Loads binary .xmrb snapshots written by the SnapshotGenerator
+ *
+ ***********************************************************/
+#pragma once
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+#include "parsers/IParser.hpp"
+#include "parsers/Snapshot.hpp"
+
+namespace XMR {
+
+class SnapshotParser : public IParser {
+  // Mapped snapshot, ownership moves to the returned model as the tree's names point into it
+  std::shared_ptr<void> mapping_;
+  const SnapshotHeader* header_ = nullptr;
+  // Scopes of the model being loaded and of its modules by id
+  std::shared_ptr<ScopeTree> scopes_;
+  std::unordered_map<std::string_view, const Scope*> moduleScopes_;
+  std::shared_ptr<TypeTable> types_;
+
+  // Snapshots store every qualified name in full
+  const Scope* loadScope(const Scope* parent, const RelArray<RelString>& names);
+  ModelNode* loadModel(const SnapshotModel& model);
+  Package* loadPackage(const SnapshotPackage& package, const Scope* parent);
+  ModuleNode* loadModule(const SnapshotModule& module, const Scope* parent);
+  Operator* loadOperator(const SnapshotOperator& op);
+  Attribute* loadAttribute(const SnapshotAttribute& attribute);
+  Param* loadParam(const SnapshotParam& param);
+
+ public:
+  SnapshotParser() = default;
+
+  ~SnapshotParser() = default;
+
+  bool setInputFile(const char* fileName) final;
+
+  ModelNode* parse() final;
+};
+
+}  // namespace XMR
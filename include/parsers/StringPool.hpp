@@ -0,0 +1,97 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: StringPool.hpp
+ * @brief: Block allocated storage for the strings of a model
+ *
+ ***********************************************************/
+#pragma once
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parsers/Utf16Transcoder.hpp"
+
+namespace XMR {
+
+// Owns the text a model's names point to, packed back to back in large blocks instead of one
+// heap block per string. A parser fills a pool while building a tree and hands it to the model
+// as its storage, the strings are released with the model. Strings are never freed one by one.
+class StringPool {
+ public:
+  explicit StringPool(size_t blockSize = 64 << 10) : blockSize_(blockSize) {}
+
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // NUL terminated copy of text
+  char* copy(std::string_view text) {
+    char* out = reserve(text.size() + 1);
+    std::memcpy(out, text.data(), text.size());
+    out[text.size()] = '\0';
+    next_ += text.size() + 1;
+    return out;
+  }
+
+  // NUL terminated UTF-8 copy of NUL terminated UTF-16 text, nullptr stays nullptr
+  char* transcode(const char16_t* text) {
+    if (text == nullptr) return nullptr;
+    return transcode(text, std::char_traits<char16_t>::length(text));
+  }
+
+  char* transcode(const char16_t* text, size_t length) {
+    char* out = reserve(simd::utf8Capacity(length) + 1);
+    const size_t written = simd::transcodeUtf16(text, length, out);
+    out[written] = '\0';
+    next_ += written + 1;
+    return out;
+  }
+
+  // Takes over the blocks of another pool, strings copied into it stay valid and now live as
+  // long as this pool does
+  void absorb(StringPool&& other) {
+    for (auto& block : other.blocks_) blocks_.push_back(std::move(block));
+    bytes_ += other.bytes_;
+    other.blocks_.clear();
+    other.next_ = other.end_ = nullptr;
+    other.bytes_ = 0;
+  }
+
+  // Bytes of string data held, block slack included
+  size_t bytes() const { return bytes_; }
+
+ private:
+  // Room for size bytes at next_, the caller advances next_ by what it used
+  char* reserve(size_t size) {
+    if (static_cast<size_t>(end_ - next_) < size) {
+      const size_t blockSize = size > blockSize_ ? size : blockSize_;
+      blocks_.push_back(std::make_unique_for_overwrite<char[]>(blockSize));
+      next_ = blocks_.back().get();
+      end_ = next_ + blockSize;
+      bytes_ += blockSize;
+    }
+    return next_;
+  }
+
+  size_t blockSize_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t bytes_ = 0;
+};
+
+}  // namespace XMR
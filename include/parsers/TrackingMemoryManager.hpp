@@ -0,0 +1,83 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: TrackingMemoryManager.hpp
+ * @brief: Xerces memory manager that counts what the DOM and transcoding allocate
+ *
+ ***********************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#include "parsers/MemoryStats.hpp"
+#include "xercesc/framework/MemoryManager.hpp"
+
+namespace XMR {
+
+// Installed as the Xerces wide memory manager, so the DOM, the grammar and every transcoded
+// string are counted. Xerces does not pass sizes back on deallocate, each block carries its size
+// in a small header. There is a single instance as Xerces keeps the manager of the first
+// XMLPlatformUtils::Initialize until the last Terminate, whichever parser that was.
+class TrackingMemoryManager : public xercesc::MemoryManager {
+ public:
+  static TrackingMemoryManager& instance() {
+    static TrackingMemoryManager* manager = new TrackingMemoryManager;  // never destroyed, names in the model outlive Xerces
+    return *manager;
+  }
+
+  void* allocate(XMLSize_t size) override {
+    char* block = static_cast<char*>(::operator new(size + HEADER_SIZE));
+    *reinterpret_cast<size_t*>(block) = size;
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+    const uint64_t live = liveBytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = peakLiveBytes_.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return block + HEADER_SIZE;
+  }
+
+  void deallocate(void* p) override {
+    if (p == nullptr) return;
+    char* block = static_cast<char*>(p) - HEADER_SIZE;
+    liveBytes_.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+    ::operator delete(block);
+  }
+
+  xercesc::MemoryManager* getExceptionMemoryManager() override { return this; }
+
+  MemoryStats stats() const {
+    MemoryStats stats;
+    stats.allocations_ = allocations_.load();
+    stats.bytes_ = bytes_.load();
+    stats.liveBytes_ = liveBytes_.load();
+    stats.peakLiveBytes_ = peakLiveBytes_.load();
+    return stats;
+  }
+
+ private:
+  // Keeps the returned memory aligned like ::operator new
+  static constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+  TrackingMemoryManager() = default;
+
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<uint64_t> liveBytes_{0};
+  std::atomic<uint64_t> peakLiveBytes_{0};
+};
+
+}  // namespace XMR
@@ -0,0 +1,99 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: TypeTable.hpp
+ * @brief: Types interned once per model
+ *
+ ***********************************************************/
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "parsers/ContentHash.hpp"
+#include "parsers/IdIndex.hpp"
+#include "parsers/PrimitiveTypes.hpp"
+#include "parsers/StringPool.hpp"
+
+namespace XMR {
+
+// Type of a param or attribute, either the xmi id of a module or the href of a primitive type.
+// Types are interned by a TypeTable, every use of the same reference shares one Type.
+class Type {
+ public:
+  char* type_;
+  bool isPrimitive_;
+  Primitive primitive_ = Primitive::NONE;  // decoded once, NONE unless isPrimitive_
+  IdHandle handle_ = NO_ID;                // type_ in the model's IdIndex, resolved by ModelNode::freeze()
+  Type(char* type, bool isPrimitive = false) : type_(type), isPrimitive_(isPrimitive), primitive_(isPrimitive ? decodePrimitive(type == nullptr ? "" : type) : Primitive::NONE) {}
+
+  void addToHash(ContentHasher& hasher) const { hasher.add(type_).add(isPrimitive_); }
+};
+
+// Creates and owns the types of a model, one per distinct (reference, isPrimitive). A model
+// holds a few hundred distinct types for tens of thousands of params and attributes, so
+// references are copied and decoded once rather than per use. Types may be interned from
+// several threads while packages are parsed in parallel.
+class TypeTable {
+ public:
+  TypeTable() = default;
+  TypeTable(const TypeTable&) = delete;
+  TypeTable& operator=(const TypeTable&) = delete;
+
+  /**
+   * The type of a reference, created on first use
+   * @param[in] type xmi id or primitive href, copied into the table, nullptr reads as empty
+   * @param[in] isPrimitive whether type is a primitive href
+   * @returns the shared type, valid as long as the table
+   */
+  Type* intern(const char* type, bool isPrimitive = false) {
+    const std::string_view key = type == nullptr ? std::string_view() : std::string_view(type);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& types = byReference_[isPrimitive];
+    auto found = types.find(key);
+    if (found != types.end()) return found->second;
+    char* copy = strings_.copy(key);
+    Type* interned = &types_.emplace_back(copy, isPrimitive);
+    types.emplace(std::string_view(copy, key.size()), interned);
+    return interned;
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return types_.size();
+  }
+
+  // Estimated heap bytes held, the hash tables estimated like libstdc++ lays them out
+  uint64_t heapBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t bytes = types_.size() * sizeof(Type) + strings_.bytes();
+    for (auto& types : byReference_) {
+      bytes += types.bucket_count() * sizeof(void*) + types.size() * (sizeof(Map::value_type) + sizeof(void*) + sizeof(size_t));
+    }
+    return bytes;
+  }
+
+ private:
+  using Map = std::unordered_map<std::string_view, Type*>;
+
+  mutable std::mutex mutex_;
+  std::deque<Type> types_;
+  Map byReference_[2];  // by isPrimitive, keys point into strings_
+  StringPool strings_;
+};
+
+}  // namespace XMR
@@ -0,0 +1,154 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: Utf16Transcoder.hpp
+ * @brief: UTF-16 to UTF-8 transcoding with a vectorized ASCII path
+ *
+ ***********************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "parsers/SimdScan.hpp"
+
+namespace XMR {
+namespace simd {
+
+// Ids and names in XMI are nearly always ASCII. Runs of ASCII code units are narrowed a vector
+// at a time, anything else is encoded one code point at a time. Output is UTF-8 regardless of
+// the locale, unpaired surrogates become U+FFFD.
+
+// Bytes the output of transcoding length code units may take, terminator excluded
+constexpr size_t utf8Capacity(size_t length) { return 3 * length; }
+
+// Narrows the leading ASCII code units, returns how many were written
+inline size_t narrowAsciiScalar(const char16_t* in, size_t length, char* out) {
+  size_t n = 0;
+  for (; n < length && in[n] < 0x80; n++) out[n] = static_cast<char>(in[n]);
+  return n;
+}
+
+#ifdef XMR_SIMD_X86
+
+// Whole vectors only, the tail is left to the caller
+inline size_t narrowAsciiSse2(const char16_t* in, size_t length, char* out) {
+  const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t n = 0;
+  for (; length - n >= 16; n += 16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n + 8));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), nonAscii), zero)) != 0xFFFF) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm_packus_epi16(a, b));
+  }
+  if (length - n >= 8) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(a, nonAscii), zero)) == 0xFFFF) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out + n), _mm_packus_epi16(a, a));
+      n += 8;
+    }
+  }
+  return n;
+}
+
+__attribute__((target("avx2"))) inline size_t narrowAsciiAvx2(const char16_t* in, size_t length, char* out) {
+  const __m256i nonAscii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+  size_t n = 0;
+  for (; length - n >= 32; n += 32) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + n));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + n + 16));
+    if (!_mm256_testz_si256(_mm256_or_si256(a, b), nonAscii)) break;
+    // packus works per 128 bit lane, the permute puts the quarters back in order
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+  }
+  return n + narrowAsciiSse2(in + n, length - n, out + n);
+}
+
+#endif
+
+inline size_t (*selectNarrowAscii())(const char16_t*, size_t, char*) {
+#ifdef XMR_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return narrowAsciiAvx2;
+  return narrowAsciiSse2;
+#else
+  return narrowAsciiScalar;
+#endif
+}
+
+inline size_t narrowAscii(const char16_t* in, size_t length, char* out) {
+  static size_t (*const kernel)(const char16_t*, size_t, char*) = selectNarrowAscii();
+  return kernel(in, length, out);
+}
+
+/**
+ * Encodes code units from in[i] up to in[stop], or one past it to complete a surrogate pair
+ *
+ * @returns the index of the first code unit not encoded
+ */
+inline size_t encodeUtf16Scalar(const char16_t* in, size_t i, size_t stop, size_t length, char*& out) {
+  for (; i < stop; i++) {
+    uint32_t code = in[i];
+    if (code < 0x80) {
+      *out++ = static_cast<char>(code);
+      continue;
+    }
+    if (code < 0x800) {
+      *out++ = static_cast<char>(0xC0 | (code >> 6));
+      *out++ = static_cast<char>(0x80 | (code & 0x3F));
+      continue;
+    }
+    if (code >= 0xD800 && code <= 0xDFFF) {
+      if (code <= 0xDBFF && i + 1 < length && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF) {
+        code = 0x10000 + ((code - 0xD800) << 10) + (in[++i] - 0xDC00);
+        *out++ = static_cast<char>(0xF0 | (code >> 18));
+        *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        continue;
+      }
+      code = 0xFFFD;
+    }
+    *out++ = static_cast<char>(0xE0 | (code >> 12));
+    *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  }
+  return i;
+}
+
+/**
+ * Transcodes UTF-16 to UTF-8
+ *
+ * @param[in] in code units to transcode
+ * @param[in] length number of code units
+ * @param[out] out buffer of at least utf8Capacity(length) bytes, not terminated
+ * @returns number of bytes written
+ */
+inline size_t transcodeUtf16(const char16_t* in, size_t length, char* out) {
+  char* start = out;
+  size_t i = 0;
+  while (i < length) {
+    const size_t ascii = narrowAscii(in + i, length - i, out);
+    i += ascii;
+    out += ascii;
+    // The vector stopped on a block holding non ASCII, or there is less than a vector left
+    const size_t stop = length - i < 16 ? length : i + 16;
+    i = encodeUtf16Scalar(in, i, stop, length, out);
+  }
+  return static_cast<size_t>(out - start);
+}
+
+}  // namespace simd
+}  // namespace XMR
@@ -0,0 +1,321 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmiTokenizer.hpp
+ * @brief: Zero copy pull tokenizer over an in memory UTF-8 XML document
+ *
+ ***********************************************************/
+#pragma once
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "parsers/SimdScan.hpp"
+
+namespace XMR {
+
+enum class XmiToken { START, END, END_OF_INPUT, ERROR };
+
+struct XmiAttribute {
+  std::string_view name_;
+  char* value_;  // NUL terminated, inside the document
+};
+
+// Pulls element start and end tags out of a writable UTF-8 buffer, text content, comments,
+// processing instructions, CDATA and the DOCTYPE are skipped. Attribute values are decoded in
+// place: entities are expanded, whitespace is normalized the way a non validating XML parser
+// does, and the closing quote is overwritten with a NUL so values can be handed out as C strings
+// without copying. Element and attribute names are views into the buffer and are not terminated.
+// A self closing element produces a START followed by an END.
+class XmiTokenizer {
+ public:
+  XmiTokenizer(char* begin, char* end) : begin_(begin), p_(begin), end_(end) {}
+
+  XmiToken next() {
+    if (pendingEnd_) {
+      pendingEnd_ = false;
+      return XmiToken::END;
+    }
+    attributes_.clear();
+
+    while (true) {
+      p_ = const_cast<char*>(simd::findByte(p_, end_, '<'));
+      if (p_ == end_) {
+        if (!open_.empty()) return fail("unexpected end of document inside element");
+        return XmiToken::END_OF_INPUT;
+      }
+      p_++;
+      if (p_ == end_) return fail("unexpected end of document");
+
+      if (*p_ == '/') return endTag();
+      if (*p_ == '?') {
+        if (!skipPast("?>")) return fail("unterminated processing instruction");
+        continue;
+      }
+      if (*p_ == '!') {
+        if (!skipMarkup()) return fail("unterminated markup declaration");
+        continue;
+      }
+      return startTag();
+    }
+  }
+
+  // Name of the element the last START or END belongs to
+  std::string_view name() const { return name_; }
+
+  // Attributes of the last START, in document order
+  const std::vector<XmiAttribute>& attributes() const { return attributes_; }
+
+  // Value of the attribute on the last START, nullptr if it is not present
+  char* attribute(std::string_view name) const {
+    for (auto& attribute : attributes_) {
+      if (attribute.name_ == name) return attribute.value_;
+    }
+    return nullptr;
+  }
+
+  // Depth of the element the last token belongs to, the root element is depth 1
+  size_t depth() const { return open_.size() + (pendingEnd_ ? 1 : 0); }
+
+  /**
+   * Consumes tokens up to and including the END of the element whose START was just returned
+   *
+   * @returns false on a malformed document
+   */
+  bool skipElement() {
+    size_t depth = 1;
+    while (depth != 0) {
+      switch (next()) {
+        case XmiToken::START:
+          depth++;
+          break;
+        case XmiToken::END:
+          depth--;
+          break;
+        default:
+          return false;
+      }
+    }
+    return true;
+  }
+
+  const char* error() const { return error_; }
+  size_t offset() const { return static_cast<size_t>(p_ - begin_); }
+
+ private:
+  static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+  XmiToken fail(const char* error) {
+    error_ = error;
+    return XmiToken::ERROR;
+  }
+
+  void skipSpace() {
+    while (p_ < end_ && isSpace(*p_)) p_++;
+  }
+
+  bool skipPast(const char* terminator) {
+    const size_t length = std::strlen(terminator);
+    while (true) {
+      p_ = const_cast<char*>(simd::findByte(p_, end_, terminator[0]));
+      if (static_cast<size_t>(end_ - p_) < length) return false;
+      if (std::memcmp(p_, terminator, length) == 0) {
+        p_ += length;
+        return true;
+      }
+      p_++;
+    }
+  }
+
+  // Comments, CDATA sections and the DOCTYPE, including an internal subset
+  bool skipMarkup() {
+    const size_t left = static_cast<size_t>(end_ - p_);
+    if (left >= 3 && std::memcmp(p_, "!--", 3) == 0) return skipPast("-->");
+    if (left >= 8 && std::memcmp(p_, "![CDATA[", 8) == 0) return skipPast("]]>");
+    int brackets = 0;
+    for (; p_ < end_; p_++) {
+      if (*p_ == '[') brackets++;
+      if (*p_ == ']') brackets--;
+      if (*p_ == '>' && brackets <= 0) {
+        p_++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  char* scanName() {
+    char* start = p_;
+    while (p_ < end_ && !isSpace(*p_) && *p_ != '/' && *p_ != '>' && *p_ != '=') p_++;
+    return start;
+  }
+
+  XmiToken endTag() {
+    p_++;
+    char* start = scanName();
+    name_ = std::string_view(start, static_cast<size_t>(p_ - start));
+    skipSpace();
+    if (p_ == end_ || *p_ != '>') return fail("malformed end tag");
+    p_++;
+    if (open_.empty() || open_.back() != name_) return fail("mismatched end tag");
+    open_.pop_back();
+    return XmiToken::END;
+  }
+
+  XmiToken startTag() {
+    char* start = scanName();
+    if (p_ == start) return fail("missing element name");
+    name_ = std::string_view(start, static_cast<size_t>(p_ - start));
+
+    while (true) {
+      skipSpace();
+      if (p_ == end_) return fail("unterminated start tag");
+      if (*p_ == '>') {
+        p_++;
+        open_.push_back(name_);
+        return XmiToken::START;
+      }
+      if (*p_ == '/') {
+        if (end_ - p_ < 2 || p_[1] != '>') return fail("malformed empty element tag");
+        p_ += 2;
+        pendingEnd_ = true;
+        return XmiToken::START;
+      }
+
+      char* attributeName = p_;
+      p_ = const_cast<char*>(simd::findAny4(p_, end_, '=', '>', '<', '/'));
+      if (p_ == end_ || *p_ != '=') return fail("attribute without a value");
+      char* nameEnd = p_;
+      while (nameEnd > attributeName && isSpace(nameEnd[-1])) nameEnd--;
+      p_++;
+      skipSpace();
+      if (p_ == end_ || (*p_ != '"' && *p_ != '\'')) return fail("unquoted attribute value");
+      const char quote = *p_++;
+      char* value = p_;
+      if (!scanValue(quote)) return XmiToken::ERROR;
+      attributes_.push_back({std::string_view(attributeName, static_cast<size_t>(nameEnd - attributeName)), value});
+    }
+  }
+
+  // Leaves p_ past the closing quote and the value NUL terminated. The common value holds nothing
+  // to decode and costs one vector scan, the rest is rewritten in place since decoding never grows.
+  bool scanValue(char quote) {
+    char* out = nullptr;
+    while (true) {
+      char* hit = const_cast<char*>(simd::findValueEnd(p_, end_, quote));
+      if (hit == end_) {
+        fail("unterminated attribute value");
+        return false;
+      }
+      if (out != nullptr) {
+        std::memmove(out, p_, static_cast<size_t>(hit - p_));
+        out += hit - p_;
+      }
+      p_ = hit;
+      if (*p_ == quote) {
+        *(out != nullptr ? out : p_) = '\0';
+        p_++;
+        return true;
+      }
+      if (out == nullptr) out = p_;
+
+      if (*p_ == '&') {
+        if (!decodeEntity(out)) return false;
+        continue;
+      }
+      // Line breaks and tabs become spaces, a CR LF pair is a single line break
+      if (*p_ == '\r' && p_ + 1 < end_ && p_[1] == '\n') p_++;
+      *out++ = isSpace(*p_) ? ' ' : *p_;
+      p_++;
+    }
+  }
+
+  bool decodeEntity(char*& out) {
+    char* semicolon = p_ + 1;
+    while (semicolon < end_ && semicolon - p_ < 12 && *semicolon != ';') semicolon++;
+    if (semicolon >= end_ || *semicolon != ';') {
+      fail("malformed entity reference");
+      return false;
+    }
+    const std::string_view entity(p_ + 1, static_cast<size_t>(semicolon - p_ - 1));
+    p_ = semicolon + 1;
+
+    if (entity == "lt") {
+      *out++ = '<';
+    } else if (entity == "gt") {
+      *out++ = '>';
+    } else if (entity == "amp") {
+      *out++ = '&';
+    } else if (entity == "quot") {
+      *out++ = '"';
+    } else if (entity == "apos") {
+      *out++ = '\'';
+    } else if (entity.size() > 1 && entity[0] == '#') {
+      unsigned long code = 0;
+      const bool hex = entity[1] == 'x';
+      for (size_t i = hex ? 2 : 1; i < entity.size(); i++) {
+        const char c = entity[i];
+        int digit = -1;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        if (hex && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        if (hex && c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        if (digit < 0) {
+          fail("malformed character reference");
+          return false;
+        }
+        code = code * (hex ? 16 : 10) + static_cast<unsigned long>(digit);
+      }
+      if (code == 0 || code > 0x10FFFF) {
+        fail("invalid character reference");
+        return false;
+      }
+      out = encodeUtf8(out, code);
+    } else {
+      fail("undeclared entity");
+      return false;
+    }
+    return true;
+  }
+
+  static char* encodeUtf8(char* out, unsigned long code) {
+    if (code < 0x80) {
+      *out++ = static_cast<char>(code);
+    } else if (code < 0x800) {
+      *out++ = static_cast<char>(0xC0 | (code >> 6));
+      *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      *out++ = static_cast<char>(0xE0 | (code >> 12));
+      *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      *out++ = static_cast<char>(0xF0 | (code >> 18));
+      *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return out;
+  }
+
+  char* begin_;
+  char* p_;
+  char* end_;
+  std::string_view name_;
+  std::vector<XmiAttribute> attributes_;
+  std::vector<std::string_view> open_;
+  bool pendingEnd_ = false;
+  const char* error_ = nullptr;
+};
+
+}  // namespace XMR
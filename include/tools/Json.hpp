@@ -0,0 +1,296 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: Json.hpp
+ * @brief: Minimal JSON reader and writer for the tools
+ *
+ ***********************************************************/
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace XMR {
+
+// Just enough JSON for the perf harness to read benchmark reports and keep baselines, so the
+// tools have no dependency beyond the standard library. Numbers are doubles, objects keep
+// their keys sorted so written files diff cleanly.
+class JsonValue {
+ public:
+  enum class Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+  JsonValue() = default;
+  JsonValue(bool value) : kind_(Kind::BOOL), bool_(value) {}
+  JsonValue(double value) : kind_(Kind::NUMBER), number_(value) {}
+  JsonValue(std::string value) : kind_(Kind::STRING), string_(std::move(value)) {}
+  JsonValue(const char* value) : kind_(Kind::STRING), string_(value) {}
+
+  static JsonValue array() {
+    JsonValue value;
+    value.kind_ = Kind::ARRAY;
+    return value;
+  }
+  static JsonValue object() {
+    JsonValue value;
+    value.kind_ = Kind::OBJECT;
+    return value;
+  }
+
+  Kind kind() const { return kind_; }
+  bool isNull() const { return kind_ == Kind::NUL; }
+  bool isNumber() const { return kind_ == Kind::NUMBER; }
+  bool isString() const { return kind_ == Kind::STRING; }
+  bool isArray() const { return kind_ == Kind::ARRAY; }
+  bool isObject() const { return kind_ == Kind::OBJECT; }
+
+  bool asBool() const { return bool_; }
+  double asNumber() const { return number_; }
+  const std::string& asString() const { return string_; }
+  const std::vector<JsonValue>& items() const { return items_; }
+  const std::map<std::string, JsonValue>& members() const { return members_; }
+
+  void push(JsonValue value) { items_.push_back(std::move(value)); }
+  JsonValue& operator[](const std::string& key) {
+    kind_ = Kind::OBJECT;
+    return members_[key];
+  }
+
+  // nullptr if this is not an object or has no such member
+  const JsonValue* find(const std::string& key) const {
+    auto found = members_.find(key);
+    return found == members_.end() ? nullptr : &found->second;
+  }
+
+  /**
+   * Parses a JSON document
+   *
+   * @param[in] text document to parse
+   * @param[out] value parsed document
+   * @returns false if the text is not valid JSON
+   */
+  static bool parse(const std::string& text, JsonValue& value) {
+    size_t pos = 0;
+    if (!parseValue(text, pos, value)) return false;
+    skipSpace(text, pos);
+    return pos == text.size();
+  }
+
+  void write(std::ostream& os, int indent = 0) const {
+    switch (kind_) {
+      case Kind::NUL:
+        os << "null";
+        break;
+      case Kind::BOOL:
+        os << (bool_ ? "true" : "false");
+        break;
+      case Kind::NUMBER: {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.17g", number_);
+        os << buffer;
+        break;
+      }
+      case Kind::STRING:
+        writeString(os, string_);
+        break;
+      case Kind::ARRAY:
+        os << "[";
+        for (size_t i = 0; i < items_.size(); i++) {
+          os << (i == 0 ? "\n" : ",\n") << std::string(indent + 2, ' ');
+          items_[i].write(os, indent + 2);
+        }
+        os << (items_.empty() ? "" : "\n" + std::string(indent, ' ')) << "]";
+        break;
+      case Kind::OBJECT: {
+        os << "{";
+        bool first = true;
+        for (auto& member : members_) {
+          os << (first ? "\n" : ",\n") << std::string(indent + 2, ' ');
+          writeString(os, member.first);
+          os << ": ";
+          member.second.write(os, indent + 2);
+          first = false;
+        }
+        os << (members_.empty() ? "" : "\n" + std::string(indent, ' ')) << "}";
+        break;
+      }
+    }
+  }
+
+ private:
+  Kind kind_ = Kind::NUL;
+  bool bool_ = false;
+  double number_ = 0;
+  std::string string_;
+  std::vector<JsonValue> items_;
+  std::map<std::string, JsonValue> members_;
+
+  static void skipSpace(const std::string& text, size_t& pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t')) pos++;
+  }
+
+  static bool parseValue(const std::string& text, size_t& pos, JsonValue& value) {
+    skipSpace(text, pos);
+    if (pos >= text.size()) return false;
+
+    const char c = text[pos];
+    if (c == '{') {
+      value = object();
+      pos++;
+      skipSpace(text, pos);
+      if (pos < text.size() && text[pos] == '}') {
+        pos++;
+        return true;
+      }
+      while (true) {
+        std::string key;
+        skipSpace(text, pos);
+        if (!parseString(text, pos, key)) return false;
+        skipSpace(text, pos);
+        if (pos >= text.size() || text[pos++] != ':') return false;
+        if (!parseValue(text, pos, value.members_[key])) return false;
+        skipSpace(text, pos);
+        if (pos >= text.size()) return false;
+        if (text[pos] == ',') {
+          pos++;
+        } else if (text[pos++] == '}') {
+          return true;
+        } else {
+          return false;
+        }
+      }
+    }
+    if (c == '[') {
+      value = array();
+      pos++;
+      skipSpace(text, pos);
+      if (pos < text.size() && text[pos] == ']') {
+        pos++;
+        return true;
+      }
+      while (true) {
+        value.items_.emplace_back();
+        if (!parseValue(text, pos, value.items_.back())) return false;
+        skipSpace(text, pos);
+        if (pos >= text.size()) return false;
+        if (text[pos] == ',') {
+          pos++;
+        } else if (text[pos++] == ']') {
+          return true;
+        } else {
+          return false;
+        }
+      }
+    }
+    if (c == '"') {
+      value.kind_ = Kind::STRING;
+      return parseString(text, pos, value.string_);
+    }
+    if (text.compare(pos, 4, "true") == 0) {
+      value = JsonValue(true);
+      pos += 4;
+      return true;
+    }
+    if (text.compare(pos, 5, "false") == 0) {
+      value = JsonValue(false);
+      pos += 5;
+      return true;
+    }
+    if (text.compare(pos, 4, "null") == 0) {
+      value = JsonValue();
+      pos += 4;
+      return true;
+    }
+
+    char* end = nullptr;
+    const double number = strtod(text.c_str() + pos, &end);
+    if (end == text.c_str() + pos) return false;
+    pos = static_cast<size_t>(end - text.c_str());
+    value = JsonValue(number);
+    return true;
+  }
+
+  // Escapes other than \uXXXX outside the ASCII range are kept as is, the tools only deal in ASCII
+  static bool parseString(const std::string& text, size_t& pos, std::string& out) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    pos++;
+    out.clear();
+    while (pos < text.size() && text[pos] != '"') {
+      char c = text[pos++];
+      if (c == '\\') {
+        if (pos >= text.size()) return false;
+        c = text[pos++];
+        switch (c) {
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case 'b':
+            c = '\b';
+            break;
+          case 'f':
+            c = '\f';
+            break;
+          case 'u': {
+            if (pos + 4 > text.size()) return false;
+            const unsigned long code = strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+            pos += 4;
+            c = code < 0x80 ? static_cast<char>(code) : '?';
+            break;
+          }
+          default:
+            break;
+        }
+      }
+      out.push_back(c);
+    }
+    if (pos >= text.size()) return false;
+    pos++;
+    return true;
+  }
+
+  static void writeString(std::ostream& os, const std::string& string) {
+    os << '"';
+    for (char c : string) {
+      switch (c) {
+        case '"':
+          os << "\\\"";
+          break;
+        case '\\':
+          os << "\\\\";
+          break;
+        case '\n':
+          os << "\\n";
+          break;
+        case '\t':
+          os << "\\t";
+          break;
+        default:
+          os << c;
+      }
+    }
+    os << '"';
+  }
+};
+
+}  // namespace XMR
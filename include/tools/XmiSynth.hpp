@@ -0,0 +1,307 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmiSynth.hpp
+ * @brief: Synthetic Papyrus style XMI model generator for scale testing
+ *
+ ***********************************************************/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace XMR {
+
+struct SynthOptions {
+  std::string modelName_ = "SynthModel";
+  unsigned depth_ = 1;               // levels of nested packages
+  unsigned packagesPerLevel_ = 1;    // packages in the model and in every package above the last level
+  unsigned classesPerPackage_ = 10;  // classes in every package at every level
+  unsigned attributesPerClass_ = 4;
+  unsigned operationsPerClass_ = 2;
+  unsigned paramsPerOperation_ = 2;
+  unsigned generalizationFanIn_ = 0;  // base classes of every class that has enough earlier classes
+  double hardDependencyDensity_ = 0.2;  // chance an attribute or param is a complete copy of another class
+  double softDependencyDensity_ = 0.2;  // chance an attribute or param is a nilable or unlimited reference to another class
+  unsigned cycles_ = 0;                 // hard dependency cycles to inject, makes the model invalid for C++
+  uint64_t seed_ = 1;
+};
+
+// Writes Papyrus style XMI for a model shaped by SynthOptions. The same options and seed always
+// produce the same bytes, on any platform, so generated inputs can be used as fixed corpora.
+// Hard dependencies and generalizations only ever point to classes earlier in the document so the
+// hard dependency graph is acyclic unless cycles are explicitly requested. Soft dependencies may
+// point anywhere.
+class XmiSynth {
+ public:
+  explicit XmiSynth(const SynthOptions& options) : options_(options), rng_(options.seed_) { plan(); }
+
+  size_t numPackages() const { return packages_.size(); }
+  size_t numClasses() const { return classes_.size(); }
+
+  void write(std::ostream& os) const {
+    std::string out;
+    out.reserve(1 << 20);
+    out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out += "<uml:Model xmi:version=\"20131001\" xmlns:xmi=\"http://www.omg.org/spec/XMI/20131001\" xmlns:uml=\"http://www.eclipse.org/uml2/5.0.0/UML\"";
+    out += " xmi:id=\"" + id(0, 'M') + "\" name=\"" + options_.modelName_ + "\">\n";
+    for (size_t i = 0; i < packages_.size(); i++) {
+      if (packages_[i].parent_ == NO_PARENT) writePackage(out, os, i, 1);
+    }
+    out += "</uml:Model>\n";
+    os << out;
+  }
+
+  std::string str() const {
+    std::ostringstream os;
+    write(os);
+    return os.str();
+  }
+
+ private:
+  static constexpr size_t NO_PARENT = SIZE_MAX;
+  static constexpr size_t FLUSH_SIZE = 1 << 20;
+  static constexpr const char* PRIMITIVES[] = {"Integer", "Boolean", "Real", "String"};
+
+  enum class Dependency { PRIMITIVE, HARD, SOFT_NILABLE, SOFT_UNLIMITED };
+
+  struct Typed {
+    Dependency dependency_;
+    size_t target_;  // class index or primitive index
+  };
+
+  struct Operation {
+    std::vector<Typed> params_;
+    bool hasReturn_;
+    Typed return_;
+  };
+
+  struct Class {
+    size_t package_;
+    std::vector<size_t> generals_;
+    std::vector<Typed> attributes_;
+    std::vector<Operation> operations_;
+  };
+
+  struct Package {
+    size_t parent_;
+    std::vector<size_t> packages_;
+    std::vector<size_t> classes_;
+  };
+
+  // splitmix64, used instead of <random> distributions as those differ between standard libraries
+  struct Rng {
+    uint64_t state_;
+    explicit Rng(uint64_t seed) : state_(seed) {}
+    uint64_t next() {
+      uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+    size_t below(size_t bound) { return bound == 0 ? 0 : static_cast<size_t>(next() % bound); }
+    double unit() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+  };
+
+  SynthOptions options_;
+  Rng rng_;
+  std::vector<Package> packages_;
+  std::vector<Class> classes_;
+
+  void planPackage(size_t parent, unsigned level) {
+    const size_t index = packages_.size();
+    packages_.push_back({parent, {}, {}});
+    if (parent != NO_PARENT) packages_[parent].packages_.push_back(index);
+
+    for (unsigned i = 0; i < options_.classesPerPackage_; i++) {
+      packages_[index].classes_.push_back(classes_.size());
+      classes_.push_back({index, {}, {}, {}});
+    }
+
+    if (level < options_.depth_) {
+      for (unsigned i = 0; i < options_.packagesPerLevel_; i++) {
+        planPackage(index, level + 1);
+      }
+    }
+  }
+
+  Typed pickType(size_t self) {
+    const double roll = rng_.unit();
+    if (self > 0 && roll < options_.hardDependencyDensity_) {
+      return {Dependency::HARD, rng_.below(self)};
+    }
+    if (roll < options_.hardDependencyDensity_ + options_.softDependencyDensity_) {
+      return {rng_.below(2) == 0 ? Dependency::SOFT_NILABLE : Dependency::SOFT_UNLIMITED, rng_.below(classes_.size())};
+    }
+    return {Dependency::PRIMITIVE, rng_.below(std::size(PRIMITIVES))};
+  }
+
+  void plan() {
+    if (options_.depth_ > 0) {
+      for (unsigned i = 0; i < options_.packagesPerLevel_; i++) {
+        planPackage(NO_PARENT, 1);
+      }
+    }
+
+    for (size_t c = 0; c < classes_.size(); c++) {
+      Class& cls = classes_[c];
+      for (unsigned g = 0; g < options_.generalizationFanIn_ && g < c; g++) {
+        size_t general = rng_.below(c);
+        if (std::find(cls.generals_.begin(), cls.generals_.end(), general) == cls.generals_.end()) {
+          cls.generals_.push_back(general);
+        }
+      }
+      for (unsigned a = 0; a < options_.attributesPerClass_; a++) {
+        cls.attributes_.push_back(pickType(c));
+      }
+      for (unsigned o = 0; o < options_.operationsPerClass_; o++) {
+        Operation op;
+        for (unsigned p = 0; p < options_.paramsPerOperation_; p++) {
+          op.params_.push_back(pickType(c));
+        }
+        op.hasReturn_ = rng_.below(2) == 0;
+        op.return_ = pickType(c);
+        cls.operations_.push_back(op);
+      }
+    }
+
+    // A pair of classes holding complete copies of each other is the smallest hard cycle
+    for (unsigned i = 0; i < options_.cycles_ && classes_.size() > 1; i++) {
+      size_t a = rng_.below(classes_.size());
+      size_t b = rng_.below(classes_.size() - 1);
+      if (b >= a) b++;
+      classes_[a].attributes_.push_back({Dependency::HARD, b});
+      classes_[b].attributes_.push_back({Dependency::HARD, a});
+    }
+  }
+
+  // Papyrus ids are an underscore followed by 22 url safe base64 characters
+  static std::string id(uint64_t value, char kind) {
+    static const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    uint64_t mixed = value * 0x9e3779b97f4a7c15ULL + static_cast<uint64_t>(kind);
+    std::string result = "_";
+    result.push_back(kind);
+    for (int i = 0; i < 21; i++) {
+      result.push_back(ALPHABET[(i < 10 ? mixed >> (i * 6) : value >> ((i - 10) * 6)) & 63]);
+    }
+    return result;
+  }
+
+  static void indent(std::string& out, unsigned level) { out.append(level * 2, ' '); }
+
+  void writeType(std::string& out, const Typed& typed, unsigned level) const {
+    if (typed.dependency_ == Dependency::PRIMITIVE) {
+      indent(out, level);
+      out += "<type xmi:type=\"uml:PrimitiveType\" href=\"pathmap://UML_LIBRARIES/UMLPrimitiveTypes.library.uml#";
+      out += PRIMITIVES[typed.target_];
+      out += "\"/>\n";
+    }
+  }
+
+  void writeMultiplicity(std::string& out, const Typed& typed, const std::string& owner, unsigned level) const {
+    if (typed.dependency_ == Dependency::SOFT_NILABLE) {
+      indent(out, level);
+      out += "<lowerValue xmi:type=\"uml:LiteralInteger\" xmi:id=\"" + owner + "L\"/>\n";
+    } else if (typed.dependency_ == Dependency::SOFT_UNLIMITED) {
+      indent(out, level);
+      out += "<lowerValue xmi:type=\"uml:LiteralInteger\" xmi:id=\"" + owner + "L\" value=\"1\"/>\n";
+      indent(out, level);
+      out += "<upperValue xmi:type=\"uml:LiteralUnlimitedNatural\" xmi:id=\"" + owner + "U\" value=\"*\"/>\n";
+    }
+  }
+
+  // Opens an element that may be typed by a class and writes its children, the caller closes it
+  void writeTypedBody(std::string& out, const Typed& typed, const std::string& elementId, unsigned level) const {
+    if (typed.dependency_ != Dependency::PRIMITIVE) {
+      out += " type=\"" + id(typed.target_, 'C') + "\"";
+    }
+    out += ">\n";
+    writeType(out, typed, level + 1);
+    writeMultiplicity(out, typed, elementId, level + 1);
+  }
+
+  void writeClass(std::string& out, size_t c, unsigned level) const {
+    const Class& cls = classes_[c];
+    const std::string classId = id(c, 'C');
+    indent(out, level);
+    out += "<packagedElement xmi:type=\"uml:Class\" xmi:id=\"" + classId + "\" name=\"Class" + std::to_string(c) + "\">\n";
+
+    for (size_t g = 0; g < cls.generals_.size(); g++) {
+      indent(out, level + 1);
+      out += "<generalization xmi:type=\"uml:Generalization\" xmi:id=\"" + classId + "G" + std::to_string(g) + "\" general=\"" + id(cls.generals_[g], 'C') + "\"/>\n";
+    }
+
+    for (size_t a = 0; a < cls.attributes_.size(); a++) {
+      const std::string attributeId = classId + "A" + std::to_string(a);
+      indent(out, level + 1);
+      out += "<ownedAttribute xmi:type=\"uml:Property\" xmi:id=\"" + attributeId + "\" name=\"attribute" + std::to_string(a) + "\" visibility=\"" + (a % 2 == 0 ? "private" : "public") + "\"";
+      writeTypedBody(out, cls.attributes_[a], attributeId, level + 1);
+      indent(out, level + 1);
+      out += "</ownedAttribute>\n";
+    }
+
+    for (size_t o = 0; o < cls.operations_.size(); o++) {
+      const Operation& op = cls.operations_[o];
+      const std::string operationId = classId + "O" + std::to_string(o);
+      indent(out, level + 1);
+      out += "<ownedOperation xmi:type=\"uml:Operation\" xmi:id=\"" + operationId + "\" name=\"operation" + std::to_string(o) + "\">\n";
+      for (size_t p = 0; p < op.params_.size(); p++) {
+        const std::string paramId = operationId + "P" + std::to_string(p);
+        indent(out, level + 2);
+        out += "<ownedParameter xmi:type=\"uml:Parameter\" xmi:id=\"" + paramId + "\" name=\"param" + std::to_string(p) + "\"";
+        writeTypedBody(out, op.params_[p], paramId, level + 2);
+        indent(out, level + 2);
+        out += "</ownedParameter>\n";
+      }
+      if (op.hasReturn_) {
+        const std::string returnId = operationId + "R";
+        indent(out, level + 2);
+        out += "<ownedParameter xmi:type=\"uml:Parameter\" xmi:id=\"" + returnId + "\" name=\"return\" direction=\"return\"";
+        writeTypedBody(out, op.return_, returnId, level + 2);
+        indent(out, level + 2);
+        out += "</ownedParameter>\n";
+      }
+      indent(out, level + 1);
+      out += "</ownedOperation>\n";
+    }
+
+    indent(out, level);
+    out += "</packagedElement>\n";
+  }
+
+  void writePackage(std::string& out, std::ostream& os, size_t p, unsigned level) const {
+    const Package& package = packages_[p];
+    indent(out, level);
+    out += "<packagedElement xmi:type=\"uml:Package\" xmi:id=\"" + id(p, 'P') + "\" name=\"Package" + std::to_string(p) + "\">\n";
+    for (auto& c : package.classes_) {
+      writeClass(out, c, level + 1);
+      if (out.size() > FLUSH_SIZE) {
+        os << out;
+        out.clear();
+      }
+    }
+    for (auto& nested : package.packages_) {
+      writePackage(out, os, nested, level + 1);
+    }
+    indent(out, level);
+    out += "</packagedElement>\n";
+  }
+};
+
+}  // namespace XMR
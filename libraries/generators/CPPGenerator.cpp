@@ -20,27 +20,35 @@
 #include "generators/CPPGenerator.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <queue>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 
-#include "generators/Graph.hpp"
-
 using namespace std;
 
-static vector<string> currentScope_;
-static unordered_map<string, bool> generatedSymbols;
-static unordered_map<string, vector<string>> idNameMap;
-static unordered_set<string> noNoNames = {"delete", "new"};
+static const unordered_set<string> noNoNames = {"delete", "new"};
 namespace XMR {
 
-string generateQualifedName(string fullName) {
+bool generated(const CPPRenderContext& context, IdHandle handle) {
+  const LoweredModel::Index index = context.model_.find(handle);
+  if (index == LoweredModel::NONE) return false;
+  const ModuleState* state = context.view_.annotation(context.model_.module(index).module_);
+  return state != nullptr && state->generated_;
+}
+
+// Name of a scope relative to the current scope, empty if it is the current scope
+string relativeName(const CPPRenderContext& context, const Scope& scope) {
   string qualifiedName;
-  const size_t MIN_LENGTH = min(idNameMap[fullName].size(), currentScope_.size());
+  const size_t MIN_LENGTH = min(scope.size(), context.currentScope_.size());
 
   for (size_t j = 0; j < MIN_LENGTH; j++) {
-    string subPath = idNameMap[fullName][j];
-    if (subPath == currentScope_[j]) {
+    string subPath(scope[j]);
+    if (subPath == context.currentScope_[j]) {
       continue;
     } else {
       // Check if qualified name is starting in the global namespace
@@ -60,9 +68,9 @@ string generateQualifedName(string fullName) {
 
   // Check if there is any remaining names in fully qualified path
   // given that current scope was the min length
-  if (MIN_LENGTH < idNameMap[fullName].size()) {
-    for (size_t j = MIN_LENGTH; j < idNameMap[fullName].size(); j++) {
-      string subPath = idNameMap[fullName][j];
+  if (MIN_LENGTH < scope.size()) {
+    for (size_t j = MIN_LENGTH; j < scope.size(); j++) {
+      string subPath(scope[j]);
       // If empty append global namespace
       if (qualifiedName.empty()) {
         qualifiedName = "::" + subPath;
@@ -72,6 +80,11 @@ string generateQualifedName(string fullName) {
     }
   }
 
+  return qualifiedName;
+}
+
+string generateQualifedName(const CPPRenderContext& context, IdHandle handle, string_view fullName) {
+  string qualifiedName = relativeName(context, context.ids_.scope(handle));
   if (qualifiedName.empty()) {
     qualifiedName = fullName.back();
   }
@@ -79,6 +92,30 @@ string generateQualifedName(string fullName) {
   return qualifiedName;
 }
 
+// C++ type of a primitive and the header declaring it, if any
+struct CPPPrimitive {
+  const char* name_;
+  const char* header_;
+};
+
+// By Primitive, the fallback for primitives no library names is int
+constexpr array<CPPPrimitive, NUM_PRIMITIVES> cppPrimitives = {{
+    {"int", nullptr},             // NONE
+    {"bool", nullptr},            // BOOLEAN
+    {"int", nullptr},             // INTEGER
+    {"double", nullptr},          // REAL
+    {"std::string", "string"},    // STRING
+    {"int", nullptr},             // UNLIMITED_NATURAL
+    {"std::int8_t", "cstdint"},   // BYTE
+    {"char", nullptr},            // CHAR
+    {"short", nullptr},           // SHORT
+    {"std::int64_t", "cstdint"},  // LONG
+    {"float", nullptr},           // FLOAT
+    {"int", nullptr},             // UNKNOWN
+}};
+
+const CPPPrimitive& primitiveType(Primitive primitive) { return cppPrimitives[static_cast<size_t>(primitive)]; }
+
 bool checkOperatorName(char* name) {
   // lookup no no phrased for c++ operator names, i.e. new delete
   if (noNoNames.contains(name)) {
@@ -88,347 +125,104 @@ bool checkOperatorName(char* name) {
 
   return true;
 }
-bool generateOperator(std::ostream& os, Operator* op) {
-  if (checkOperatorName(op->name_)) {
-    if (op->returnType_) {
-      if (op->returnType_->type_->isPrimitive_) {
-        std::string hash = "#";
-        size_t index = strcspn(op->returnType_->type_->type_, hash.c_str());
-        std::string type = std::to_string(op->returnType_->type_->type_[index]);
-        if (type == "Boolean") {
-          os << "bool ";
-        } else if (type == "Real") {
-          os << "double ";
-        } else {
-          os << "int ";
-        }
-
-      } else {
-        // lookup type name of id
-        string qualifiedName;
-        const size_t MIN_LENGTH = min(idNameMap[op->returnType_->type_->type_].size(), currentScope_.size());
-        bool global = true;
-        for (size_t i = 0; i < MIN_LENGTH; i++) {
-          string subPath = idNameMap[op->returnType_->type_->type_][i];
-          if (subPath == currentScope_[i]) {
-            continue;
-          } else {
-            // Check if qualified name is starting in the global namespace
-            if (qualifiedName.empty() && i == 0) {
-              qualifiedName = "::" + subPath;
-            }
-            // Check if first namespace to be added
-            else if (qualifiedName.empty() && i != 0) {
-              qualifiedName = subPath;
-            }
-            // Append subpath to qualified name
-            else {
-              qualifiedName = qualifiedName + "::" + subPath;
-            }
-          }
-        }
-
-        // Check if there is any remaining names in fully qualified path
-        // given that current scope was the min length
-        if (MIN_LENGTH < idNameMap[op->returnType_->type_->type_].size()) {
-          for (size_t i = MIN_LENGTH; i < idNameMap[op->returnType_->type_->type_].size(); i++) {
-            string subPath = idNameMap[op->returnType_->type_->type_][i];
-            // If empty append global namespace
-            if (qualifiedName.empty()) {
-              qualifiedName = "::" + subPath;
-            } else {
-              qualifiedName = qualifiedName + "::" + subPath;
-            }
-          }
-        }
-
-        // If this is true, the dependency class is the class itself.
-        if (qualifiedName.empty()) {
-          // Last string in the vector is the name of the class
-          qualifiedName = currentScope_.back();
-        }
-
-        os << qualifiedName;
-
-        // if (!generatedSymbols[op->params_[i]->type_->type_]) {
-        //   // inject a pointer as usage of incomplete type in class def not
-        //   // permissible in C++
-        //   //!@todo: this feels icky
-        //   os << "*";
-        // }
-      }
-
-      if (op->returnType_->nilable_) {
-        os << "*";
-      }
-
-      if (op->returnType_->unlimited_) {
-        os << "*";
-      }
-
-      // Check if multiplicity between 2 - 6
-      if (!op->returnType_->unlimited_ && op->returnType_->multiplicity_ > 1) {
-        os << "[ " << op->returnType_->multiplicity_ << " ] ";
-      }
-
-    } else {
-      os << "void";
-    }
-
-    os << " " << op->name_ << "(";
-
-    if (!op->params_.empty()) {
-      for (size_t i = 0; i < op->params_.size() - 1; i++) {
-        if (op->params_[i]->type_->isPrimitive_) {
-          std::string hash = "#";
-          size_t index = strcspn(op->params_[i]->type_->type_, hash.c_str());
-          std::string type = std::to_string(op->params_[i]->type_->type_[index]);
-          if (type == "Boolean") {
-            os << "bool ";
-          } else if (type == "Real") {
-            os << "double ";
-          } else {
-            os << "int ";
-          }
-
-        } else {
-          // lookup type name of id
-          string qualifiedName;
-          const size_t MIN_LENGTH = min(idNameMap[op->params_[i]->type_->type_].size(), currentScope_.size());
-          for (size_t j = 0; j < MIN_LENGTH; j++) {
-            string subPath = idNameMap[op->params_[i]->type_->type_][j];
-            if (subPath == currentScope_[j]) {
-              continue;
-            } else {
-              // Check if qualified name is starting in the global namespace
-              if (qualifiedName.empty() && j == 0) {
-                qualifiedName = "::" + subPath;
-              }
-              // Check if first namespace to be added
-              else if (qualifiedName.empty() && j != 0) {
-                qualifiedName = subPath;
-              }
-              // Append subpath to qualified name
-              else {
-                qualifiedName = qualifiedName + "::" + subPath;
-              }
-            }
-          }
-
-          // Check if there is any remaining names in fully qualified path
-          // given that current scope was the min length
-          if (MIN_LENGTH < idNameMap[op->params_[i]->type_->type_].size()) {
-            for (size_t j = MIN_LENGTH; j < idNameMap[op->params_[i]->type_->type_].size(); j++) {
-              string subPath = idNameMap[op->params_[i]->type_->type_][j];
-              // If empty append global namespace
-              if (qualifiedName.empty()) {
-                qualifiedName = "::" + subPath;
-              } else {
-                qualifiedName = qualifiedName + "::" + subPath;
-              }
-            }
-          }
-
-          // If this is true, the dependency class is the class itself.
-          if (qualifiedName.empty()) {
-            qualifiedName = op->params_[i]->name_;
-          }
-
-          os << qualifiedName;
-
-          // if (!generatedSymbols[op->params_[i]->type_->type_]) {
-          //   // inject a pointer as usage of incomplete type in class def not
-          //   // permissible in C++
-          //   //!@todo: this feels icky
-          //   os << "*";
-          // }
-        }
-
-        if (op->params_[i]->nilable_) {
-          os << "*";
-        }
-
-        if (op->params_[i]->unlimited_) {
-          os << "*";
-        }
 
-        os << " " << op->params_[i]->name_;
-
-        // Check if multiplicity between 2 - 6
-        if (!op->params_[i]->unlimited_ && op->params_[i]->multiplicity_ > 1) {
-          os << "[ " << op->params_[i]->multiplicity_ << " ] ";
-        }
-
-        os << ", ";
-      }
-
-      if (op->params_[op->params_.size() - 1]->type_->isPrimitive_) {
-        std::string hash = "#";
-        size_t index = strcspn(op->params_[op->params_.size() - 1]->type_->type_, hash.c_str());
-        std::string type = std::to_string(op->params_[op->params_.size() - 1]->type_->type_[index]);
-        if (type == "Boolean") {
-          os << "bool ";
-        } else if (type == "Real") {
-          os << "double ";
-        } else {
-          os << "int ";
-        }
-
-      } else {
-        // lookup type name of id
-        string qualifiedName;
-        const size_t MIN_LENGTH = min(idNameMap[op->params_[op->params_.size() - 1]->type_->type_].size(), currentScope_.size());
-
-        for (size_t i = 0; i < MIN_LENGTH; i++) {
-          string subPath = idNameMap[op->params_[op->params_.size() - 1]->type_->type_][i];
-          if (subPath == currentScope_[i]) {
-            continue;
-          } else {
-            // Check if qualified name is starting in the global namespace
-            if (qualifiedName.empty() && i == 0) {
-              qualifiedName = "::" + subPath;
-            }
-            // Check if first namespace to be added
-            else if (qualifiedName.empty() && i != 0) {
-              qualifiedName = subPath;
-            }
-            // Append subpath to qualified name
-            else {
-              qualifiedName = qualifiedName + "::" + subPath;
-            }
-          }
-        }
+/**
+ * Generates the type a param, attribute or return type names, without its multiplicity
+ * @param[in] type resolved use of the type
+ * @param[in] self name to use when the type names the class being generated
+ */
+void generateType(const CPPRenderContext& context, std::ostream& os, const TypeUse& type, string_view self) {
+  if (type.isPrimitive()) {
+    os << primitiveType(type.primitive_).name_ << " ";
+    return;
+  }
 
-        // Check if there is any remaining names in fully qualified path
-        // given that current scope was the min length
-        if (MIN_LENGTH < idNameMap[op->params_[op->params_.size() - 1]->type_->type_].size()) {
-          for (size_t i = MIN_LENGTH; i < idNameMap[op->params_[op->params_.size() - 1]->type_->type_].size(); i++) {
-            string subPath = idNameMap[op->params_[op->params_.size() - 1]->type_->type_][i];
-            // If empty append global namespace
-            if (qualifiedName.empty()) {
-              qualifiedName = "::" + subPath;
-            } else {
-              qualifiedName = qualifiedName + "::" + subPath;
-            }
-          }
-        }
+  string qualifiedName = relativeName(context, *type.scope_);
+  // If this is true, the dependency class is the class itself.
+  if (qualifiedName.empty()) {
+    qualifiedName = self;
+  }
+  os << qualifiedName;
+}
 
-        // If this is true, the dependency class is the class itself.
-        if (qualifiedName.empty()) {
-          qualifiedName = op->params_[op->params_.size() - 1]->name_;
-        }
+// Nilable and unlimited uses are pointers
+void generatePointers(std::ostream& os, const TypeUse& type) {
+  if (type.optional_) {
+    os << "*";
+  }
 
-        os << qualifiedName;
-        if (!generatedSymbols[op->params_[op->params_.size() - 1]->type_->type_]) {
-          // inject a pointer as usage of incomplete type in class def not
-          // permissible in C++
-          //!@todo: this feels icky
-          os << "*";
-        }
-      }
+  if (type.many_) {
+    os << "*";
+  }
+}
 
-      if (op->params_[op->params_.size() - 1]->nilable_) {
-        os << "*";
-      }
+/**
+ * Generates an operator of the class being rendered
+ * @param[in] owner class to qualify the name with for a definition outside the class, empty inside it
+ * @param[in] body {} to define the operator, ; to only declare it
+ */
+bool generateOperator(const CPPRenderContext& context, std::ostream& os, const LoweredOperator& op, string_view owner, const char* body) {
+  if (!checkOperatorName(op.operator_->name_)) {
+    return false;
+  }
 
-      if (op->params_[op->params_.size() - 1]->unlimited_) {
-        os << "*";
-      }
-      os << " " << op->params_[op->params_.size() - 1]->name_;
+  const LoweredParam* returnType = context.model_.returnType(op);
+  if (returnType != nullptr) {
+    // Last string in the current scope is the name of the class
+    generateType(context, os, returnType->type_, context.currentScope_.back());
+    generatePointers(os, returnType->type_);
 
-      // Check if multiplicity between 2 - 6
-      if (!op->params_[op->params_.size() - 1]->unlimited_ && op->params_[op->params_.size() - 1]->multiplicity_ > 1) {
-        os << "[ " << op->params_[op->params_.size() - 1]->multiplicity_ << " ] ";
-      }
+    // Check if multiplicity between 2 - 6
+    if (returnType->type_.extent_ > 0) {
+      os << "[ " << returnType->type_.extent_ << " ] ";
     }
 
-    //
-    os << " ){}" << endl;
-    return true;
   } else {
-    return false;
+    os << "void";
   }
-}
 
-bool generateAttribute(std::ostream& os, Attribute* attribute) {
-  if (attribute->type_->isPrimitive_) {
-    std::string hash = "#";
-    size_t index = strcspn(attribute->type_->type_, hash.c_str());
-    std::string type = std::to_string(attribute->type_->type_[index]);
-    if (type == "Boolean") {
-      os << "bool ";
-    } else if (type == "Real") {
-      os << "double ";
-    } else {
-      os << "int ";
-    }
+  os << " ";
+  if (!owner.empty()) {
+    os << owner << "::";
+  }
+  os << op.operator_->name_ << "(";
 
-  } else {
-    // lookup type name of id
-    string qualifiedName;
-    const size_t MIN_LENGTH = min(idNameMap[attribute->type_->type_].size(), currentScope_.size());
-
-    for (size_t i = 0; i < MIN_LENGTH; i++) {
-      string subPath = idNameMap[attribute->type_->type_][i];
-      if (subPath == currentScope_[i]) {
-        continue;
-      } else {
-        // Check if qualified name is starting in the global namespace
-        if (qualifiedName.empty() && i == 0) {
-          qualifiedName = "::" + subPath;
-        }
-        // Check if first namespace to be added
-        else if (qualifiedName.empty() && i != 0) {
-          qualifiedName = subPath;
-        }
-        // Append subpath to qualified name
-        else {
-          qualifiedName = qualifiedName + "::" + subPath;
-        }
-      }
+  std::span<const LoweredParam> params = context.model_.params(op);
+  for (size_t i = 0; i < params.size(); i++) {
+    const TypeUse& type = params[i].type_;
+    generateType(context, os, type, params[i].param_->name_);
+    if (i + 1 == params.size() && !type.isPrimitive() && !generated(context, type.handle_)) {
+      // inject a pointer as usage of incomplete type in class def not
+      // permissible in C++
+      //!@todo: this feels icky
+      os << "*";
     }
+    generatePointers(os, type);
 
-    // Check if there is any remaining names in fully qualified path
-    // given that current scope was the min length
-    if (MIN_LENGTH < idNameMap[attribute->type_->type_].size()) {
-      for (size_t i = MIN_LENGTH; i < idNameMap[attribute->type_->type_].size(); i++) {
-        string subPath = idNameMap[attribute->type_->type_][i];
-        // If empty append global namespace
-        if (qualifiedName.empty()) {
-          qualifiedName = "::" + subPath;
-        } else {
-          qualifiedName = qualifiedName + "::" + subPath;
-        }
-      }
-    }
+    os << " " << params[i].param_->name_;
 
-    // If this is true, the dependency class is the class itself.
-    if (qualifiedName.empty()) {
-      // Last string in the vector is the name of the class
-      qualifiedName = currentScope_.back();
+    // Check if multiplicity between 2 - 6
+    if (type.extent_ > 0) {
+      os << "[ " << type.extent_ << " ] ";
     }
 
-    os << qualifiedName;
-
-    // if (!generatedSymbols[attribute->type_->type_] && !attribute->nilable_) {
-    //   // inject a pointer as usage of incomplete type in class def not
-    //   // permissible in C++
-    //   //!@todo: this feels icky
-    //   os << "*";
-    // }
+    if (i + 1 < params.size()) {
+      os << ", ";
+    }
   }
 
-  if (attribute->nilable_) {
-    os << "*";
-  }
+  os << " )" << body << endl;
+  return true;
+}
 
-  if (attribute->unlimited_) {
-    os << "*";
-  }
+bool generateAttribute(const CPPRenderContext& context, std::ostream& os, const LoweredAttribute& attribute) {
+  // Last string in the current scope is the name of the class
+  generateType(context, os, attribute.type_, context.currentScope_.back());
+  generatePointers(os, attribute.type_);
 
-  os << " " << attribute->name_;
-  if (!attribute->unlimited_ && attribute->multiplicity_ > 1) {
-    os << "[ " << attribute->multiplicity_ << " ] ";
+  os << " " << attribute.attribute_->name_;
+  if (attribute.type_.extent_ > 0) {
+    os << "[ " << attribute.type_.extent_ << " ] ";
   }
 
   os << ";" << endl;
@@ -436,67 +230,77 @@ bool generateAttribute(std::ostream& os, Attribute* attribute) {
   return true;
 }
 
-bool generateModule(std::ostream& os, ModuleNode* module) {
+bool renderModule(CPPRenderContext& context, std::ostream& os, LoweredModel::Index index) {
   bool result = true;
-  os << "// Forward Decl" << endl;
+  const LoweredModel::Module& lowered = context.model_.module(index);
+  const ModuleNode* module = lowered.module_;
+  // Hoisted forward declarations are all generated before the first class
+  if (!context.hoisted_) {
+    os << "// Forward Decl" << endl;
+
+    // Only forward declare soft dependencies that haven't been generated
+    // In C++ hard dependencies must be resolved with topological sort of class generation order.
+    for (IdHandle dependency : context.model_.softDependencies(index)) {
+      if (!generated(context, dependency) && dependency != lowered.handle_) {
+        vector<string> closeBraces;
+        const Scope& scope = context.ids_.scope(dependency);
+        const size_t MIN_LENGTH = min(scope.size() - 1, context.currentScope_.size());
+        for (size_t j = 0; j < MIN_LENGTH; j++) {
+          if (context.currentScope_[j] != scope[j]) {
+            closeBraces.push_back("}");
+            os << "namespace " << scope[j] << " { " << endl;
+            context.currentScope_.emplace_back(scope[j]);
+          }
+        }
 
-  // Only forward declare soft dependencies that haven't been generated
-  // In C++ hard dependencies must be resolved with topological sort of class generation order.
-  vector<string> deps = module->getSoftDependencies();
-  for (size_t i = 0; i < deps.size(); i++) {
-    if (!generatedSymbols[deps[i]] && (deps[i] != module->id_)) {
-      vector<string> closeBraces;
-      const size_t MIN_LENGTH = min(idNameMap[deps[i]].size() - 1, currentScope_.size());
-      for (size_t j = 0; j < MIN_LENGTH; j++) {
-        if (currentScope_[j] != idNameMap[deps[i]][j]) {
+        for (size_t j = MIN_LENGTH; j < scope.size() - 1; j++) {
           closeBraces.push_back("}");
-          os << "namespace " << idNameMap[deps[i]][j] << " { " << endl;
+          os << "namespace " << scope[j] << " { " << endl;
+          context.currentScope_.emplace_back(scope[j]);
         }
-      }
 
-      for (size_t j = MIN_LENGTH; j < idNameMap[deps[i]].size() - 1; j++) {
-        closeBraces.push_back("}");
-        os << "namespace " << idNameMap[deps[i]][j] << " { " << endl;
-        currentScope_.push_back(idNameMap[deps[i]][j]);
-      }
+        os << "class " << scope.back() << ";" << endl;
 
-      os << "class " << idNameMap[deps[i]][idNameMap[deps[i]].size() - 1] << ";" << endl;
-
-      for (size_t j = 0; j < closeBraces.size(); j++) {
-        os << closeBraces[j];
-        closeBraces.pop_back();
-        currentScope_.pop_back();
+        while (!closeBraces.empty()) {
+          os << closeBraces.back();
+          closeBraces.pop_back();
+          context.currentScope_.pop_back();
+        }
       }
     }
-  }
 
-  os << endl;
+    os << endl;
+  }
 
   vector<string> closeBraces;
-  const size_t MIN_LENGTH = min(module->fullyQualified_.size() - 1, currentScope_.size());
-  for (size_t j = 0; j < MIN_LENGTH; j++) {
-    if (currentScope_[j] != module->fullyQualified_[j]) {
-      closeBraces.push_back("}");
-      os << "namespace " << module->fullyQualified_[j] << " { " << endl;
-      currentScope_.push_back(module->fullyQualified_[j]);
+  const Scope& scope = *module->scope_;
+  // Grouped namespaces are already open around the run of modules this is part of
+  if (!context.grouped_) {
+    const size_t MIN_LENGTH = min(scope.size() - 1, context.currentScope_.size());
+    for (size_t j = 0; j < MIN_LENGTH; j++) {
+      if (context.currentScope_[j] != scope[j]) {
+        closeBraces.push_back("}");
+        os << "namespace " << scope[j] << " { " << endl;
+        context.currentScope_.emplace_back(scope[j]);
+      }
     }
-  }
 
-  for (size_t j = MIN_LENGTH; j < module->fullyQualified_.size() - 1; j++) {
-    closeBraces.push_back("}");
-    os << "namespace " << module->fullyQualified_[j] << " { " << endl;
-    currentScope_.push_back(module->fullyQualified_[j]);
+    for (size_t j = MIN_LENGTH; j < scope.size() - 1; j++) {
+      closeBraces.push_back("}");
+      os << "namespace " << scope[j] << " { " << endl;
+      context.currentScope_.emplace_back(scope[j]);
+    }
   }
 
-  os << "class " << module->fullyQualified_[module->fullyQualified_.size() - 1] << endl;
-  currentScope_.push_back(module->name_);
+  os << "class " << scope.back() << endl;
+  context.currentScope_.push_back(module->name_);
 
   // Check for inheritance
   if (!module->generalizations_.empty()) {
     // If only one generate single, else generate n - 1 then generate last one to handle not adding comma
     if (module->generalizations_.size() == 1) {
       os << " : public ";
-      string qualifiedName = generateQualifedName(module->generalizations_[0]);
+      string qualifiedName = generateQualifedName(context, module->generalizationHandles_[0], module->generalizations_[0]);
       os << qualifiedName;
 
     } else {
@@ -504,184 +308,340 @@ bool generateModule(std::ostream& os, ModuleNode* module) {
       os << " : ";
       for (size_t i = 0; i < module->generalizations_.size() - 1; i++) {
         os << "public ";
-        string qualifiedName = generateQualifedName(module->generalizations_[i]);
+        string qualifiedName = generateQualifedName(context, module->generalizationHandles_[i], module->generalizations_[i]);
         os << qualifiedName << ", ";
       }
 
       // Generate the nth qualified name;
       os << "public ";
-      string qualifiedName = generateQualifedName(module->generalizations_[module->generalizations_.size() - 1]);
+      string qualifiedName = generateQualifedName(context, module->generalizationHandles_.back(), module->generalizations_.back());
       os << qualifiedName;
     }
   }
 
   os << " {" << endl;
-  // generate private first since CPP classes default to private
-  os << "// attributes" << endl;
-  for (size_t i = 0; i < module->privateAttributes_.size(); i++) {
-    result = generateAttribute(os, module->privateAttributes_[i]) && result;
-  }
-  os << "// operators " << endl;
-  for (size_t i = 0; i < module->privateOperators_.size(); i++) {
-    result = generateOperator(os, module->privateOperators_[i]) && result;
-  }
-
-  // Next protected
-  os << "protected: " << endl << endl;
-  os << "// attributes" << endl;
-
-  for (size_t i = 0; i < module->protectedAttributes_.size(); i++) {
-    result = generateAttribute(os, module->protectedAttributes_[i]) && result;
-  }
-
-  os << "// operators " << endl;
-  for (size_t i = 0; i < module->protectedOperators_.size(); i++) {
-    result = generateOperator(os, module->protectedOperators_[i]) && result;
-  }
-
-  // Finally public.
-  os << "public: " << endl << endl;
-  os << "// attributes" << endl;
+  // generate private first since CPP classes default to private, next protected and finally public
+  for (Visibility visibility : {Visibility::PRIVATE, Visibility::PROTECTED, Visibility::PUBLIC}) {
+    if (visibility == Visibility::PROTECTED) {
+      os << "protected: " << endl << endl;
+    } else if (visibility == Visibility::PUBLIC) {
+      os << "public: " << endl << endl;
+    }
 
-  for (size_t i = 0; i < module->publicAttributes_.size(); i++) {
-    result = generateAttribute(os, module->publicAttributes_[i]) && result;
-  }
+    os << "// attributes" << endl;
+    for (auto& attribute : context.model_.attributes(index, visibility)) {
+      result = generateAttribute(context, os, attribute) && result;
+    }
 
-  os << "// operators " << endl;
-  for (size_t i = 0; i < module->publicOperators_.size(); i++) {
-    result = generateOperator(os, module->publicOperators_[i]) && result;
+    os << "// operators " << endl;
+    for (auto& op : context.model_.operators(index, visibility)) {
+      if (context.definitions_ == nullptr) {
+        result = generateOperator(context, os, op, {}, "{}") && result;
+      } else if (generateOperator(context, os, op, {}, ";")) {
+        generateOperator(context, *context.definitions_, op, module->name_, "{}");
+      } else {
+        result = false;
+      }
+    }
   }
 
   os << "}; // class " << module->name_ << " " << module->id_ << endl << endl;
-  currentScope_.pop_back();
+  context.currentScope_.pop_back();
 
-  for (size_t j = 0; j < closeBraces.size(); j++) {
-    os << closeBraces[j];
-    currentScope_.pop_back();
+  while (!closeBraces.empty()) {
+    os << closeBraces.back();
+    context.currentScope_.pop_back();
     closeBraces.pop_back();
   }
 
-  generatedSymbols[module->id_] = true;
+  context.view_.annotation(module)->generated_ = true;
   return result;
 }
 
-// Flattens all modules to be used for circular dependency checks and topalogical sort
-vector<ModuleNode*> flatten(ModelNode* root) {
-  cout << "Flattening Modules" << endl;
-  vector<ModuleNode*> flattenedModules;
-  for (auto& package : root->packages_) {
-    flattenedModules.insert(flattenedModules.end(), package->modules_.begin(), package->modules_.end());
+// Namespaces to open for a declaration in scope from the model namespace, like renderModule opens them
+vector<string_view> namespacesOf(const CPPRenderContext& context, const Scope& scope) {
+  vector<string_view> namespaces;
+  for (size_t j = 0; j + 1 < scope.size(); j++) {
+    if (j > 0 || context.currentScope_.front() != scope[j]) {
+      namespaces.push_back(scope[j]);
+    }
   }
+  return namespaces;
+}
 
-  flattenedModules.insert(flattenedModules.end(), root->modules_.begin(), root->modules_.end());
-  cout << "Finished flattening modules" << endl;
-  return flattenedModules;
+/**
+ * Closes the open namespaces that namespaces does not start with, then opens the rest of it
+ * @param[in,out] open namespaces open below the model namespace, namespaces after the call
+ * @param[in] namespaces namespaces to be in, from namespacesOf
+ * @returns whether any namespace was closed or opened
+ */
+bool switchNamespaces(std::ostream& os, vector<string_view>& open, const vector<string_view>& namespaces) {
+  size_t common = 0;
+  while (common < open.size() && common < namespaces.size() && open[common] == namespaces[common]) {
+    common++;
+  }
+  const bool changed = open.size() != common || namespaces.size() != common;
+  if (open.size() > common) {
+    os << string(open.size() - common, '}') << endl;
+    open.resize(common);
+  }
+  for (size_t j = common; j < namespaces.size(); j++) {
+    os << "namespace " << namespaces[j] << " { " << endl;
+    open.push_back(namespaces[j]);
+  }
+  return changed;
 }
 
-bool hasHardCircularDependency(vector<ModuleNode*>& flattenedModules) {
-  cout << "Checking for circular dependencies" << endl;
-  vector<ModuleNode*> hardDependencies;
+/**
+ * Generates the hoisted forward declarations as one block, only opening and closing the
+ * namespaces that differ from the previous declaration
+ * @param[in] declarations modules to declare, grouped by namespace
+ */
+void generateForwardDeclarations(const CPPRenderContext& context, std::ostream& os, const vector<IdHandle>& declarations) {
+  os << "// Forward Decl" << endl;
+  vector<string_view> open;
+  for (IdHandle declaration : declarations) {
+    const Scope& scope = context.ids_.scope(declaration);
+    switchNamespaces(os, open, namespacesOf(context, scope));
+    os << "class " << scope.back() << ";" << endl;
+  }
+  switchNamespaces(os, open, {});
+  os << endl;
+}
 
-  for (auto& module : flattenedModules) {
-    if (module->hardDependencyList_.size() > 0) hardDependencies.push_back(module);
+bool generateModule(CPPRenderContext& context, std::ostream& os, LoweredModel::Index index) {
+  if (context.cache_ == nullptr) {
+    return renderModule(context, os, index);
+  }
+
+  // Besides the module and the names it resolves, the output depends on the scope it is generated
+  // from and on which referenced symbols are already generated as that decides forward declarations.
+  const LoweredModel::Module& lowered = context.model_.module(index);
+  std::ostream* shard = context.definitions_;
+  WideContentHasher hasher = moduleCacheKey(context.generator_.name(), context.generator_.version(), lowered.module_, context.ids_);
+  hasher.add(context.hoisted_).add(context.grouped_).add(shard != nullptr);
+  hasher.add(context.currentScope_.size());
+  for (auto& scope : context.currentScope_) {
+    hasher.add(scope);
+  }
+  for (auto& id : referencedIds(lowered.module_)) {
+    hasher.add(generated(context, context.ids_.find(id)));
+  }
+  const CacheKey key = hasher.digest();
+
+  // Sharded, an entry is the class followed by a NUL and the operator definitions for its shard
+  string text;
+  if (context.cache_->lookup(key, text)) {
+    const size_t split = shard == nullptr ? text.size() : text.find('\0');
+    if (split != string::npos) {
+      os << string_view(text).substr(0, split);
+      if (shard != nullptr) {
+        *shard << string_view(text).substr(split + 1);
+      }
+      context.view_.annotation(lowered.module_)->generated_ = true;
+      return true;
+    }
   }
 
-  // If there is only one module that has any form of hard dependency, cannot have circular dependency
-  // unless its on itself which is never allowed.
-  if (hardDependencies.size() <= 1) {
-    cout << "Finished Checking for circular dependencies" << endl;
-    return false;
+  ostringstream rendered;
+  ostringstream definitions;
+  if (shard != nullptr) {
+    context.definitions_ = &definitions;
   }
+  bool result = renderModule(context, rendered, index);
+  context.definitions_ = shard;
+  text = rendered.str();
+  os << text;
+  if (shard != nullptr) {
+    const string defined = definitions.str();
+    *shard << defined;
+    text += '\0';
+    text += defined;
+  }
+  // Only cache successful renders so failures are reported again on the next run
+  if (result) {
+    context.cache_->store(key, text);
+  }
+  return result;
+}
 
-  DependencyGraph dp;
-  for (auto& module : hardDependencies) {
-    for (auto& dep : module->hardDependencyList_) {
-      dp.addEdge(module->id_, dep.first);
+// Flattens all modules to be used for circular dependency checks and topalogical sort, only the
+// targets and what they hard depend on if there are targets
+vector<const ModuleNode*> flatten(const ModelNode* root, const vector<string>& targets) {
+  cout << "Flattening Modules" << endl;
+  ModelView<> view(root);
+  view.flatten();
+  if (!targets.empty()) {
+    for (auto& target : view.select(targets)) {
+      cerr << "No module matches target " << target << endl;
     }
+    cout << "Selected " << view.size() << " modules for generation" << endl;
   }
-
-  cout << "Finished Checking for circular dependencies" << endl;
-  return dp.hasCycle();
+  cout << "Finished flattening modules" << endl;
+  return view.modules();
 }
 
-vector<ModuleNode*> sortHardDependencies(vector<ModuleNode*> flattenedModules) {
-  cout << "Starting dependency sort" << endl;
-  vector<ModuleNode*> softDependenciesOnly;
-  set<string> softDependencyIds;
-  vector<ModuleNode*> hardDependencies;
-
-  for (auto& module : flattenedModules) {
-    if (module->hardDependencyList_.size() > 0) {
-      hardDependencies.push_back(module);
-    } else {
-      softDependenciesOnly.push_back(module);
-      softDependencyIds.insert(module->id_);
+/**
+ * Reorders modules so modules of the same namespace are generated in runs, keeping every module
+ * after the modules it hard depends on. Of the modules whose dependencies are generated, one of
+ * the current namespace is taken first, else the earliest in the given order starts a new run.
+ * @param[in,out] order modules in hard dependency order, without cycles
+ */
+void groupByNamespace(const LoweredModel& model, vector<LoweredModel::Index>& order) {
+  constexpr uint32_t UNSELECTED = UINT32_MAX;
+  vector<uint32_t> position(model.size(), UNSELECTED);
+  for (uint32_t i = 0; i < order.size(); i++) {
+    position[order[i]] = i;
+  }
+
+  // Dependents of each module by position, and how many dependencies each has left to generate
+  vector<uint32_t> pending(order.size(), 0);
+  vector<vector<uint32_t>> dependents(order.size());
+  for (uint32_t i = 0; i < order.size(); i++) {
+    for (IdHandle dependency : model.hardDependencies(order[i])) {
+      const LoweredModel::Index target = model.find(dependency);
+      if (target == LoweredModel::NONE || position[target] == UNSELECTED || position[target] == i) continue;
+      dependents[position[target]].push_back(i);
+      pending[i]++;
     }
   }
-  vector<ModuleNode*> sortedModules;
-  if (hardDependencies.size() > 1) {
-    DependencyGraph dp;
-    for (auto& module : hardDependencies) {
-      for (auto& dep : module->hardDependencyList_) {
-        dp.addEdge(module->id_, dep.first);
-      }
-    }
-    vector<string> sortedDeps = dp.topSort();
-    for (size_t i = sortedDeps.size() - 1; i > hardDependencies.size(); i++) {
-      if (softDependencyIds.contains(sortedDeps[i])) {
-        sortedDeps.pop_back();
-      } else {
-        break;
-      }
+
+  // Ready modules by position, all of them and by namespace. A module taken from one heap stays
+  // in the other until it comes to the top there.
+  using Heap = priority_queue<uint32_t, vector<uint32_t>, greater<uint32_t>>;
+  auto namespaceOf = [&](uint32_t i) { return model.module(order[i]).module_->scope_->parent(); };
+  Heap ready;
+  unordered_map<const Scope*, Heap> readyIn;
+  vector<char> taken(order.size(), false);
+  auto makeReady = [&](uint32_t i) {
+    ready.push(i);
+    readyIn[namespaceOf(i)].push(i);
+  };
+  auto pop = [&](Heap& heap) {
+    while (!heap.empty() && taken[heap.top()]) heap.pop();
+  };
+  for (uint32_t i = 0; i < order.size(); i++) {
+    if (pending[i] == 0) makeReady(i);
+  }
+
+  vector<LoweredModel::Index> grouped;
+  grouped.reserve(order.size());
+  Heap* run = nullptr;
+  while (true) {
+    if (run != nullptr) pop(*run);
+    if (run == nullptr || run->empty()) {
+      pop(ready);
+      if (ready.empty()) break;
+      run = &readyIn[namespaceOf(ready.top())];
+      pop(*run);
     }
-    // At this point, the sorted deps contains xmi id's of only modules that have hard dependencies but are are sorted correctly
-    for (auto& id : sortedDeps) {
-      for (auto& module : hardDependencies) {
-        if (id == module->id_) {
-          sortedModules.push_back(module);
-        }
-      }
+    const uint32_t next = run->top();
+    run->pop();
+    taken[next] = true;
+    grouped.push_back(order[next]);
+    for (uint32_t dependent : dependents[next]) {
+      if (--pending[dependent] == 0) makeReady(dependent);
     }
-  } else {
-    sortedModules.insert(sortedModules.end(), hardDependencies.begin(), hardDependencies.end());
   }
-
-  sortedModules.insert(sortedModules.end(), softDependenciesOnly.begin(), softDependenciesOnly.end());
-  // now reverse order so elements with the least # of hard deps are first in gen order
-  reverse(sortedModules.begin(), sortedModules.end());
-
-  cout << "Finished dependency sort" << endl;
-  return sortedModules;
+  order = std::move(grouped);
 }
 
-bool CPPGenerator::check(ModelNode* root) {
+bool CPPGenerator::check(const ModelNode* root) {
   checkCalled_ = true;
+  const LoweredModel& model = lowered(root);
 
-  vector<ModuleNode*> flattenedModules = flatten(root);
+  vector<const ModuleNode*> flattenedModules = flatten(root, targets_);
 
   if (flattenedModules.empty()) {
     cerr << "Failed to flatten modules!" << endl;
     return false;
   }
 
-  if (hasHardCircularDependency(flattenedModules)) {
-    cerr << "C++ cannot have hard circular dependencies!" << endl;
-    modelValid_ = false;
-    return false;
+  vector<char> selected(model.size(), false);
+  for (auto& module : flattenedModules) {
+    selected[model.find(module)] = true;
+  }
+
+  // The lowered model is already in hard dependency order, keep the selected modules of it
+  cout << "Checking for circular dependencies" << endl;
+  order_.clear();
+  for (LoweredModel::Index index : model.dependencyOrder()) {
+    if (!selected[index]) continue;
+    if (model.module(index).cyclic_) {
+      cerr << "Found cycle at node: " << model.module(index).module_->id_ << endl;
+      cerr << "C++ cannot have hard circular dependencies!" << endl;
+      modelValid_ = false;
+      return false;
+    }
+    order_.push_back(index);
+  }
+  cout << "Finished Checking for circular dependencies" << endl;
+
+  if (groupNamespaces_) {
+    groupByNamespace(model, order_);
+  }
+  view_ = ModelView<ModuleState>(root);
+  flattenedModules.clear();
+  for (LoweredModel::Index index : order_) {
+    flattenedModules.push_back(model.module(index).module_);
+  }
+  view_.setOrder(std::move(flattenedModules));
+
+  // A soft dependency needs a forward declaration if it is generated after its first use or not
+  // at all, declare each of those once
+  forwardDeclarations_.clear();
+  if (hoisted()) {
+    vector<size_t> generatedAt(root->ids_.size(), SIZE_MAX);
+    for (size_t i = 0; i < order_.size(); i++) {
+      const IdHandle handle = model.module(order_[i]).handle_;
+      if (handle != NO_ID) generatedAt[handle] = i;
+    }
+    vector<char> declared(root->ids_.size(), false);
+    auto declare = [&](IdHandle dependency, size_t i) {
+      if (generatedAt[dependency] > i && !declared[dependency]) {
+        declared[dependency] = true;
+        forwardDeclarations_.push_back(dependency);
+      }
+    };
+    for (size_t i = 0; i < order_.size(); i++) {
+      for (IdHandle dependency : model.softDependencies(order_[i])) {
+        declare(dependency, i);
+      }
+      // Sharded, operators are only declared in their class, so the classes they return only need
+      // a declaration like soft dependencies do
+      if (shards_ == 0) continue;
+      for (Visibility visibility : {Visibility::PRIVATE, Visibility::PROTECTED, Visibility::PUBLIC}) {
+        for (auto& op : model.operators(order_[i], visibility)) {
+          const LoweredParam* returnType = model.returnType(op);
+          if (returnType != nullptr && model.find(returnType->type_.handle_) != LoweredModel::NONE) {
+            declare(returnType->type_.handle_, i);
+          }
+        }
+      }
+    }
+    // By namespace, the classes of a namespace before its nested namespaces, so each is opened once
+    vector<pair<vector<string>, IdHandle>> keyed;
+    keyed.reserve(forwardDeclarations_.size());
+    for (IdHandle declaration : forwardDeclarations_) {
+      vector<string> key = root->ids_.scope(declaration).strings();
+      key.back().insert(0, 1, '\0');
+      keyed.emplace_back(std::move(key), declaration);
+    }
+    sort(keyed.begin(), keyed.end());
+    for (size_t i = 0; i < keyed.size(); i++) {
+      forwardDeclarations_[i] = keyed[i].second;
+    }
   }
 
-  // now can  inverse toplogical sort hard dependencies
-  vector<ModuleNode*> sortedModules = sortHardDependencies(flattenedModules);
-  if (sortedModules.empty()) {
-    cerr << "Failed to sort modules by dependency order!" << endl;
+  if (shards_ > 0) {
+    assignShards(model);
   }
-  root->packages_.clear();
-  root->modules_ = sortedModules;
+
   modelValid_ = true;
   return true;
 }
 
-bool CPPGenerator::generate(std::ostream& os, ModelNode* root) {
+bool CPPGenerator::generate(std::ostream& os, const ModelNode* root) {
   bool result;
   if (!checkCalled_) {
     result = this->check(root);
@@ -694,27 +654,182 @@ bool CPPGenerator::generate(std::ostream& os, ModelNode* root) {
     return false;
   }
 
-  currentScope_.push_back(root->name_);
-  idNameMap = root->idNameMap_;
+  // Every run starts from nothing generated
+  view_.clearAnnotations();
+  const LoweredModel& model = lowered(root);
+  CPPRenderContext context{*this, root->ids_, model, view_, cache_, hoisted(), groupNamespaces_};
+  context.currentScope_.push_back(root->name_);
   char* modelName = root->name_;
 
-  os << "namespace " << modelName << "{" << endl << endl;
+  // Sharded, the classes go to a shared header, their operators are defined in the shards and
+  // the output lists the files. They are written next to the output and listed relative to it.
+  const bool sharded = shards_ > 0;
+  const filesystem::path outputPath(output_);
+  const string prefix = !shardPrefix_.empty() ? shardPrefix_ : output_.empty() ? string(modelName) : outputPath.stem().string();
+  const string headerName = prefix + ".hpp";
+  ofstream headerFile;
+  vector<ofstream> shardFiles(shards_);
+  vector<vector<string_view>> shardOpen(shards_);
+  if (sharded) {
+    const filesystem::path headerPath = outputPath.parent_path() / headerName;
+    headerFile.open(headerPath);
+    if (!headerFile.is_open()) {
+      cerr << "Failed to create and open shared header: " << headerPath.string() << endl;
+      return false;
+    }
+    for (uint32_t shard = 0; shard < shards_; shard++) {
+      const filesystem::path shardPath = outputPath.parent_path() / (prefix + "_" + to_string(shard) + ".cpp");
+      shardFiles[shard].open(shardPath);
+      if (!shardFiles[shard].is_open()) {
+        cerr << "Failed to create and open shard: " << shardPath.string() << endl;
+        return false;
+      }
+      shardFiles[shard] << "#include \"" << headerPath.filename().string() << "\"" << endl << endl;
+      shardFiles[shard] << "namespace " << modelName << "{" << endl << endl;
+    }
+    headerFile << "#pragma once" << endl << endl;
+  }
+  std::ostream& classes = sharded ? headerFile : os;
 
-  for (size_t i = 0; i < root->modules_.size(); i++) {
-    result = generateModule(os, root->modules_[i]) && result;
-    os << endl << endl;
+  // Headers of the primitive types used, each once
+  vector<string_view> headers;
+  for (size_t i = 0; i < NUM_PRIMITIVES; i++) {
+    const char* header = cppPrimitives[i].header_;
+    if (header == nullptr || !model.uses(static_cast<Primitive>(i)) || find(headers.begin(), headers.end(), header) != headers.end()) continue;
+    headers.push_back(header);
+    classes << "#include <" << header << ">" << endl;
+  }
+  if (!headers.empty()) {
+    classes << endl;
   }
 
-  //!@note: We do not generate packages as these are removed when we flatten the modules
+  classes << "namespace " << modelName << "{" << endl << endl;
 
-  os << "} // namespace " << modelName << " " << root->id_ << endl << endl;
+  if (context.hoisted_) {
+    generateForwardDeclarations(context, classes, forwardDeclarations_);
+  }
+
+  // Grouped, the namespaces of a run of modules are opened once around the run and the modules
+  // are rendered from inside them
+  vector<string_view> open;
+  for (size_t i = 0; i < order_.size(); i++) {
+    const ModuleNode* module = view_[i];
+    if (context.grouped_) {
+      if (switchNamespaces(classes, open, namespacesOf(context, *module->scope_))) {
+        context.currentScope_.resize(1);
+        context.currentScope_.insert(context.currentScope_.end(), open.begin(), open.end());
+      }
+    }
+    if (sharded) {
+      context.definitions_ = &shardFiles[shardOf_[i]];
+      if (!module->operators_.empty()) {
+        switchNamespaces(*context.definitions_, shardOpen[shardOf_[i]], namespacesOf(context, *module->scope_));
+      }
+    }
+    result = generateModule(context, classes, order_[i]) && result;
+    classes << endl << endl;
+  }
+  context.definitions_ = nullptr;
+  switchNamespaces(classes, open, {});
+  context.currentScope_.resize(1);
 
-  os << "int main(int argc, char* argv[]) {" << endl << endl;
-  os << "return 0;" << endl;
-  os << "}" << endl;
-  currentScope_.pop_back();
+  //!@note: We do not generate packages as their modules are part of the flattened generation order
+
+  classes << "} // namespace " << modelName << " " << root->id_ << endl << endl;
+  for (uint32_t shard = 0; shard < shards_; shard++) {
+    switchNamespaces(shardFiles[shard], shardOpen[shard], {});
+    shardFiles[shard] << endl << "} // namespace " << modelName << " " << root->id_ << endl << endl;
+  }
+
+  std::ostream& entry = sharded ? shardFiles[0] : os;
+  entry << "int main(int argc, char* argv[]) {" << endl << endl;
+  entry << "return 0;" << endl;
+  entry << "}" << endl;
+
+  // Manifest of the translation units for a build system to compile in parallel
+  if (sharded) {
+    os << "# " << modelName << " C++ translation units: kind path [modules estimated-cost]" << endl;
+    os << "header " << headerName << endl;
+    for (uint32_t shard = 0; shard < shards_; shard++) {
+      os << "shard " << prefix << "_" << shard << ".cpp " << shardModules_[shard] << " " << shardCost_[shard] << endl;
+    }
+  }
   return result;
 }
+void CPPGenerator::assignShards(const LoweredModel& model) {
+  // A shard compiles the operator definitions of its modules and looks up the types they use, the
+  // class definitions are in the shared header every shard compiles alike
+  vector<uint64_t> cost(order_.size());
+  for (size_t i = 0; i < order_.size(); i++) {
+    const LoweredModel::Module& lowered = model.module(order_[i]);
+    cost[i] = 1 + lowered.numHard_ + lowered.numSoft_;
+    for (auto& op : lowered.module_->operators_) {
+      cost[i] += 1 + op->params_.size() + (op->returnType_ != nullptr);
+    }
+  }
+
+  // Longest processing time first, each module to the cheapest shard so far
+  vector<uint32_t> byCost(order_.size());
+  for (uint32_t i = 0; i < byCost.size(); i++) {
+    byCost[i] = i;
+  }
+  stable_sort(byCost.begin(), byCost.end(), [&](uint32_t a, uint32_t b) { return cost[a] > cost[b]; });
+  using Load = pair<uint64_t, uint32_t>;
+  priority_queue<Load, vector<Load>, greater<Load>> loads;
+  for (uint32_t shard = 0; shard < shards_; shard++) {
+    loads.push({0, shard});
+  }
+  shardOf_.assign(order_.size(), 0);
+  shardCost_.assign(shards_, 0);
+  shardModules_.assign(shards_, 0);
+  for (uint32_t i : byCost) {
+    auto [load, shard] = loads.top();
+    loads.pop();
+    shardOf_[i] = shard;
+    shardCost_[shard] += cost[i];
+    shardModules_[shard]++;
+    loads.push({load + cost[i], shard});
+  }
+}
+
+bool CPPGenerator::setOption(const string& key, const string& value) {
+  if (key == "forward-declarations") {
+    if (value != "per-class" && value != "hoisted") {
+      cerr << "Unknown forward-declarations value " << value << ", expected per-class or hoisted" << endl;
+      return false;
+    }
+    hoistForwardDeclarations_ = value == "hoisted";
+    return true;
+  }
+  if (key == "shards") {
+    char* end = nullptr;
+    const unsigned long shards = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || shards > UINT32_MAX) {
+      cerr << "Invalid shards value " << value << ", expected a number of translation units" << endl;
+      return false;
+    }
+    shards_ = static_cast<uint32_t>(shards);
+    return true;
+  }
+  if (key == "shard-prefix") {
+    shardPrefix_ = value;
+    return true;
+  }
+  if (key == "output") {
+    output_ = value;
+    return true;
+  }
+  if (key == "namespaces") {
+    if (value != "per-class" && value != "grouped") {
+      cerr << "Unknown namespaces value " << value << ", expected per-class or grouped" << endl;
+      return false;
+    }
+    groupNamespaces_ = value == "grouped";
+    return true;
+  }
+  return false;
+}
+
 extern "C" IGenerator* create_generator() { return new CPPGenerator; }
 extern "C" void destroy_generator(IGenerator* generator) { delete generator; }
 }  // namespace XMR
\ No newline at end of file
@@ -19,76 +19,93 @@
  ***********************************************************/
 #include "generators/JavaGenerator.hpp"
 
+#include <array>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <unordered_map>
 
+#include "generators/ModelView.hpp"
+
 using namespace std;
 
-static unordered_map<string, bool> generatedSymbols;
-static unordered_map<string, vector<string>> idNameMap;
-static fstream workingFile;                        // keeps track of file we are currently in
-static bool mainGenerated = false;                 // generate main once, currently in first module created
-static unordered_set<std::string> noNoNames = {};  // empty for now, left for future use if needed
+static const unordered_set<std::string> noNoNames = {};  // empty for now, left for future use if needed
 
 namespace XMR {
+
+// What one generate call writes to and has emitted so far, owned by the call so runs of
+// different generator objects can share the model from any thread.
+struct JavaRenderContext {
+  const IGenerator& generator_;
+  const IdIndex& ids_;
+  const LoweredModel& model_;
+  GenerationCache* cache_ = nullptr;
+  const ModelView<>* selection_ = nullptr;  // modules to generate when there are targets, nullptr for all
+  fstream workingFile_;                     // keeps track of file we are currently in
+  bool mainGenerated_ = false;              // generate main once, currently in first module created
+
+  bool selected(const ModuleNode* module) const { return selection_ == nullptr || selection_->contains(module); }
+};
 /*
  * Helper function that outputs the full name based
- * on the qualified name list given
+ * on the qualified name given
  */
-void outputFullName(vector<string> namelist) {
-  workingFile << "src.";
-  for (int i = 0; i < namelist.size(); ++i) {
-    workingFile << namelist[i];
-    if (i < (namelist.size() - 1)) {
-      workingFile << ".";
-    }
-  }
-}
+void outputFullName(std::ostream& os, const Scope& scope) { os << "src." << scope.joined(Scope::DOT); }
 /*
  * Helper function that returns the path to a class's
- * File based on the fully qualified name list given
+ * File based on the fully qualified name given
  */
-string returnFileLocation(vector<string> namelist) {
+string returnFileLocation(const Scope& scope) {
   string path = "./src/";
-  for (int i = 0; i < namelist.size(); ++i) {
-    path += namelist[i];
-    if (i < (namelist.size() - 1)) {
-      path += "/";
-    }
-  }
+  path += scope.joined(Scope::PATH);
   path += ".java";
   return path;
 }
 /*
  * Helper function that returns the path to a package directory
- * based on the fully qualified name list given
+ * based on the fully qualified name given
  */
-string returnPackagePath(vector<string> namelist) {
+string returnPackagePath(const Scope& scope) {
   string path = "./src/";
-  for (int i = 0; i < namelist.size(); ++i) {
-    path += namelist[i];
-    if (i < (namelist.size() - 1)) {
-      path += "/";
-    }
-  }
+  path += scope.joined(Scope::PATH);
   return path;
 }
 /*
  * Helper function that returns the name of a package
- * based on the fully qualified name list given
+ * based on the fully qualified name given
  */
-string packageName(vector<string> namelist) {
+string packageName(const Scope& scope) {
   string path = "src.";
-  for (int i = 0; i < namelist.size(); ++i) {
-    path += namelist[i];
-    if (i < (namelist.size() - 1)) {
-      path += ".";
-    }
-  }
+  path += scope.joined(Scope::DOT);
   return path;
 }
+// Java name of a primitive, unboxed and boxed for use as a type argument, i.e. in a java.util.List
+struct JavaPrimitive {
+  const char* name_;
+  const char* boxed_;
+};
+
+// By Primitive, the fallback for primitives no library names is int
+constexpr array<JavaPrimitive, NUM_PRIMITIVES> javaPrimitives = {{
+    {"int", "Integer"},      // NONE
+    {"boolean", "Boolean"},  // BOOLEAN
+    {"int", "Integer"},      // INTEGER
+    {"double", "Double"},    // REAL
+    {"String", "String"},    // STRING
+    {"int", "Integer"},      // UNLIMITED_NATURAL
+    {"byte", "Byte"},        // BYTE
+    {"char", "Character"},   // CHAR
+    {"short", "Short"},      // SHORT
+    {"long", "Long"},        // LONG
+    {"float", "Float"},      // FLOAT
+    {"int", "Integer"},      // UNKNOWN
+}};
+
+const char* primitiveName(Primitive primitive, bool boxed) {
+  const JavaPrimitive& mapped = javaPrimitives[static_cast<size_t>(primitive)];
+  return boxed ? mapped.boxed_ : mapped.name_;
+}
 bool checkOperatorName(char* name) {
   // lookup no no phrased for java, currently blank, left if I think of
   // something that wouldn't work
@@ -103,211 +120,86 @@ bool checkOperatorName(char* name) {
  * Checks if the module passed inherits from a max of 1 other module
  * as multiple inheritance is not allowed in Java.
  */
-bool checkSingleInheritance(ModuleNode* module) { return module->generalizations_.size() <= 1; }
-
-bool generateOperator(std::ostream& os, Operator* op) {
-  if (checkOperatorName(op->name_)) {
-    if (op->visibility_ == Visibility::PRIVATE) {
-      workingFile << "private ";
-    } else if (op->visibility_ == Visibility::PUBLIC) {
-      workingFile << "public ";
-    } else if (op->visibility_ == Visibility::PROTECTED) {
-      workingFile << "protected ";
-    }  // if it is package public, we don't need to print anything
-
-    if (op->returnType_) {
-      if (op->returnType_->unlimited_) {
-        workingFile << "java.util.List<";
-        if (op->returnType_->type_->isPrimitive_) {
-          std::string hash = "#";
-          size_t index = strcspn(op->returnType_->type_->type_, hash.c_str());
-          std::string type = std::to_string(op->returnType_->type_->type_[index]);
-          if (type == "Boolean") {
-            workingFile << "Boolean";
-          } else if (type == "Real") {
-            workingFile << "Double";
-          } else {
-            workingFile << "Integer";
-          }
-
-        } else {
-          outputFullName(idNameMap[op->returnType_->type_->type_]);
-        }
-        workingFile << ">";
-      } else {
-        if (op->returnType_->type_->isPrimitive_) {
-          std::string hash = "#";
-          size_t index = strcspn(op->returnType_->type_->type_, hash.c_str());
-          std::string type = std::to_string(op->returnType_->type_->type_[index]);
-          if (type == "Boolean") {
-            workingFile << "boolean";
-          } else if (type == "Real") {
-            workingFile << "double";
-          } else {
-            workingFile << "int";
-          }
-
-        } else {
-          outputFullName(idNameMap[op->returnType_->type_->type_]);
-        }
-
-        // handle multiplicity
-        if (!op->returnType_->unlimited_ && op->returnType_->multiplicity_ > 1) {
-          workingFile << "[" << op->returnType_->multiplicity_ << "]";
-        }
-      }
-    } else {
-      workingFile << "void";
-    }
+bool checkSingleInheritance(const ModuleNode* module) { return module->generalizations_.size() <= 1; }
 
-    workingFile << " " << op->name_ << "(";
-
-    if (!op->params_.empty()) {
-      for (size_t i = 0; i < op->params_.size() - 1; i++) {
-        if (op->params_[i]->unlimited_) {
-          workingFile << "java.util.List<";
-          if (op->params_[i]->type_->isPrimitive_) {
-            std::string hash = "#";
-            size_t index = strcspn(op->params_[i]->type_->type_, hash.c_str());
-            std::string type = std::to_string(op->params_[i]->type_->type_[index]);
-            if (type == "Boolean") {
-              workingFile << "Boolean";
-            } else if (type == "Real") {
-              workingFile << "Double";
-            } else {
-              workingFile << "Integer";
-            }
-
-          } else {
-            outputFullName(idNameMap[op->params_[i]->type_->type_]);
-          }
-          workingFile << ">";
-        } else {
-          if (op->params_[i]->type_->isPrimitive_) {
-            std::string hash = "#";
-            size_t index = strcspn(op->params_[i]->type_->type_, hash.c_str());
-            std::string type = std::to_string(op->params_[i]->type_->type_[index]);
-            if (type == "Boolean") {
-              workingFile << "boolean";
-            } else if (type == "Real") {
-              workingFile << "double";
-            } else {
-              workingFile << "int";
-            }
-
-          } else {
-            outputFullName(idNameMap[op->params_[i]->type_->type_]);
-          }
-
-          // handle multiplicity
-          if (!op->params_[i]->unlimited_ && op->params_[i]->multiplicity_ > 1) {
-            workingFile << "[" << op->params_[i]->multiplicity_ << "]";
-          }
-        }
-        workingFile << " " << op->params_[i]->name_ << ", ";
-      }
-      if (op->params_[op->params_.size() - 1]->unlimited_) {
-        workingFile << "java.util.List<";
-        if (op->params_[op->params_.size() - 1]->type_->isPrimitive_) {
-          std::string hash = "#";
-          size_t index = strcspn(op->params_[op->params_.size() - 1]->type_->type_, hash.c_str());
-          std::string type = std::to_string(op->params_[op->params_.size() - 1]->type_->type_[index]);
-          if (type == "Boolean") {
-            workingFile << "Boolean";
-          } else if (type == "Real") {
-            workingFile << "Double";
-          } else {
-            workingFile << "Integer";
-          }
-
-        } else {
-          // lookup type name of id
-          outputFullName(idNameMap[op->params_[op->params_.size() - 1]->type_->type_]);
-        }
-        workingFile << ">";
-      } else {
-        if (op->params_[op->params_.size() - 1]->type_->isPrimitive_) {
-          std::string hash = "#";
-          size_t index = strcspn(op->params_[op->params_.size() - 1]->type_->type_, hash.c_str());
-          std::string type = std::to_string(op->params_[op->params_.size() - 1]->type_->type_[index]);
-          if (type == "Boolean") {
-            workingFile << "boolean";
-          } else if (type == "Real") {
-            workingFile << "double";
-          } else {
-            workingFile << "int";
-          }
-
-        } else {
-          // lookup type name of id
-          outputFullName(idNameMap[op->params_[op->params_.size() - 1]->type_->type_]);
-        }
-        // Handle multiplicity
-        if (!op->params_[op->params_.size() - 1]->unlimited_ && op->params_[op->params_.size() - 1]->multiplicity_ > 1) {
-          workingFile << "[" << op->params_[op->params_.size() - 1]->multiplicity_ << "]";
-        }
-      }
-      workingFile << " " << op->params_[op->params_.size() - 1]->name_;
+/*
+ * Helper function that outputs the type of a param, attribute or
+ * return type, a java.util.List of it if it is unlimited
+ */
+void outputType(std::ostream& os, const TypeUse& type) {
+  if (type.many_) {
+    os << "java.util.List<";
+    if (type.isPrimitive()) {
+      os << primitiveName(type.primitive_, true);
+    } else {
+      outputFullName(os, *type.scope_);
     }
+    os << ">";
+    return;
+  }
 
-    workingFile << "){}" << endl;
-    return true;
+  if (type.isPrimitive()) {
+    os << primitiveName(type.primitive_, false);
   } else {
-    return false;
+    outputFullName(os, *type.scope_);
+  }
+  // Handle multiplicity
+  if (type.extent_ > 0) {
+    os << "[" << type.extent_ << "]";
   }
 }
-bool generateAttribute(std::ostream& os, Attribute* attribute) {
-  if (attribute->visibility_ == Visibility::PRIVATE) {
-    workingFile << "private ";
-  } else if (attribute->visibility_ == Visibility::PUBLIC) {
-    workingFile << "public ";
-  } else if (attribute->visibility_ == Visibility::PROTECTED) {
-    workingFile << "protected ";
+/*
+ * Helper function that outputs the access modifier of a member
+ */
+void outputVisibility(std::ostream& os, Visibility visibility) {
+  if (visibility == Visibility::PRIVATE) {
+    os << "private ";
+  } else if (visibility == Visibility::PUBLIC) {
+    os << "public ";
+  } else if (visibility == Visibility::PROTECTED) {
+    os << "protected ";
   }  // if it is package public, we don't need to print anything
-  if (attribute->unlimited_) {
-    workingFile << "java.util.List<";
-    if (attribute->type_->isPrimitive_) {
-      std::string hash = "#";
-      size_t index = strcspn(attribute->type_->type_, hash.c_str());
-      std::string type = std::to_string(attribute->type_->type_[index]);
-      if (type == "Boolean") {
-        workingFile << "Boolean";
-      } else if (type == "Real") {
-        workingFile << "Double";
-      } else {
-        workingFile << "Integer";
-      }
-    } else {
-      outputFullName(idNameMap[attribute->type_->type_]);
-    }
-    workingFile << ">";
-  } else {
-    if (attribute->type_->isPrimitive_) {
-      std::string hash = "#";
-      size_t index = strcspn(attribute->type_->type_, hash.c_str());
-      std::string type = std::to_string(attribute->type_->type_[index]);
-      if (type == "Boolean") {
-        workingFile << "boolean";
-      } else if (type == "Real") {
-        workingFile << "double";
-      } else {
-        workingFile << "int";
-      }
+}
 
+bool generateOperator(const JavaRenderContext& context, std::ostream& os, const LoweredOperator& op) {
+  if (checkOperatorName(op.operator_->name_)) {
+    outputVisibility(os, op.operator_->visibility_);
+
+    const LoweredParam* returnType = context.model_.returnType(op);
+    if (returnType != nullptr) {
+      outputType(os, returnType->type_);
     } else {
-      outputFullName(idNameMap[attribute->type_->type_]);
+      os << "void";
     }
-    // Handle multiplicity
-    if (!attribute->unlimited_ && attribute->multiplicity_ > 1) {
-      workingFile << "[" << attribute->multiplicity_ << "]";
+
+    os << " " << op.operator_->name_ << "(";
+
+    std::span<const LoweredParam> params = context.model_.params(op);
+    for (size_t i = 0; i < params.size(); i++) {
+      outputType(os, params[i].type_);
+      os << " " << params[i].param_->name_;
+      if (i + 1 < params.size()) {
+        os << ", ";
+      }
     }
+
+    os << "){}" << endl;
+    return true;
+  } else {
+    return false;
   }
-  workingFile << " " << attribute->name_ << ";" << endl;
+}
+bool generateAttribute(std::ostream& os, const LoweredAttribute& attribute) {
+  outputVisibility(os, attribute.attribute_->visibility_);
+  outputType(os, attribute.type_);
+  os << " " << attribute.attribute_->name_ << ";" << endl;
   return true;
 }
 
-bool generateModule(std::ostream& os, ModuleNode* module) {
+bool renderModule(JavaRenderContext& context, std::ostream& os, LoweredModel::Index index) {
   bool result = true;
+  const LoweredModel::Module& lowered = context.model_.module(index);
+  const ModuleNode* module = lowered.module_;
   if (!checkSingleInheritance(module)) {
     result = false;
     cerr << "Generation error with module \"" << module->name_ << "\": Java does not support multiple inheritance" << endl;
@@ -318,107 +210,120 @@ bool generateModule(std::ostream& os, ModuleNode* module) {
   // If this needs to be added back in, we would just import everything
   // in the hard and soft dependancies
   //
-  // workingFile << "// Forward Decl" << endl;
+  // os << "// Forward Decl" << endl;
   // std::vector<string> deps = module->getSoftDependencies();
   // for (size_t i = 0; i < deps.size(); i++) {
   //   if (!generatedSymbols[deps[i]] && classImports[deps[i]] != classImports[module->id_]) {
-  //     workingFile << "import " << classImports[deps[i]] << ";" << endl;
+  //     os << "import " << classImports[deps[i]] << ";" << endl;
   //   }
   // }
 
-  workingFile << endl;
+  os << endl;
 
   if (module->visibility_ == Visibility::PUBLIC) {
-    workingFile << "public class " << module->name_;
+    os << "public class " << module->name_;
   } else if (module->visibility_ == Visibility::PRIVATE) {
-    workingFile << "private class " << module->name_;
+    os << "private class " << module->name_;
   } else if (module->visibility_ == Visibility::PROTECTED) {
-    workingFile << "protected class " << module->name_;
+    os << "protected class " << module->name_;
   } else if (module->visibility_ == Visibility::PACKAGE) {
-    workingFile << "class " << module->name_;
+    os << "class " << module->name_;
   }
 
   if (module->generalizations_.size() == 1) {
-    workingFile << " extends ";
-    outputFullName(idNameMap[module->generalizations_[0]]);
+    os << " extends ";
+    outputFullName(os, context.ids_.scope(module->generalizationHandles_[0]));
   }
-  workingFile << " {" << endl;
+  os << " {" << endl;
+
+  // Members are generated public, private, protected then package
+  const Visibility order[] = {Visibility::PUBLIC, Visibility::PRIVATE, Visibility::PROTECTED, Visibility::PACKAGE};
 
   // Generate nested modules
-  workingFile << "// modules" << endl;
-  for (size_t i = 0; i < module->publicModules_.size(); i++) {
-    result = generateModule(workingFile, module->publicModules_[i]) && result;
-  }
-  for (size_t i = 0; i < module->privateModules_.size(); i++) {
-    result = generateModule(workingFile, module->privateModules_[i]) && result;
-  }
-  for (size_t i = 0; i < module->protectedModules_.size(); i++) {
-    result = generateModule(workingFile, module->protectedModules_[i]) && result;
-  }
-  for (size_t i = 0; i < module->packageModules_.size(); i++) {
-    result = generateModule(workingFile, module->packageModules_[i]) && result;
+  os << "// modules" << endl;
+  for (Visibility visibility : order) {
+    for (LoweredModel::Index nested : context.model_.nested(index, visibility)) {
+      result = renderModule(context, os, nested) && result;
+    }
   }
 
   // Generate attributes
-  workingFile << "// attributes" << endl;
-  for (size_t i = 0; i < module->publicAttributes_.size(); i++) {
-    result = generateAttribute(workingFile, module->publicAttributes_[i]) && result;
-  }
-  for (size_t i = 0; i < module->privateAttributes_.size(); i++) {
-    result = generateAttribute(workingFile, module->privateAttributes_[i]) && result;
-  }
-  for (size_t i = 0; i < module->protectedAttributes_.size(); i++) {
-    result = generateAttribute(workingFile, module->protectedAttributes_[i]) && result;
-  }
-  for (size_t i = 0; i < module->packageAttributes_.size(); i++) {
-    result = generateAttribute(workingFile, module->packageAttributes_[i]) && result;
+  os << "// attributes" << endl;
+  for (Visibility visibility : order) {
+    for (auto& attribute : context.model_.attributes(index, visibility)) {
+      result = generateAttribute(os, attribute) && result;
+    }
   }
 
   // Generate operators
-  workingFile << "// operators" << endl;
-  for (size_t i = 0; i < module->publicOperators_.size(); i++) {
-    result = generateOperator(workingFile, module->publicOperators_[i]) && result;
-  }
-  for (size_t i = 0; i < module->privateOperators_.size(); i++) {
-    result = generateOperator(workingFile, module->privateOperators_[i]) && result;
-  }
-  for (size_t i = 0; i < module->protectedOperators_.size(); i++) {
-    result = generateOperator(workingFile, module->protectedOperators_[i]) && result;
-  }
-  for (size_t i = 0; i < module->packageOperators_.size(); i++) {
-    result = generateOperator(workingFile, module->packageOperators_[i]) && result;
+  os << "// operators" << endl;
+  for (Visibility visibility : order) {
+    for (auto& op : context.model_.operators(index, visibility)) {
+      result = generateOperator(context, os, op) && result;
+    }
   }
 
   // TODO: put main in proper spot
-  if (!mainGenerated) {
-    mainGenerated = true;
+  if (!context.mainGenerated_) {
+    context.mainGenerated_ = true;
 
-    workingFile << "public static void main(String[] args) {" << endl << endl;
-    workingFile << "}" << endl;
+    os << "public static void main(String[] args) {" << endl << endl;
+    os << "}" << endl;
   }
 
-  workingFile << "} // class " << module->name_ << " " << module->id_ << endl << endl;
+  os << "} // class " << module->name_ << " " << module->id_ << endl << endl;
 
-  generatedSymbols[module->id_] = true;
   return result;
 }
 
-bool generatePackage(ostream& os, Package* package) {
+bool generateModule(JavaRenderContext& context, std::ostream& os, LoweredModel::Index index) {
+  if (context.cache_ == nullptr) {
+    return renderModule(context, os, index);
+  }
+
+  const LoweredModel::Module& lowered = context.model_.module(index);
+  const ModuleNode* module = lowered.module_;
+
+  // main is emitted into the first rendered module so whether it was generated is part of the key
+  WideContentHasher hasher = moduleCacheKey(context.generator_.name(), context.generator_.version(), module, context.ids_);
+  hasher.add(context.mainGenerated_);
+  const CacheKey key = hasher.digest();
+
+  string text;
+  if (context.cache_->lookup(key, text)) {
+    os << text;
+    context.mainGenerated_ = true;
+    return true;
+  }
+
+  ostringstream rendered;
+  bool result = renderModule(context, rendered, index);
+  text = rendered.str();
+  os << text;
+  // Only cache successful renders so failures are reported again on the next run
+  if (result) {
+    context.cache_->store(key, text);
+  }
+  return result;
+}
+
+bool generatePackage(JavaRenderContext& context, ostream& os, const Package* package) {
   bool result = true;
 
   for (size_t i = 0; i < package->packages_.size(); i++) {
-    filesystem::create_directory(returnPackagePath(package->packages_[i]->fullyQualified_));
-    result = generatePackage(os, package->packages_[i]) && result;
+    filesystem::create_directory(returnPackagePath(*package->packages_[i]->scope_));
+    result = generatePackage(context, os, package->packages_[i]) && result;
   }
 
   for (size_t i = 0; i < package->modules_.size(); i++) {
-    if (workingFile.is_open()) {
-      workingFile.close();
+    if (!context.selected(package->modules_[i])) continue;
+    if (context.workingFile_.is_open()) {
+      context.workingFile_.close();
     }
-    workingFile.open(returnFileLocation(idNameMap[package->modules_[i]->id_]), ios::app);
-    workingFile << "package " << packageName(package->fullyQualified_) << ";" << endl;
+    context.workingFile_.open(returnFileLocation(*package->modules_[i]->scope_), ios::app);
+    context.workingFile_ << "package " << packageName(*package->scope_) << ";" << endl;
     if (package->modules_[i]->visibility_ == Visibility::PUBLIC || package->modules_[i]->visibility_ == Visibility::PACKAGE) {
-      result = generateModule(os, package->modules_[i]) && result;
+      result = generateModule(context, context.workingFile_, context.model_.find(package->modules_[i])) && result;
     } else {
       cerr << "Generation error with module \"" << package->modules_[i]->name_ << "\": Private and Protected modules must be nested in another module." << endl;
     }
@@ -427,10 +332,22 @@ bool generatePackage(ostream& os, Package* package) {
   return result;
 }
 
-bool JavaGenerator::generate(std::ostream& os, ModelNode* root) {
+bool JavaGenerator::generate(std::ostream& os, const ModelNode* root) {
   bool result = true;
   string rootPackage;  // keeps track of the root directory
-  idNameMap = root->idNameMap_;
+  JavaRenderContext context{*this, root->ids_, lowered(root), cache_};
+  ModelView<> view(root);
+  if (!targets_.empty()) {
+    view.flatten();
+    for (auto& target : view.select(targets_)) {
+      cerr << "No module matches target " << target << endl;
+    }
+    if (view.empty()) {
+      cerr << "No module to generate for the given targets" << endl;
+      return false;
+    }
+    context.selection_ = &view;
+  }
   string modelName = root->name_;
   rootPackage = "src/" + modelName;
   modelName = "src." + modelName;
@@ -439,21 +356,22 @@ bool JavaGenerator::generate(std::ostream& os, ModelNode* root) {
   filesystem::create_directory(rootPackage);
 
   for (size_t i = 0; i < root->modules_.size(); i++) {
-    if (workingFile.is_open()) {
-      workingFile.close();
+    if (!context.selected(root->modules_[i])) continue;
+    if (context.workingFile_.is_open()) {
+      context.workingFile_.close();
     }
-    workingFile.open(returnFileLocation(idNameMap[root->modules_[i]->id_]), ios::app);
-    workingFile << "package " << modelName << ";" << endl;
+    context.workingFile_.open(returnFileLocation(*root->modules_[i]->scope_), ios::app);
+    context.workingFile_ << "package " << modelName << ";" << endl;
     if (root->modules_[i]->visibility_ == Visibility::PUBLIC || root->modules_[i]->visibility_ == Visibility::PACKAGE) {
-      result = generateModule(os, root->modules_[i]) && result;
+      result = generateModule(context, context.workingFile_, context.model_.find(root->modules_[i])) && result;
     } else {
       cerr << "Generation error with module \"" << root->modules_[i]->name_ << "\": Private and Protected modules must be nested in another module." << endl;
     }
   }
 
   for (size_t i = 0; i < root->packages_.size(); i++) {
-    filesystem::create_directory(returnPackagePath(root->packages_[i]->fullyQualified_));
-    result = generatePackage(os, root->packages_[i]) && result;
+    filesystem::create_directory(returnPackagePath(*root->packages_[i]->scope_));
+    result = generatePackage(context, os, root->packages_[i]) && result;
     os << endl << endl;
   }
 
@@ -0,0 +1,43 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: SnapshotGenerator.cpp
+ * @brief:
+ *
+ ***********************************************************/
+#include "generators/SnapshotGenerator.hpp"
+
+#include "parsers/Snapshot.hpp"
+
+using namespace std;
+
+namespace XMR {
+
+bool SnapshotGenerator::generate(std::ostream& os, const ModelNode* root) {
+  if (!check(root)) {
+    cerr << "Cannot snapshot an empty model" << endl;
+    return false;
+  }
+
+  SnapshotWriter writer;
+  vector<char> snapshot = writer.write(root);
+  if (snapshot.empty()) return false;
+  os.write(snapshot.data(), snapshot.size());
+  return os.good();
+}
+
+extern "C" IGenerator* create_generator() { return new SnapshotGenerator; }
+extern "C" void destroy_generator(IGenerator* generator) { delete generator; }
+}  // namespace XMR
@@ -0,0 +1,504 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: FastXmiParser.cpp
+ * @brief:
+ *
+ ***********************************************************/
+#include "parsers/FastXmiParser.hpp"
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "parsers/Utf16Transcoder.hpp"
+
+using namespace std;
+namespace XMR {
+
+// Without a UTF-16 byte order mark the encoding named by the XML declaration must be UTF-8 or a
+// subset of it, the document is tokenized as it is mapped
+static bool isUtf8Document(const char* begin, const char* end) {
+  if (end - begin < 5 || memcmp(begin, "<?xml", 5) != 0) return true;
+
+  const char* declarationEnd = static_cast<const char*>(memchr(begin, '>', static_cast<size_t>(end - begin)));
+  if (declarationEnd == nullptr) return false;
+  const string declaration(begin, declarationEnd);
+  const size_t key = declaration.find("encoding");
+  if (key == string::npos) return true;
+  const size_t quote = declaration.find_first_of("\"'", key);
+  if (quote == string::npos) return false;
+  const size_t close = declaration.find(declaration[quote], quote + 1);
+  const string encoding = declaration.substr(quote + 1, close - quote - 1);
+  return strcasecmp(encoding.c_str(), "UTF-8") == 0 || strcasecmp(encoding.c_str(), "UTF8") == 0 || strcasecmp(encoding.c_str(), "US-ASCII") == 0 ||
+         strcasecmp(encoding.c_str(), "ASCII") == 0;
+}
+
+bool FastXmiParser::setInputFile(const char* fileName) {
+  int fd = open(fileName, O_RDONLY);
+  if (fd < 0) {
+    cerr << "Failed to open XMI file: " << fileName << endl;
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    cerr << "Failed to stat XMI file: " << fileName << endl;
+    close(fd);
+    return false;
+  }
+
+  // Private and writable, attribute values are decoded and terminated in place
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    cerr << "Failed to map XMI file: " << fileName << endl;
+    return false;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  mapping_ = shared_ptr<void>(data, [size](void* mapped) { munmap(mapped, size); });
+  begin_ = static_cast<char*>(data);
+  end_ = begin_ + size;
+
+  if (end_ - begin_ >= 2 && ((begin_[0] == '\xFF' && begin_[1] == '\xFE') || (begin_[0] == '\xFE' && begin_[1] == '\xFF'))) return transcodeDocument();
+  if (end_ - begin_ >= 3 && memcmp(begin_, "\xEF\xBB\xBF", 3) == 0) begin_ += 3;
+  if (!isUtf8Document(begin_, end_)) {
+    cerr << "Only UTF-8 and UTF-16 XMI documents are supported: " << fileName << endl;
+    mapping_.reset();
+    begin_ = end_ = nullptr;
+    return false;
+  }
+
+  return true;
+}
+
+// A UTF-16 document, recognized by its byte order mark, is transcoded once into a UTF-8 buffer
+// that replaces the mapping. Its XML declaration still names UTF-16 and is not checked.
+bool FastXmiParser::transcodeDocument() {
+  const bool bigEndian = begin_[0] == '\xFE';
+  const size_t length = static_cast<size_t>(end_ - begin_) / 2 - 1;
+  vector<char16_t> units(length);
+  memcpy(units.data(), begin_ + 2, length * 2);
+  if (bigEndian != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)) {
+    for (auto& unit : units) unit = static_cast<char16_t>((unit >> 8) | (unit << 8));
+  }
+
+  shared_ptr<char[]> document(new char[simd::utf8Capacity(length)]);
+  begin_ = document.get();
+  end_ = begin_ + simd::transcodeUtf16(units.data(), length, begin_);
+  mapping_ = std::move(document);
+  return true;
+}
+
+ModelNode* FastXmiParser::parse() {
+  if (mapping_ == nullptr) {
+    cerr << "No document loaded" << endl;
+    return nullptr;
+  }
+
+  tokenizer_ = XmiTokenizer(begin_, end_);
+  ids_ = IdIndex();
+  scopes_ = make_shared<ScopeTree>();
+  types_ = make_shared<TypeTable>();
+  currentScope_ = nullptr;
+  empty_ = shared_ptr<char[]>(new char[1]{});
+
+  XmiToken token = tokenizer_.next();
+  if (token != XmiToken::START) {
+    if (token == XmiToken::ERROR) tokenizerError();
+    cerr << "No Model in document" << endl;
+    return nullptr;
+  }
+
+  ModelNode* modelNode = parseModel();
+  if (modelNode == nullptr) return nullptr;
+
+  // The model owns the document and the empty string absent attributes point at
+  auto storage = make_shared<vector<shared_ptr<void>>>();
+  storage->push_back(std::move(mapping_));
+  storage->push_back(std::move(empty_));
+  modelNode->storage_ = std::move(storage);
+  modelNode->scopes_ = std::move(scopes_);
+  modelNode->types_ = std::move(types_);
+  begin_ = end_ = nullptr;
+  return modelNode;
+}
+
+FastXmiParser::UmlType FastXmiParser::umlType(const char* type) {
+  // Unknown types fall back to PACKAGE as a missing key does in PapyrusParser's type map
+  if (strncmp(type, "uml:", 4) != 0) return UmlType::PACKAGE;
+  const char* name = type + 4;
+  if (strcmp(name, "Class") == 0) return UmlType::CLASS;
+  if (strcmp(name, "Property") == 0) return UmlType::PROPERTY;
+  if (strcmp(name, "Operation") == 0) return UmlType::OPERATION;
+  if (strcmp(name, "Generalization") == 0) return UmlType::GENERALIZATION;
+  if (strcmp(name, "PackageImport") == 0) return UmlType::PACKAGE_IMPORT;
+  if (strcmp(name, "Interaction") == 0) return UmlType::INTERACTION;
+  if (strcmp(name, "Association") == 0) return UmlType::ASSOCIATION;
+  if (strcmp(name, "PrimitiveType") == 0) return UmlType::PRIMITIVE;
+  return UmlType::PACKAGE;
+}
+
+Visibility FastXmiParser::visibility(const char* visibility) {
+  if (strcmp(visibility, "private") == 0) return Visibility::PRIVATE;
+  if (strcmp(visibility, "protected") == 0) return Visibility::PROTECTED;
+  if (strcmp(visibility, "package") == 0) return Visibility::PACKAGE;
+  return Visibility::PUBLIC;
+}
+
+char* FastXmiParser::attribute(const char* name) const {
+  char* value = tokenizer_.attribute(name);
+  return value == nullptr ? empty_.get() : value;
+}
+
+bool FastXmiParser::tokenizerError() {
+  cerr << "XML Parser Error. Message: " << (tokenizer_.error() == nullptr ? "unexpected token" : tokenizer_.error()) << " at offset " << tokenizer_.offset() << endl;
+  return false;
+}
+
+ModelNode* FastXmiParser::parseModel() {
+  char* modelName = attribute("name");
+  char* modelId = attribute("xmi:id");
+  currentScope_ = scopes_->add(nullptr, modelName);
+  ModelNode* modelNode = new ModelNode(modelName, modelId, currentScope_);
+
+  while (true) {
+    XmiToken token = tokenizer_.next();
+    if (token == XmiToken::END) break;
+    if (token != XmiToken::START) {
+      tokenizerError();
+      return nullptr;
+    }
+
+    const UmlType type = umlType(attribute("xmi:type"));
+    switch (type) {
+      case UmlType::CLASS: {
+        ModuleNode* moduleNode = parseModule();
+        if (moduleNode == nullptr) {
+          cerr << "Failed to parse module" << endl;
+          return nullptr;
+        }
+        modelNode->addModule(moduleNode);
+        ids_.add(moduleNode);
+      } break;
+      case UmlType::PACKAGE: {
+        Package* packageNode = parsePackage();
+        if (packageNode == nullptr) {
+          cerr << "Failed to parse package" << endl;
+          return nullptr;
+        }
+        modelNode->addPackage(packageNode);
+      } break;
+
+      default:
+        cout << "UML Type Unimplemented: " << type << endl;
+        if (!tokenizer_.skipElement()) {
+          tokenizerError();
+          return nullptr;
+        }
+        break;
+    }
+  }
+  modelNode->ids_ = std::move(ids_);
+  ids_ = IdIndex();
+
+  currentScope_ = currentScope_->parent();
+
+  return modelNode;
+}
+
+Package* FastXmiParser::parsePackage() {
+  char* packageName = attribute("name");
+  char* packageId = attribute("xmi:id");
+  currentScope_ = scopes_->add(currentScope_, packageName);
+  Package* packageNode = new Package(packageName, packageId, currentScope_);
+
+  while (true) {
+    XmiToken token = tokenizer_.next();
+    if (token == XmiToken::END) break;
+    if (token != XmiToken::START) {
+      tokenizerError();
+      return nullptr;
+    }
+
+    const UmlType type = umlType(attribute("xmi:type"));
+    switch (type) {
+      case UmlType::CLASS: {
+        ModuleNode* moduleNode = parseModule();
+        if (moduleNode == nullptr) {
+          cerr << "Failed to parse module" << endl;
+          return nullptr;
+        }
+        ids_.add(moduleNode);
+        packageNode->addModule(moduleNode);
+      } break;
+      case UmlType::PACKAGE: {
+        Package* nestedPackageNode = parsePackage();
+        if (nestedPackageNode == nullptr) {
+          cerr << "Failed to parse package" << endl;
+          return nullptr;
+        }
+        packageNode->addPackage(nestedPackageNode);
+      } break;
+
+      default:
+        cout << "UML Type Unimplemented: " << type << endl;
+        if (!tokenizer_.skipElement()) {
+          tokenizerError();
+          return nullptr;
+        }
+        break;
+    }
+  }
+  currentScope_ = currentScope_->parent();
+  packageNode->computeHash();
+
+  return packageNode;
+}
+
+ModuleNode* FastXmiParser::parseModule() {
+  char* moduleName = attribute("name");
+  char* moduleId = attribute("xmi:id");
+  currentScope_ = scopes_->add(currentScope_, moduleName);
+  ModuleNode* moduleNode = new ModuleNode(moduleName, moduleId, currentScope_, visibility(attribute("visibility")));
+
+  while (true) {
+    XmiToken token = tokenizer_.next();
+    if (token == XmiToken::END) break;
+    if (token != XmiToken::START) {
+      tokenizerError();
+      return nullptr;
+    }
+
+    const UmlType type = umlType(attribute("xmi:type"));
+    switch (type) {
+      case UmlType::CLASS: {
+        ModuleNode* nestedModuleNode = parseModule();
+        if (nestedModuleNode == nullptr) {
+          cerr << "Failed to parse module" << endl;
+          return nullptr;
+        }
+        ids_.add(nestedModuleNode);
+        moduleNode->addModule(nestedModuleNode);
+      } break;
+      case UmlType::OPERATION: {
+        Operator* operatorNode = parseOperator();
+        if (operatorNode == nullptr) {
+          cerr << "Failed to parse operator" << endl;
+          return nullptr;
+        }
+        moduleNode->addOperator(operatorNode);
+      } break;
+      case UmlType::PROPERTY: {
+        Attribute* attributeNode = parseAttribute();
+        if (attributeNode == nullptr) {
+          cerr << "Failed to parse attribute" << endl;
+          return nullptr;
+        }
+        moduleNode->addAttribute(attributeNode);
+      } break;
+
+      case UmlType::GENERALIZATION: {
+        moduleNode->addGeneralization(attribute("general"));
+        if (!tokenizer_.skipElement()) {
+          tokenizerError();
+          return nullptr;
+        }
+      } break;
+
+      default:
+        cout << "UML Type Unimplemented: " << type << endl;
+        if (!tokenizer_.skipElement()) {
+          tokenizerError();
+          return nullptr;
+        }
+        break;
+    }
+  }
+  currentScope_ = currentScope_->parent();
+  moduleNode->computeHash();
+
+  return moduleNode;
+}
+
+// Collects type, lowerValue and upperValue from anywhere below the current element, as
+// getElementsByTagName does, and consumes it up to its end tag
+bool FastXmiParser::readTypedElement(TypedElement& element) {
+  size_t depth = 1;
+  while (depth != 0) {
+    switch (tokenizer_.next()) {
+      case XmiToken::START: {
+        depth++;
+        const string_view name = tokenizer_.name();
+        if (name == "type") {
+          if (!element.hasTypeElement_) {
+            element.hasTypeElement_ = true;
+            element.typeHref_ = attribute("href");
+          }
+        } else if (name == "lowerValue") {
+          if (element.lowerCount_++ == 0) element.lowerValue_ = attribute("value");
+        } else if (name == "upperValue") {
+          if (element.upperCount_++ == 0) element.upperValue_ = attribute("value");
+        }
+      } break;
+      case XmiToken::END:
+        depth--;
+        break;
+      default:
+        return tokenizerError();
+    }
+  }
+  return true;
+}
+
+template <typename T>
+bool FastXmiParser::applyBounds(T* node, const TypedElement& element, const char* kind) {
+  if (element.lowerCount_ > 1) {
+    cerr << kind << " can only support 1 lower bound!";
+    return false;
+  }
+  node->nilable_ = element.lowerCount_ == 1 && element.lowerValue_[0] == '\0';
+
+  if (element.upperCount_ > 1) {
+    cerr << kind << " can only support 1 upper bound!";
+    return false;
+  }
+  if (element.upperCount_ == 1) {
+    if (strcmp(element.upperValue_, "*") == 0) {
+      node->unlimited_ = true;
+    } else {
+      node->unlimited_ = false;
+      node->multiplicity_ = atoi(element.upperValue_);
+    }
+  } else {
+    node->unlimited_ = false;
+  }
+  return true;
+}
+
+Param* FastXmiParser::parseParam(char* operatorName, bool& isReturn) {
+  char* direction = attribute("direction");
+  char* id = attribute("xmi:id");
+  char* name = attribute("name");
+  char* type = tokenizer_.attribute("type");
+
+  TypedElement element;
+  if (!readTypedElement(element)) return nullptr;
+
+  Type* typeNode = nullptr;
+  if (type == nullptr) {
+    // Check worst case no type associated return nullptr!
+    if (!element.hasTypeElement_) {
+      cerr << "No type associated with operator parameter: " << name << " param Id: " << id << " for operator: " << operatorName << endl;
+      return nullptr;
+    }
+    // primitive type
+    typeNode = types_->intern(element.typeHref_, true);
+  } else {
+    typeNode = types_->intern(type);
+  }
+
+  Param* paramNode = nullptr;
+  isReturn = strcmp(direction, "return") == 0;
+  if (isReturn) {
+    paramNode = new Param(name, id, typeNode);
+  } else if (strcmp(direction, "out") == 0) {
+    // reference/pointer
+    paramNode = new Param(name, id, typeNode, Direction::OUT);
+  } else {
+    // By copy
+    paramNode = new Param(name, id, typeNode);
+  }
+
+  if (!applyBounds(paramNode, element, isReturn ? "Return node" : "Params")) return nullptr;
+  return paramNode;
+}
+
+Operator* FastXmiParser::parseOperator() {
+  char* operatorName = attribute("name");
+  char* operatorId = attribute("xmi:id");
+  Operator* operatorNode = new Operator(operatorName, operatorId, visibility(attribute("visibility")));
+
+  // Parameters may sit anywhere below the operation, anything else in it is skipped
+  size_t depth = 1;
+  while (depth != 0) {
+    switch (tokenizer_.next()) {
+      case XmiToken::START: {
+        if (tokenizer_.name() != "ownedParameter") {
+          depth++;
+          break;
+        }
+        bool isReturn = false;
+        Param* paramNode = parseParam(operatorName, isReturn);
+        if (paramNode == nullptr) return nullptr;
+        if (isReturn) {
+          operatorNode->addReturnType(paramNode);
+        } else {
+          operatorNode->addParam(paramNode);
+        }
+      } break;
+      case XmiToken::END:
+        depth--;
+        break;
+      default:
+        tokenizerError();
+        return nullptr;
+    }
+  }
+
+  return operatorNode;
+}
+
+Attribute* FastXmiParser::parseAttribute() {
+  char* attributeName = attribute("name");
+  char* attributeId = attribute("xmi:id");
+  const Visibility attributeVisibility = visibility(attribute("visibility"));
+  char* type = tokenizer_.attribute("type");
+
+  TypedElement element;
+  if (!readTypedElement(element)) return nullptr;
+
+  Type* typeNode = nullptr;
+  // If fail means primitive type
+  if (type == nullptr) {
+    // Check worst case no type associated return nullptr!
+    if (!element.hasTypeElement_) {
+      cerr << "No type associated with property: " << attributeName << " property Id: " << attributeId << endl;
+      return nullptr;
+    }
+    // primitive type
+    typeNode = types_->intern(element.typeHref_, true);
+  } else {
+    typeNode = types_->intern(type);
+  }
+
+  Attribute* attributeNode = new Attribute(attributeName, attributeId, typeNode, attributeVisibility);
+  if (!applyBounds(attributeNode, element, "Attributes")) return nullptr;
+
+  return attributeNode;
+}
+
+extern "C" IParser* create_parser() { return new FastXmiParser; }
+extern "C" void destroy_parser(IParser* parser) { delete parser; }
+
+}  // namespace XMR
@@ -19,12 +19,18 @@
  ***********************************************************/
 #include "parsers/PapyrusParser.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/sax/HandlerBase.hpp>
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
+
+#include "parsers/TrackingMemoryManager.hpp"
 
 using namespace xercesc;
 using namespace std;
@@ -33,7 +39,8 @@ namespace XMR {
 // Constructor
 PapyrusParser::PapyrusParser() {
   try {
-    XMLPlatformUtils::Initialize();
+    // Everything Xerces allocates, the DOM included, is counted for --stats
+    XMLPlatformUtils::Initialize(XMLUni::fgXercescDefaultLocale, nullptr, nullptr, &TrackingMemoryManager::instance());
 
   } catch (const XMLException& toCatch) {
     char* message = XMLString::transcode(toCatch.getMessage());
@@ -41,18 +48,7 @@ PapyrusParser::PapyrusParser() {
     XMLString::release(&message);
   }
 
-  parser_ = new XercesDOMParser();
   errHandler_ = new HandlerBase();
-  parser_->setErrorHandler(errHandler_);
-
-  parser_->setValidationScheme(XercesDOMParser::Val_Always);
-  parser_->setDoNamespaces(true);
-  parser_->setLoadSchema(true);
-  //!@todo: Find elegant way of loading schema file in project
-  // assert(parser_->loadGrammar(schemaLocation_.c_str(),
-  //                             Grammar::GrammarType::SchemaGrammarType,
-  //                             true) != nullptr);
-  parser_->setDoSchema(true);
 
   idKey_ = XMLString::transcode("xmi:id");
   typeKey_ = XMLString::transcode("xmi:type");
@@ -66,11 +62,12 @@ PapyrusParser::PapyrusParser() {
   lowerValueAttrKey_ = XMLString::transcode("lowerValue");
   upperValueAttrKey_ = XMLString::transcode("upperValue");
   valueKey_ = XMLString::transcode("value");
+  directionKey_ = XMLString::transcode("direction");
 }
 
 // Destructor
 PapyrusParser::~PapyrusParser() {
-  delete parser_;
+  releaseDocument();
   delete errHandler_;
   XMLString::release(&idKey_);
   XMLString::release(&typeKey_);
@@ -78,9 +75,109 @@ PapyrusParser::~PapyrusParser() {
   XMLPlatformUtils::Terminate();
 }
 
+// The DOM parser and everything it builds live in the document arena, a new document starts
+// from an empty arena with a fresh parser.
+void PapyrusParser::createDocumentParser() {
+  releaseDocument();
+  parser_ = new XercesDOMParser(nullptr, &documentArena_);
+  parser_->setErrorHandler(errHandler_);
+
+  parser_->setValidationScheme(XercesDOMParser::Val_Always);
+  parser_->setDoNamespaces(true);
+  // Workers read attribute values concurrently. Attributes with entity reference children have
+  // their value built lazily in the shared document pool on first read, expanding references in
+  // place keeps every value a single text node that reading never writes.
+  parser_->setCreateEntityReferenceNodes(false);
+  parser_->setLoadSchema(true);
+  //!@todo: Find elegant way of loading schema file in project
+  // assert(parser_->loadGrammar(schemaLocation_.c_str(),
+  //                             Grammar::GrammarType::SchemaGrammarType,
+  //                             true) != nullptr);
+  parser_->setDoSchema(true);
+}
+
+// Deleting the parser only runs destructors, the arena ignores deallocations and frees the whole
+// DOM in one go on reset.
+void PapyrusParser::releaseDocument() {
+  delete parser_;
+  parser_ = nullptr;
+  documentArena_.reset();
+}
+
+// Transcoding goes through the vectorized transcoder rather than XMLString::transcode, which
+// takes the locale's generic path and a heap block per string. Output is always UTF-8.
+static_assert(sizeof(XMLCh) == sizeof(char16_t), "XMLCh must be a UTF-16 code unit");
+
+char* PapyrusParser::scratch(ParseContext& context, const XMLCh* text) {
+  if (text == nullptr) return nullptr;
+  const XMLSize_t length = XMLString::stringLen(text);
+  char* out = static_cast<char*>(context.scratch_.allocate(simd::utf8Capacity(length) + 1));
+  out[simd::transcodeUtf16(reinterpret_cast<const char16_t*>(text), length, out)] = '\0';
+  return out;
+}
+
+char* PapyrusParser::keep(ParseContext& context, const XMLCh* text) { return context.strings_.transcode(reinterpret_cast<const char16_t*>(text), XMLString::stringLen(text)); }
+
+// Unknown types read as PACKAGE, what a missing key default constructs to. The map is never
+// written to as workers share it.
+PapyrusParser::UmlType PapyrusParser::umlType(const char* type) const {
+  auto found = umlStringIdMap_.find(type);
+  return found == umlStringIdMap_.end() ? UmlType::PACKAGE : found->second;
+}
+
+/**
+ * Collects elements below root with the given tag name in document order, what
+ * getElementsByTagName finds. The node lists Xerces returns are cached in the document, this walk
+ * leaves the DOM untouched so it is safe from several threads.
+ *
+ * @param[in] root element to search below, not included
+ * @param[in] tag tag name to match
+ * @param[out] found matching elements
+ * @param[in] limit stop once this many are found
+ */
+static void findDescendants(DOMNode* root, const XMLCh* tag, vector<DOMElement*>& found, size_t limit = SIZE_MAX) {
+  DOMNode* node = root->getFirstChild();
+  while (node != nullptr && found.size() < limit) {
+    if (node->getNodeType() == DOMNode::NodeType::ELEMENT_NODE && XMLString::equals(static_cast<DOMElement*>(node)->getTagName(), tag)) {
+      found.push_back(static_cast<DOMElement*>(node));
+    }
+    if (node->getFirstChild() != nullptr) {
+      node = node->getFirstChild();
+      continue;
+    }
+    while (node != root && node->getNextSibling() == nullptr) node = node->getParentNode();
+    node = node == root ? nullptr : node->getNextSibling();
+  }
+}
+
+static DOMElement* findDescendant(DOMNode* root, const XMLCh* tag) {
+  vector<DOMElement*> found;
+  findDescendants(root, tag, found, 1);
+  return found.empty() ? nullptr : found[0];
+}
+
+// Sums the Xerces wide manager and the document arena, the peak is an upper bound as the two
+// may have peaked at different times
+bool PapyrusParser::memoryStats(MemoryStats& stats) const {
+  const MemoryStats xerces = TrackingMemoryManager::instance().stats();
+  const MemoryStats& arena = documentArena_.stats();
+  stats.allocations_ = xerces.allocations_ + arena.allocations_;
+  stats.bytes_ = xerces.bytes_ + arena.bytes_;
+  stats.liveBytes_ = xerces.liveBytes_ + arena.liveBytes_;
+  stats.peakLiveBytes_ = xerces.peakLiveBytes_ + arena.peakLiveBytes_;
+  return true;
+}
+
+bool PapyrusParser::setParallelism(unsigned threads) {
+  parallelism_ = threads == 0 ? 1 : threads;
+  return true;
+}
+
 bool PapyrusParser::setInputFile(const char* fileName) {
   if (!filesystem::exists(fileName)) return false;
 
+  createDocumentParser();
+
   try {
     parser_->parse(fileName);
   } catch (const XMLException& toCatch) {
@@ -112,6 +209,28 @@ bool PapyrusParser::setInputFile(const char* fileName) {
 }
 
 ModelNode* PapyrusParser::parse() {
+  if (parser_ == nullptr) {
+    cerr << "No document loaded" << endl;
+    return nullptr;
+  }
+  strings_ = make_shared<StringPool>();
+  scopes_ = make_shared<ScopeTree>();
+  types_ = make_shared<TypeTable>();
+  ModelNode* modelNode = parseDocument();
+  // The model does not point into the DOM, it can go as soon as the tree is built
+  releaseDocument();
+  if (modelNode != nullptr) {
+    modelNode->storage_ = std::move(strings_);
+    modelNode->scopes_ = std::move(scopes_);
+    modelNode->types_ = std::move(types_);
+  }
+  strings_.reset();
+  scopes_.reset();
+  types_.reset();
+  return modelNode;
+}
+
+ModelNode* PapyrusParser::parseDocument() {
   DOMDocument* doc = parser_->getDocument();
   if (doc == nullptr) {
     cerr << "Failed to get DOM doc" << endl;
@@ -137,260 +256,309 @@ ModelNode* PapyrusParser::parse() {
   return parseModel(nodes->item(0));
 }
 
+// Frees a subtree that never made it into a model, types and names belong to the parser
+static void freeTree(ModuleNode* module) {
+  for (ModuleNode* nested : module->modules_) freeTree(nested);
+  for (Operator* op : module->operators_) {
+    for (Param* param : op->params_) delete param;
+    delete op->returnType_;
+    delete op;
+  }
+  for (Attribute* attribute : module->attributes_) delete attribute;
+  delete module;
+}
+
+static void freeTree(Package* package) {
+  for (Package* nested : package->packages_) freeTree(nested);
+  for (ModuleNode* module : package->modules_) freeTree(module);
+  for (Relationship* relationship : package->relationships_) delete relationship;
+  delete package;
+}
+
 ModelNode* PapyrusParser::parseModel(DOMNode* model) {
   if (model->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
     cerr << "Model must be DOM element" << endl;
     return nullptr;
   }
   DOMElement* modelDomElement = static_cast<DOMElement*>(model);
-  char* modelName = XMLString::transcode(modelDomElement->getAttribute(nameKey_));
-  char* modelId = XMLString::transcode(modelDomElement->getAttribute(idKey_));
-  currentScope_.push_back(modelName);
-  ModelNode* modelNode = new ModelNode(modelName, modelId, currentScope_);
-
-  // Grab children
-  DOMNodeList* nodes = modelDomElement->getChildNodes();
-
-  if (nodes != nullptr) {
-    // Loop through children of the model
-    while (nodes->getLength() > 0) {
-      DOMNode* node = nodes->item(0);
-
-      // Unsure why DOM has empty text nodes layered in teh children nodes of
-      // the model node?
-      if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
-        modelDomElement->removeChild(node)->release();
+  ParseContext modelContext;
+  char* modelName = keep(modelContext, modelDomElement->getAttribute(nameKey_));
+  char* modelId = keep(modelContext, modelDomElement->getAttribute(idKey_));
+  modelContext.currentScope_ = scopes_->add(nullptr, modelName);
+  ModelNode* modelNode = new ModelNode(modelName, modelId, modelContext.currentScope_);
+
+  // Children of the model are independent subtrees, each is parsed into a result of its own
+  vector<ParseResult> results;
+  for (DOMNode* node = modelDomElement->getFirstChild(); node != nullptr; node = node->getNextSibling()) {
+    // Unsure why DOM has empty text nodes layered in teh children nodes of
+    // the model node?
+    if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
 #ifdef DEBUG
-        cout << "Skipping Text Node!" << endl;
+      cout << "Skipping Text Node!" << endl;
 #endif
-        continue;
-      }
+      continue;
+    }
 
-      if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
-        cerr << "Model children must be DOM element. Element was of type: ";
-        cerr << node->getNodeType() << endl;
-        return nullptr;
-      }
+    if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
+      cerr << "Model children must be DOM element. Element was of type: ";
+      cerr << node->getNodeType() << endl;
+      delete modelNode;
+      return nullptr;
+    }
+    results.emplace_back();
+    results.back().element_ = static_cast<DOMElement*>(node);
+  }
 
-      DOMElement* domElement = static_cast<DOMElement*>(node);
-      char* type = XMLString::transcode(domElement->getAttribute(typeKey_));
-      if (type == nullptr) {
-        cerr << "Model children nodes must have attributes." << endl;
-        return nullptr;
+  // Workers take the next unparsed child until none are left, one worker parses on this thread.
+  // A failure only stops the children after the first failing one, everything before it is still
+  // parsed so its output and errors come out just like a sequential walk would print them.
+  const size_t workers = min<size_t>(parallelism_, results.size());
+  vector<unique_ptr<ParseContext>> contexts;
+  for (size_t i = 0; i < max<size_t>(workers, 1); i++) {
+    contexts.push_back(make_unique<ParseContext>());
+    contexts.back()->currentScope_ = modelContext.currentScope_;
+  }
+  atomic<size_t> next{0};
+  atomic<size_t> firstFailed{results.size()};
+  auto work = [&](ParseContext& context) {
+    // Claimed indices only grow, once one is past the first failure all later ones are too
+    for (size_t i = next++; i < results.size() && i < firstFailed; i = next++) {
+      parseModelChild(context, results[i]);
+      if (results[i].ok_) continue;
+      size_t failed = firstFailed;
+      while (i < failed && !firstFailed.compare_exchange_weak(failed, i)) {
       }
-
-      switch (umlStringIdMap_[type]) {
-        case UmlType::CLASS: {
-          ModuleNode* moduleNode = parseModule(domElement);
-          if (moduleNode == nullptr) {
-            cerr << "Failed to parse module" << endl;
-            return nullptr;
-          }
-          modelNode->addModule(moduleNode);
-          idNameMap_[moduleNode->id_] = moduleNode->fullyQualified_;
-
-        } break;
-        case UmlType::PACKAGE: {
-          Package* packageNode = parsePackage(domElement);
-          if (packageNode == nullptr) {
-            cerr << "Failed to parse package" << endl;
-            return nullptr;
-          }
-          modelNode->addPackage(packageNode);
-
-        } break;
-
-        default:
-          cout << "UML Type Unimplemented: " << umlStringIdMap_[type] << endl;
-          break;
+    }
+  };
+  vector<thread> threads;
+  for (size_t i = 1; i < workers; i++) threads.emplace_back(work, ref(*contexts[i]));
+  work(*contexts[0]);
+  for (auto& worker : threads) worker.join();
+
+  // Merging in document order gives the same model, id map and output as a sequential walk
+  for (size_t i = 0; i < results.size(); i++) {
+    cout << results[i].out_;
+    cerr << results[i].err_;
+    if (i == firstFailed) {
+      // Nothing is added to the model before the merge, so every parsed subtree is still ours
+      for (auto& result : results) {
+        if (result.module_ != nullptr) freeTree(result.module_);
+        if (result.package_ != nullptr) freeTree(result.package_);
       }
-      modelDomElement->removeChild(node)->release();
-      XMLString::release(&type);
+      delete modelNode;
+      return nullptr;
     }
+    if (results[i].module_ != nullptr) modelNode->addModule(results[i].module_);
+    if (results[i].package_ != nullptr) modelNode->addPackage(results[i].package_);
+    for (auto& module : results[i].ids_) modelNode->ids_.add(module);
   }
-  modelNode->idNameMap_ = this->idNameMap_;
 
-  currentScope_.pop_back();
+  strings_->absorb(std::move(modelContext.strings_));
+  for (auto& context : contexts) strings_->absorb(std::move(context->strings_));
 
   return modelNode;
 }
 
+void PapyrusParser::parseModelChild(ParseContext& context, ParseResult& result) {
+  context.result_ = &result;
+  DOMElement* domElement = result.element_;
+  char* type = scratch(context, domElement->getAttribute(typeKey_));
+  if (type == nullptr) {
+    context.err_ << "Model children nodes must have attributes." << endl;
+  } else {
+    switch (umlType(type)) {
+      case UmlType::CLASS: {
+        ModuleNode* moduleNode = parseModule(context, domElement);
+        if (moduleNode == nullptr) {
+          context.err_ << "Failed to parse module" << endl;
+          break;
+        }
+        result.module_ = moduleNode;
+        result.ids_.push_back(moduleNode);
+        result.ok_ = true;
+      } break;
+      case UmlType::PACKAGE: {
+        Package* packageNode = parsePackage(context, domElement);
+        if (packageNode == nullptr) {
+          context.err_ << "Failed to parse package" << endl;
+          break;
+        }
+        result.package_ = packageNode;
+        result.ok_ = true;
+      } break;
+
+      default:
+        context.out_ << "UML Type Unimplemented: " << umlType(type) << endl;
+        result.ok_ = true;
+        break;
+    }
+  }
+
+  result.out_ = context.out_.str();
+  result.err_ = context.err_.str();
+  context.out_.str("");
+  context.err_.str("");
+  context.scratch_.reset();
+  context.result_ = nullptr;
+}
+
 //
-Package* PapyrusParser::parsePackage(xercesc::DOMElement* package) {
-  char* packageName = XMLString::transcode(package->getAttribute(nameKey_));
-  char* packageId = XMLString::transcode(package->getAttribute(idKey_));
-  currentScope_.push_back(packageName);
-  Package* packageNode = new Package(packageName, packageId, currentScope_);
-
-  // Grab children
-  DOMNodeList* nodes = package->getChildNodes();
-
-  if (nodes != nullptr) {
-    // Loop through children of the package
-    while (nodes->getLength() > 0) {
-      DOMNode* node = nodes->item(0);
-
-      // Unsure why DOM has empty text nodes layered in the children nodes?
-      if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
-        package->removeChild(node)->release();
+Package* PapyrusParser::parsePackage(ParseContext& context, xercesc::DOMElement* package) {
+  char* packageName = keep(context, package->getAttribute(nameKey_));
+  char* packageId = keep(context, package->getAttribute(idKey_));
+  context.currentScope_ = scopes_->add(context.currentScope_, packageName);
+  Package* packageNode = new Package(packageName, packageId, context.currentScope_);
+
+  // Loop through children of the package
+  for (DOMNode* node = package->getFirstChild(); node != nullptr; node = node->getNextSibling()) {
+    // Unsure why DOM has empty text nodes layered in the children nodes?
+    if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
 #ifdef DEBUG
-        cout << "Skipping Text Node!" << endl;
+      context.out_ << "Skipping Text Node!" << endl;
 #endif
-        continue;
-      }
+      continue;
+    }
 
-      if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
-        cerr << "Package children must be DOM element. Element was of type: ";
-        cerr << node->getNodeType() << endl;
-        return nullptr;
-      }
+    if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
+      context.err_ << "Package children must be DOM element. Element was of type: ";
+      context.err_ << node->getNodeType() << endl;
+      return nullptr;
+    }
 
-      DOMElement* domElement = static_cast<DOMElement*>(node);
-      char* type = XMLString::transcode(domElement->getAttribute(typeKey_));
-      if (type == nullptr) {
-        cerr << "Package children nodes must have attributes." << endl;
-        return nullptr;
-      }
+    DOMElement* domElement = static_cast<DOMElement*>(node);
+    char* type = scratch(context, domElement->getAttribute(typeKey_));
+    if (type == nullptr) {
+      context.err_ << "Package children nodes must have attributes." << endl;
+      return nullptr;
+    }
 
-      switch (umlStringIdMap_[type]) {
-        case UmlType::CLASS: {
-          ModuleNode* moduleNode = parseModule(domElement);
-          if (moduleNode == nullptr) {
-            cerr << "Failed to parse module" << endl;
-            return nullptr;
-          }
-          idNameMap_[moduleNode->id_] = moduleNode->fullyQualified_;
-          packageNode->addModule(moduleNode);
-        } break;
-        case UmlType::PACKAGE: {
-          Package* packageNode = parsePackage(domElement);
-          if (packageNode == nullptr) {
-            cerr << "Failed to parse package" << endl;
-            return nullptr;
-          }
-          packageNode->addPackage(packageNode);
-
-        } break;
-
-        default:
-          cout << "UML Type Unimplemented: " << umlStringIdMap_[type] << endl;
-          break;
-      }
-      package->removeChild(node)->release();
-      XMLString::release(&type);
+    switch (umlType(type)) {
+      case UmlType::CLASS: {
+        ModuleNode* moduleNode = parseModule(context, domElement);
+        if (moduleNode == nullptr) {
+          context.err_ << "Failed to parse module" << endl;
+          return nullptr;
+        }
+        context.result_->ids_.push_back(moduleNode);
+        packageNode->addModule(moduleNode);
+      } break;
+      case UmlType::PACKAGE: {
+        Package* nestedPackageNode = parsePackage(context, domElement);
+        if (nestedPackageNode == nullptr) {
+          context.err_ << "Failed to parse package" << endl;
+          return nullptr;
+        }
+        packageNode->addPackage(nestedPackageNode);
+
+      } break;
+
+      default:
+        context.out_ << "UML Type Unimplemented: " << umlType(type) << endl;
+        break;
     }
   }
-  currentScope_.pop_back();
+  context.currentScope_ = context.currentScope_->parent();
+  packageNode->computeHash();
 
   return packageNode;
 }
 
-ModuleNode* PapyrusParser::parseModule(xercesc::DOMElement* mod) {
-  char* moduleName = XMLString::transcode(mod->getAttribute(nameKey_));
-  char* moduleId = XMLString::transcode(mod->getAttribute(idKey_));
+ModuleNode* PapyrusParser::parseModule(ParseContext& context, xercesc::DOMElement* mod) {
+  char* moduleName = keep(context, mod->getAttribute(nameKey_));
+  char* moduleId = keep(context, mod->getAttribute(idKey_));
   const XMLCh* visAtt = mod->getAttribute(visibilityKey_);
-  char* visibility;
+  char* visibility = nullptr;
   if (visAtt != nullptr) {
-    visibility = XMLString::transcode(visAtt);
+    visibility = scratch(context, visAtt);
   }
-  currentScope_.push_back(moduleName);
+  context.currentScope_ = scopes_->add(context.currentScope_, moduleName);
   ModuleNode* moduleNode;
   if (visibility == nullptr)
-    moduleNode = new ModuleNode(moduleName, moduleId, currentScope_);
+    moduleNode = new ModuleNode(moduleName, moduleId, context.currentScope_);
   else {
     // Double check its private first
     //!@todo: Do we handle protected?
     if (strcmp(visibility, "private") == 0) {
-      moduleNode = new ModuleNode(moduleName, moduleId, currentScope_, Visibility::PRIVATE);
+      moduleNode = new ModuleNode(moduleName, moduleId, context.currentScope_, Visibility::PRIVATE);
     } else if (strcmp(visibility, "protected") == 0) {
-      moduleNode = new ModuleNode(moduleName, moduleId, currentScope_, Visibility::PROTECTED);
+      moduleNode = new ModuleNode(moduleName, moduleId, context.currentScope_, Visibility::PROTECTED);
     } else if (strcmp(visibility, "package") == 0) {
-      moduleNode = new ModuleNode(moduleName, moduleId, currentScope_, Visibility::PACKAGE);
+      moduleNode = new ModuleNode(moduleName, moduleId, context.currentScope_, Visibility::PACKAGE);
     } else {
-      moduleNode = new ModuleNode(moduleName, moduleId, currentScope_);
+      moduleNode = new ModuleNode(moduleName, moduleId, context.currentScope_);
     }
   }
-  XMLString::release(&visibility);
-
-  // Grab children
-  DOMNodeList* nodes = mod->getChildNodes();
-
-  if (nodes != nullptr) {
-    while (nodes->getLength() > 0) {
-      DOMNode* node = nodes->item(0);
 
-      // Unsure why DOM has empty text nodes layered in teh children nodes?
-      if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
-        mod->removeChild(node)->release();
+  for (DOMNode* node = mod->getFirstChild(); node != nullptr; node = node->getNextSibling()) {
+    // Unsure why DOM has empty text nodes layered in teh children nodes?
+    if (node->getNodeType() == DOMNode::NodeType::TEXT_NODE) {
 #ifdef DEBUG
-        cout << "Skipping Text Node!" << endl;
+      context.out_ << "Skipping Text Node!" << endl;
 #endif
-        continue;
-      }
+      continue;
+    }
 
-      if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
-        cerr << "Module children must be DOM element. Element was of type : ";
-        cerr << node->getNodeType() << endl;
-        return nullptr;
-      }
+    if (node->getNodeType() != DOMNode::NodeType::ELEMENT_NODE) {
+      context.err_ << "Module children must be DOM element. Element was of type : ";
+      context.err_ << node->getNodeType() << endl;
+      return nullptr;
+    }
 
-      DOMElement* domElement = static_cast<DOMElement*>(node);
-      char* type = XMLString::transcode(domElement->getAttribute(typeKey_));
-      if (type == nullptr) {
-        cerr << "Module children nodes must have attributes." << endl;
-        return nullptr;
-      }
+    DOMElement* domElement = static_cast<DOMElement*>(node);
+    char* type = scratch(context, domElement->getAttribute(typeKey_));
+    if (type == nullptr) {
+      context.err_ << "Module children nodes must have attributes." << endl;
+      return nullptr;
+    }
 
-      switch (umlStringIdMap_[type]) {
-        case UmlType::CLASS: {
-          ModuleNode* nestedModuleNode = parseModule(domElement);
-          if (nestedModuleNode == nullptr) {
-            cerr << "Failed to parse module" << endl;
-            return nullptr;
-          }
-          idNameMap_[nestedModuleNode->id_] = nestedModuleNode->fullyQualified_;
-          moduleNode->addModule(nestedModuleNode);
-        } break;
-        case UmlType::OPERATION: {
-          Operator* operatorNode = parseOperator(domElement);
-          if (operatorNode == nullptr) {
-            cerr << "Failed to parse operator" << endl;
-            return nullptr;
-          }
-          moduleNode->addOperator(operatorNode);
-        } break;
-        case UmlType::PROPERTY: {
-          Attribute* attributeNode = parseAttribute(domElement);
-          if (attributeNode == nullptr) {
-            cerr << "Failed to parse attribute" << endl;
-            return nullptr;
-          }
-          moduleNode->addAttribute(attributeNode);
-
-        } break;
-
-        case UmlType::GENERALIZATION: {
-          char* generalType = XMLString::transcode(domElement->getAttribute(generalKey_));
-          moduleNode->addGeneralization(generalType);
-        } break;
-
-        default:
-          cout << "UML Type Unimplemented: " << umlStringIdMap_[type] << endl;
-          break;
-      }
-      mod->removeChild(node)->release();
-      XMLString::release(&type);
+    switch (umlType(type)) {
+      case UmlType::CLASS: {
+        ModuleNode* nestedModuleNode = parseModule(context, domElement);
+        if (nestedModuleNode == nullptr) {
+          context.err_ << "Failed to parse module" << endl;
+          return nullptr;
+        }
+        context.result_->ids_.push_back(nestedModuleNode);
+        moduleNode->addModule(nestedModuleNode);
+      } break;
+      case UmlType::OPERATION: {
+        Operator* operatorNode = parseOperator(context, domElement);
+        if (operatorNode == nullptr) {
+          context.err_ << "Failed to parse operator" << endl;
+          return nullptr;
+        }
+        moduleNode->addOperator(operatorNode);
+      } break;
+      case UmlType::PROPERTY: {
+        Attribute* attributeNode = parseAttribute(context, domElement);
+        if (attributeNode == nullptr) {
+          context.err_ << "Failed to parse attribute" << endl;
+          return nullptr;
+        }
+        moduleNode->addAttribute(attributeNode);
+
+      } break;
+
+      case UmlType::GENERALIZATION: {
+        char* generalType = keep(context, domElement->getAttribute(generalKey_));
+        moduleNode->addGeneralization(generalType);
+      } break;
+
+      default:
+        context.out_ << "UML Type Unimplemented: " << umlType(type) << endl;
+        break;
     }
   }
-  currentScope_.pop_back();
+  context.currentScope_ = context.currentScope_->parent();
+  moduleNode->computeHash();
 
   return moduleNode;
 }
 
-Operator* PapyrusParser::parseOperator(xercesc::DOMElement* op) {
-  char* operatorName = XMLString::transcode(op->getAttribute(nameKey_));
-  char* operatorId = XMLString::transcode(op->getAttribute(idKey_));
-  char* visibility = XMLString::transcode(op->getAttribute(visibilityKey_));
+Operator* PapyrusParser::parseOperator(ParseContext& context, xercesc::DOMElement* op) {
+  char* operatorName = keep(context, op->getAttribute(nameKey_));
+  char* operatorId = keep(context, op->getAttribute(idKey_));
+  char* visibility = scratch(context, op->getAttribute(visibilityKey_));
   Operator* operatorNode;
   if (visibility == nullptr)
     operatorNode = new Operator(operatorName, operatorId);
@@ -409,166 +577,155 @@ Operator* PapyrusParser::parseOperator(xercesc::DOMElement* op) {
       operatorNode = new Operator(operatorName, operatorId);
     }
   }
-  XMLString::release(&visibility);
-
-  DOMNodeList* params = op->getElementsByTagName(paramKey_);
-  if (params->getLength() != 0) {
-    XMLCh* directionKey = XMLString::transcode("direction");
-
-    for (size_t i = 0; i < params->getLength(); i++) {
-      DOMElement* param = (DOMElement*)params->item(i);
-      char* direction = XMLString::transcode(param->getAttribute(directionKey));
-      char* id = XMLString::transcode(param->getAttribute(idKey_));
-      char* name = XMLString::transcode(param->getAttribute(nameKey_));
-      Type* typeNode = nullptr;
-      Param* paramNode = nullptr;
-      Param* returnNode = nullptr;
-      if (!param->hasAttribute(attributeTypeKey_)) {
-        // Check worst case no type associated return nullptr!
-        if (param->getElementsByTagName(attributeTypeKey_)->getLength() <= 0) {
-          cerr << "No type associated with operator parameter: " << (name == nullptr ? "return" : name) << " param Id: " << id << " for operator: " << operatorName << endl;
+
+  vector<DOMElement*> params;
+  findDescendants(op, paramKey_, params);
+  for (size_t i = 0; i < params.size(); i++) {
+    DOMElement* param = params[i];
+    char* direction = scratch(context, param->getAttribute(directionKey_));
+    char* id = keep(context, param->getAttribute(idKey_));
+    char* name = keep(context, param->getAttribute(nameKey_));
+    Type* typeNode = nullptr;
+    Param* paramNode = nullptr;
+    Param* returnNode = nullptr;
+    if (!param->hasAttribute(attributeTypeKey_)) {
+      // Check worst case no type associated return nullptr!
+      DOMElement* typeDomElement = findDescendant(param, attributeTypeKey_);
+      if (typeDomElement == nullptr) {
+        context.err_ << "No type associated with operator parameter: " << (name == nullptr ? "return" : name) << " param Id: " << id << " for operator: " << operatorName << endl;
+        return nullptr;
+      }
+      // primitive type
+      typeNode = types_->intern(scratch(context, typeDomElement->getAttribute(hrefKey_)), true);
+    } else {
+      typeNode = types_->intern(scratch(context, param->getAttribute(attributeTypeKey_)));
+    }
+    if (std::strcmp(direction, "return") == 0) {
+      returnNode = new Param(name, id, typeNode);
+    } else if (std::strcmp(direction, "out") == 0) {
+      // reference/pointer
+      paramNode = new Param(name, id, typeNode, Direction::OUT);
+    } else {
+      // By copy
+      paramNode = new Param(name, id, typeNode);
+    }
+
+    // Only whether there are none, one or several bounds matters
+    vector<DOMElement*> lowerBound;
+    findDescendants(param, lowerValueAttrKey_, lowerBound, 2);
+    vector<DOMElement*> upperBound;
+    findDescendants(param, upperValueAttrKey_, upperBound, 2);
+
+    // Check if its a param node as these have multiplicity tags!
+    if (paramNode) {
+      // Check for lower bounds
+      if (!lowerBound.empty()) {
+        if (lowerBound.size() != 1) {
+          context.err_ << "Params can only support 1 lower bound!";
           return nullptr;
         }
-        // primitive type
-        DOMElement* typeDomElement = (DOMElement*)param->getElementsByTagName(attributeTypeKey_)->item(0);
-        typeNode = new Type(XMLString::transcode(typeDomElement->getAttribute(hrefKey_)), true);
-      } else {
-        typeNode = new Type(XMLString::transcode(param->getAttribute(attributeTypeKey_)));
-      }
-      if (std::strcmp(direction, "return") == 0) {
-        returnNode = new Param(name, id, typeNode);
-      } else if (std::strcmp(direction, "out") == 0) {
-        // reference/pointer
-        paramNode = new Param(name, id, typeNode, Direction::OUT);
+
+        DOMElement* lowerBoundNode = lowerBound[0];
+        char* lowerValue = scratch(context, lowerBoundNode->getAttribute(valueKey_));
+        string lowerValueString = lowerValue;
+        if (!lowerValueString.empty()) {
+          paramNode->nilable_ = false;
+        } else {
+          paramNode->nilable_ = true;
+        }
       } else {
-        // By copy
-        paramNode = new Param(name, id, typeNode);
+        paramNode->nilable_ = false;
       }
 
-      // Check if its a param node as these have multiplicity tags!
-      if (paramNode) {
-        DOMNodeList* lowerBound = param->getElementsByTagName(lowerValueAttrKey_);
-
-        // Check for lower bounds
-        if (lowerBound && lowerBound->getLength() > 0) {
-          if (lowerBound->getLength() != 1) {
-            cerr << "Params can only support 1 lower bound!";
-            return nullptr;
-          }
-
-          DOMElement* lowerBoundNode = (DOMElement*)lowerBound->item(0);
-          char* lowerValue = XMLString::transcode(lowerBoundNode->getAttribute(valueKey_));
-          string lowerValueString = lowerValue;
-          if (!lowerValueString.empty()) {
-            paramNode->nilable_ = false;
-          } else {
-            paramNode->nilable_ = true;
-          }
-          XMLString::release(&lowerValue);
-        } else {
-          paramNode->nilable_ = false;
+      // Check upper bound
+      if (!upperBound.empty()) {
+        if (upperBound.size() != 1) {
+          context.err_ << "Params  can only support 1 upper bound!";
+          return nullptr;
         }
 
-        // Check upper bound
-        DOMNodeList* upperBound = param->getElementsByTagName(upperValueAttrKey_);
-        if (upperBound && upperBound->getLength() > 0) {
-          if (upperBound->getLength() != 1) {
-            cerr << "Params  can only support 1 upper bound!";
-            return nullptr;
-          }
-
-          DOMElement* upperBoundNode = (DOMElement*)upperBound->item(0);
-          char* upperValue = XMLString::transcode(upperBoundNode->getAttribute(valueKey_));
-          string value = upperValue;
-          if (value == "*") {
-            paramNode->unlimited_ = true;
-          } else {
-            paramNode->unlimited_ = false;
-            paramNode->multiplicity_ = atoi(upperValue);
-          }
-          XMLString::release(&upperValue);
+        DOMElement* upperBoundNode = upperBound[0];
+        char* upperValue = scratch(context, upperBoundNode->getAttribute(valueKey_));
+        string value = upperValue;
+        if (value == "*") {
+          paramNode->unlimited_ = true;
         } else {
           paramNode->unlimited_ = false;
+          paramNode->multiplicity_ = atoi(upperValue);
         }
-
-        operatorNode->addParam(paramNode);
+      } else {
+        paramNode->unlimited_ = false;
       }
 
-      // Check if its a return node as these have multiplicity tags!
-      if (returnNode) {
-        DOMNodeList* lowerBound = param->getElementsByTagName(lowerValueAttrKey_);
-
-        // Check for lower bounds
-        if (lowerBound && lowerBound->getLength() > 0) {
-          if (lowerBound->getLength() != 1) {
-            cerr << "Return node can only support 1 lower bound!";
-            return nullptr;
-          }
-
-          DOMElement* lowerBoundNode = (DOMElement*)lowerBound->item(0);
-          char* lowerValue = XMLString::transcode(lowerBoundNode->getAttribute(valueKey_));
-          string lowerValueString = lowerValue;
-          if (!lowerValueString.empty()) {
-            returnNode->nilable_ = false;
-          } else {
-            returnNode->nilable_ = true;
-          }
-          XMLString::release(&lowerValue);
-        } else {
+      operatorNode->addParam(paramNode);
+    }
+
+    // Check if its a return node as these have multiplicity tags!
+    if (returnNode) {
+      // Check for lower bounds
+      if (!lowerBound.empty()) {
+        if (lowerBound.size() != 1) {
+          context.err_ << "Return node can only support 1 lower bound!";
+          return nullptr;
+        }
+
+        DOMElement* lowerBoundNode = lowerBound[0];
+        char* lowerValue = scratch(context, lowerBoundNode->getAttribute(valueKey_));
+        string lowerValueString = lowerValue;
+        if (!lowerValueString.empty()) {
           returnNode->nilable_ = false;
+        } else {
+          returnNode->nilable_ = true;
+        }
+      } else {
+        returnNode->nilable_ = false;
+      }
+
+      // Check upper bound
+      if (!upperBound.empty()) {
+        if (upperBound.size() != 1) {
+          context.err_ << "Return node  can only support 1 upper bound!";
+          return nullptr;
         }
 
-        // Check upper bound
-        DOMNodeList* upperBound = param->getElementsByTagName(upperValueAttrKey_);
-        if (upperBound && upperBound->getLength() > 0) {
-          if (upperBound->getLength() != 1) {
-            cerr << "Return node  can only support 1 upper bound!";
-            return nullptr;
-          }
-
-          DOMElement* upperBoundNode = (DOMElement*)upperBound->item(0);
-          char* upperValue = XMLString::transcode(upperBoundNode->getAttribute(valueKey_));
-          string value = upperValue;
-          if (value == "*") {
-            returnNode->unlimited_ = true;
-          } else {
-            returnNode->unlimited_ = false;
-            returnNode->multiplicity_ = atoi(upperValue);
-          }
-          XMLString::release(&upperValue);
+        DOMElement* upperBoundNode = upperBound[0];
+        char* upperValue = scratch(context, upperBoundNode->getAttribute(valueKey_));
+        string value = upperValue;
+        if (value == "*") {
+          returnNode->unlimited_ = true;
         } else {
           returnNode->unlimited_ = false;
+          returnNode->multiplicity_ = atoi(upperValue);
         }
-
-        operatorNode->addReturnType(returnNode);
+      } else {
+        returnNode->unlimited_ = false;
       }
-    }
 
-    XMLString::release(&directionKey);
+      operatorNode->addReturnType(returnNode);
+    }
   }
 
   return operatorNode;
 }
 
-Attribute* PapyrusParser::parseAttribute(xercesc::DOMElement* attribute) {
-  char* attributeName = XMLString::transcode(attribute->getAttribute(nameKey_));
-  char* attributeId = XMLString::transcode(attribute->getAttribute(idKey_));
-  char* visibility = XMLString::transcode(attribute->getAttribute(visibilityKey_));
-  char* type = XMLString::transcode(attribute->getAttribute(attributeTypeKey_));
+Attribute* PapyrusParser::parseAttribute(ParseContext& context, xercesc::DOMElement* attribute) {
+  char* attributeName = keep(context, attribute->getAttribute(nameKey_));
+  char* attributeId = keep(context, attribute->getAttribute(idKey_));
+  char* visibility = scratch(context, attribute->getAttribute(visibilityKey_));
   Type* typeNode = nullptr;
   // If fail means primitive type
   if (!attribute->hasAttribute(attributeTypeKey_)) {
     // Check worst case no type associated return nullptr!
-    if (attribute->getElementsByTagName(attributeTypeKey_)->getLength() <= 0) {
-      cerr << "No type associated with property: " << attributeName << " property Id: " << attributeId << endl;
+    DOMElement* typeDomElement = findDescendant(attribute, attributeTypeKey_);
+    if (typeDomElement == nullptr) {
+      context.err_ << "No type associated with property: " << attributeName << " property Id: " << attributeId << endl;
       return nullptr;
     }
     // primitive type
-    DOMElement* typeDomElement = (DOMElement*)attribute->getElementsByTagName(attributeTypeKey_)->item(0);
-    typeNode = new Type(XMLString::transcode(typeDomElement->getAttribute(hrefKey_)), true);
+    typeNode = types_->intern(scratch(context, typeDomElement->getAttribute(hrefKey_)), true);
 
   } else {
-    typeNode = new Type(XMLString::transcode(attribute->getAttribute(attributeTypeKey_)));
+    typeNode = types_->intern(scratch(context, attribute->getAttribute(attributeTypeKey_)));
   }
 
   Attribute* attributeNode;
@@ -590,38 +747,39 @@ Attribute* PapyrusParser::parseAttribute(xercesc::DOMElement* attribute) {
     }
   }
 
-  DOMNodeList* lowerBound = attribute->getElementsByTagName(lowerValueAttrKey_);
+  vector<DOMElement*> lowerBound;
+  findDescendants(attribute, lowerValueAttrKey_, lowerBound, 2);
 
   // Check for lower bounds
-  if (lowerBound && lowerBound->getLength() > 0) {
-    if (lowerBound->getLength() != 1) {
-      cerr << "Attributes can only support 1 lower bound!";
+  if (!lowerBound.empty()) {
+    if (lowerBound.size() != 1) {
+      context.err_ << "Attributes can only support 1 lower bound!";
       return nullptr;
     }
 
-    DOMElement* lowerBoundNode = (DOMElement*)lowerBound->item(0);
-    char* lowerValue = XMLString::transcode(lowerBoundNode->getAttribute(valueKey_));
+    DOMElement* lowerBoundNode = lowerBound[0];
+    char* lowerValue = scratch(context, lowerBoundNode->getAttribute(valueKey_));
     string lowerValueString = lowerValue;
     if (!lowerValueString.empty()) {
       attributeNode->nilable_ = false;
     } else {
       attributeNode->nilable_ = true;
     }
-    XMLString::release(&lowerValue);
   } else {
     attributeNode->nilable_ = false;
   }
 
   // Check upper bound
-  DOMNodeList* upperBound = attribute->getElementsByTagName(upperValueAttrKey_);
-  if (upperBound && upperBound->getLength() > 0) {
-    if (upperBound->getLength() != 1) {
-      cerr << "Attributes can only support 1 upper bound!";
+  vector<DOMElement*> upperBound;
+  findDescendants(attribute, upperValueAttrKey_, upperBound, 2);
+  if (!upperBound.empty()) {
+    if (upperBound.size() != 1) {
+      context.err_ << "Attributes can only support 1 upper bound!";
       return nullptr;
     }
 
-    DOMElement* upperBoundNode = (DOMElement*)upperBound->item(0);
-    char* upperValue = XMLString::transcode(upperBoundNode->getAttribute(valueKey_));
+    DOMElement* upperBoundNode = upperBound[0];
+    char* upperValue = scratch(context, upperBoundNode->getAttribute(valueKey_));
     string value = upperValue;
     if (value == "*") {
       attributeNode->unlimited_ = true;
@@ -629,12 +787,10 @@ Attribute* PapyrusParser::parseAttribute(xercesc::DOMElement* attribute) {
       attributeNode->unlimited_ = false;
       attributeNode->multiplicity_ = atoi(upperValue);
     }
-    XMLString::release(&upperValue);
   } else {
     attributeNode->unlimited_ = false;
   }
 
-  XMLString::release(&visibility);
   return attributeNode;
 }
 
@@ -0,0 +1,200 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: SnapshotParser.cpp
+ * @brief:
+ *
+ ***********************************************************/
+#include "parsers/SnapshotParser.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+
+using namespace std;
+namespace XMR {
+
+// Names are not copied out of the mapping, the tree points straight into the string table.
+// The mapping is private and writable so a consumer writing into a name only touches its own copy
+// of the page rather than faulting.
+static char* str(const RelString& string) { return const_cast<char*>(string.get()); }
+
+static Visibility toVisibility(uint32_t visibility) { return visibility <= Visibility::PACKAGE ? static_cast<Visibility>(visibility) : Visibility::PUBLIC; }
+
+bool SnapshotParser::setInputFile(const char* fileName) {
+  int fd = open(fileName, O_RDONLY);
+  if (fd < 0) {
+    cerr << "Failed to open snapshot: " << fileName << endl;
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    cerr << "Failed to stat snapshot: " << fileName << endl;
+    close(fd);
+    return false;
+  }
+
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    cerr << "Failed to map snapshot: " << fileName << endl;
+    return false;
+  }
+
+  mapping_ = shared_ptr<void>(data, [size](void* mapped) { munmap(mapped, size); });
+  header_ = validateSnapshot(data, size);
+  if (header_ == nullptr) {
+    mapping_.reset();
+    return false;
+  }
+
+  return true;
+}
+
+ModelNode* SnapshotParser::parse() {
+  if (header_ == nullptr) {
+    cerr << "No snapshot loaded" << endl;
+    return nullptr;
+  }
+
+  scopes_ = make_shared<ScopeTree>();
+  types_ = make_shared<TypeTable>();
+  ModelNode* modelNode = loadModel(*header_->model_.get());
+  modelNode->storage_ = std::move(mapping_);
+  modelNode->scopes_ = std::move(scopes_);
+  modelNode->types_ = std::move(types_);
+  header_ = nullptr;
+  return modelNode;
+}
+
+const Scope* SnapshotParser::loadScope(const Scope* parent, const RelArray<RelString>& names) {
+  if (names.empty()) return &Scope::EMPTY;
+  // Nodes are stored below their parent, only the last name is new
+  if (parent != nullptr && names.size() == parent->size() + 1) {
+    return scopes_->add(parent, names[names.size() - 1].get());
+  }
+  const Scope* scope = nullptr;
+  for (auto& name : names) {
+    scope = scopes_->add(scope, name.get());
+  }
+  return scope;
+}
+
+ModelNode* SnapshotParser::loadModel(const SnapshotModel& model) {
+  ModelNode* modelNode = new ModelNode(str(model.name_), str(model.id_), loadScope(nullptr, model.fullyQualified_));
+
+  for (auto& package : model.packages_) {
+    modelNode->addPackage(loadPackage(package, modelNode->scope_));
+  }
+  for (auto& module : model.modules_) {
+    modelNode->addModule(loadModule(module, modelNode->scope_));
+  }
+
+  // Modules are linked to their ids when the model is frozen. Ids of modules in the snapshot
+  // share the module's scope, only ids of other resources get one of their own.
+  modelNode->ids_.reserve(model.idNameMap_.size());
+  for (auto& entry : model.idNameMap_) {
+    auto found = moduleScopes_.find(entry.id_.get());
+    modelNode->ids_.add(entry.id_.get(), found != moduleScopes_.end() ? found->second : loadScope(nullptr, entry.names_));
+  }
+  moduleScopes_.clear();
+
+  return modelNode;
+}
+
+Package* SnapshotParser::loadPackage(const SnapshotPackage& package, const Scope* parent) {
+  Package* packageNode = new Package(str(package.name_), str(package.id_), loadScope(parent, package.fullyQualified_));
+
+  for (auto& nested : package.packages_) {
+    packageNode->addPackage(loadPackage(nested, packageNode->scope_));
+  }
+  for (auto& module : package.modules_) {
+    packageNode->addModule(loadModule(module, packageNode->scope_));
+  }
+
+  packageNode->hash_ = package.hash_;
+  return packageNode;
+}
+
+ModuleNode* SnapshotParser::loadModule(const SnapshotModule& module, const Scope* parent) {
+  ModuleNode* moduleNode = new ModuleNode(str(module.name_), str(module.id_), loadScope(parent, module.fullyQualified_), toVisibility(module.visibility_));
+  moduleScopes_.emplace(moduleNode->id_, moduleNode->scope_);
+
+  for (auto& generalization : module.generalizations_) {
+    moduleNode->addGeneralization(str(generalization));
+  }
+  for (auto& nested : module.modules_) {
+    moduleNode->addModule(loadModule(nested, moduleNode->scope_));
+  }
+  for (auto& op : module.operators_) {
+    moduleNode->addOperator(loadOperator(op));
+  }
+  for (auto& attribute : module.attributes_) {
+    moduleNode->addAttribute(loadAttribute(attribute));
+  }
+
+  // The add* calls above derive the dependencies again, replace them with the stored lists
+  // so the loaded tree matches what was snapshotted.
+  moduleNode->softDependencyList_.clear();
+  moduleNode->hardDependencyList_.clear();
+  for (auto& dependency : module.softDependencies_) {
+    moduleNode->softDependencyList_[dependency.get()] = dependency.get();
+  }
+  for (auto& dependency : module.hardDependencies_) {
+    moduleNode->hardDependencyList_[dependency.get()] = dependency.get();
+  }
+
+  moduleNode->hash_ = module.hash_;
+  return moduleNode;
+}
+
+Param* SnapshotParser::loadParam(const SnapshotParam& param) {
+  Type* typeNode = types_->intern(str(param.type_.type_), param.type_.isPrimitive_ != 0);
+  Param* paramNode = new Param(str(param.name_), str(param.id_), typeNode, param.direction_ == Direction::OUT ? Direction::OUT : Direction::IN);
+  paramNode->nilable_ = param.nilable_ != 0;
+  paramNode->unlimited_ = param.unlimited_ != 0;
+  paramNode->multiplicity_ = param.multiplicity_;
+  return paramNode;
+}
+
+Operator* SnapshotParser::loadOperator(const SnapshotOperator& op) {
+  Operator* operatorNode = new Operator(str(op.name_), str(op.id_), toVisibility(op.visibility_));
+  for (auto& param : op.params_) {
+    operatorNode->addParam(loadParam(param));
+  }
+  if (op.hasReturnType_) {
+    operatorNode->addReturnType(loadParam(op.returnType_));
+  }
+  return operatorNode;
+}
+
+Attribute* SnapshotParser::loadAttribute(const SnapshotAttribute& attribute) {
+  Type* typeNode = types_->intern(str(attribute.type_.type_), attribute.type_.isPrimitive_ != 0);
+  Attribute* attributeNode = new Attribute(str(attribute.name_), str(attribute.id_), typeNode, toVisibility(attribute.visibility_));
+  attributeNode->nilable_ = attribute.nilable_ != 0;
+  attributeNode->unlimited_ = attribute.unlimited_ != 0;
+  attributeNode->multiplicity_ = attribute.multiplicity_;
+  return attributeNode;
+}
+
+extern "C" IParser* create_parser() { return new SnapshotParser; }
+extern "C" void destroy_parser(IParser* parser) { delete parser; }
+
+}  // namespace XMR
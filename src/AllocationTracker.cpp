@@ -0,0 +1,149 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: AllocationTracker.cpp
+ * @brief:
+ *
+ ***********************************************************/
+#include "AllocationTracker.hpp"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace {
+
+using XMR::AllocationTracker::NUM_PHASES;
+using XMR::AllocationTracker::Phase;
+
+struct PhaseCounters {
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<uint64_t> frees_{0};
+  std::atomic<uint64_t> freedBytes_{0};
+  std::atomic<uint64_t> peakLiveBytes_{0};
+};
+
+// Plain globals with constant initialization, operator new can run before any constructor
+std::atomic<bool> trackingEnabled{false};
+std::atomic<int64_t> totalLiveBytes{0};
+std::atomic<int64_t> totalPeakLiveBytes{0};
+PhaseCounters counters[NUM_PHASES];
+// Threads that never set a phase, such as a parser's workers, count against the phase set last
+std::atomic<Phase> lastPhase{Phase::STARTUP};
+thread_local int threadPhase = -1;
+
+Phase currentPhase() { return threadPhase < 0 ? lastPhase.load(std::memory_order_relaxed) : static_cast<Phase>(threadPhase); }
+
+void raise(std::atomic<uint64_t>& peak, uint64_t value) {
+  uint64_t seen = peak.load(std::memory_order_relaxed);
+  while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+  }
+}
+
+// Sizes come from malloc_usable_size so frees need no bookkeeping of their own
+void onAllocate(void* memory) {
+  const uint64_t size = malloc_usable_size(memory);
+  PhaseCounters& phase = counters[currentPhase()];
+  phase.allocations_.fetch_add(1, std::memory_order_relaxed);
+  phase.bytes_.fetch_add(size, std::memory_order_relaxed);
+
+  const int64_t live = totalLiveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+  int64_t peak = totalPeakLiveBytes.load(std::memory_order_relaxed);
+  while (live > peak && !totalPeakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+  if (live > 0) raise(phase.peakLiveBytes_, static_cast<uint64_t>(live));
+}
+
+void onFree(void* memory) {
+  const uint64_t size = malloc_usable_size(memory);
+  PhaseCounters& phase = counters[currentPhase()];
+  phase.frees_.fetch_add(1, std::memory_order_relaxed);
+  phase.freedBytes_.fetch_add(size, std::memory_order_relaxed);
+  totalLiveBytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+void* allocate(size_t size) {
+  void* memory = malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) throw std::bad_alloc();
+  if (trackingEnabled.load(std::memory_order_relaxed)) onAllocate(memory);
+  return memory;
+}
+
+void release(void* memory) {
+  if (memory == nullptr) return;
+  if (trackingEnabled.load(std::memory_order_relaxed)) onFree(memory);
+  free(memory);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { release(memory); }
+void operator delete[](void* memory) noexcept { release(memory); }
+void operator delete(void* memory, size_t) noexcept { release(memory); }
+void operator delete[](void* memory, size_t) noexcept { release(memory); }
+
+namespace XMR {
+namespace AllocationTracker {
+
+static const char* PHASE_NAMES[NUM_PHASES] = {"startup", "dom build", "tree build", "dependency analysis", "generation"};
+
+void enable() { trackingEnabled = true; }
+bool enabled() { return trackingEnabled; }
+void setPhase(Phase phase) {
+  threadPhase = phase;
+  lastPhase.store(phase, std::memory_order_relaxed);
+}
+
+PhaseUsage usage(Phase phase) {
+  PhaseUsage result;
+  result.allocations_ = counters[phase].allocations_.load();
+  result.bytes_ = counters[phase].bytes_.load();
+  result.frees_ = counters[phase].frees_.load();
+  result.freedBytes_ = counters[phase].freedBytes_.load();
+  result.peakLiveBytes_ = counters[phase].peakLiveBytes_.load();
+  return result;
+}
+
+// Memory allocated before tracking was enabled and freed after would push live bytes below zero
+uint64_t liveBytes() { return static_cast<uint64_t>(std::max<int64_t>(0, totalLiveBytes.load())); }
+uint64_t peakLiveBytes() { return static_cast<uint64_t>(std::max<int64_t>(0, totalPeakLiveBytes.load())); }
+
+void report(std::ostream& os) {
+  os << std::left << std::setw(22) << "phase" << std::right << std::setw(14) << "allocations" << std::setw(16) << "bytes" << std::setw(14) << "frees" << std::setw(16) << "freed bytes"
+     << std::setw(18) << "peak live bytes" << std::endl;
+  PhaseUsage total;
+  for (int phase = 0; phase < NUM_PHASES; phase++) {
+    PhaseUsage phaseUsage = usage(static_cast<Phase>(phase));
+    os << std::left << std::setw(22) << PHASE_NAMES[phase] << std::right << std::setw(14) << phaseUsage.allocations_ << std::setw(16) << phaseUsage.bytes_ << std::setw(14) << phaseUsage.frees_
+       << std::setw(16) << phaseUsage.freedBytes_ << std::setw(18) << phaseUsage.peakLiveBytes_ << std::endl;
+    total.allocations_ += phaseUsage.allocations_;
+    total.bytes_ += phaseUsage.bytes_;
+    total.frees_ += phaseUsage.frees_;
+    total.freedBytes_ += phaseUsage.freedBytes_;
+  }
+  os << std::left << std::setw(22) << "total" << std::right << std::setw(14) << total.allocations_ << std::setw(16) << total.bytes_ << std::setw(14) << total.frees_ << std::setw(16)
+     << total.freedBytes_ << std::setw(18) << peakLiveBytes() << std::endl;
+  os << "live bytes: " << liveBytes() << " peak live bytes: " << peakLiveBytes() << std::endl;
+}
+
+}  // namespace AllocationTracker
+}  // namespace XMR
@@ -0,0 +1,55 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: AllocationTracker.hpp
+ * @brief: Opt in accounting of every heap allocation of the driver and its plugins
+ *
+ ***********************************************************/
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+namespace XMR {
+
+// The driver replaces the global operator new and delete. Plugins resolve those to the driver's,
+// so allocations made by parsers and generators are counted too. Nothing is counted until the
+// tracker is enabled, which keeps the default path a plain malloc.
+namespace AllocationTracker {
+
+enum Phase { STARTUP, DOM_BUILD, TREE_BUILD, DEPENDENCY_ANALYSIS, GENERATION, NUM_PHASES };
+
+struct PhaseUsage {
+  uint64_t allocations_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t frees_ = 0;
+  uint64_t freedBytes_ = 0;
+  uint64_t peakLiveBytes_ = 0;  // highest live bytes of the whole process seen while in this phase
+};
+
+void enable();
+bool enabled();
+
+// The phase is per thread, generator threads enter their own phases. Threads that never set one
+// follow the phase set last on any thread.
+void setPhase(Phase phase);
+
+PhaseUsage usage(Phase phase);
+uint64_t liveBytes();
+uint64_t peakLiveBytes();
+
+void report(std::ostream& os);
+
+}  // namespace AllocationTracker
+}  // namespace XMR
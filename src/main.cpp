@@ -19,46 +19,103 @@
  ***********************************************************/
 #include <ctype.h>
 #include <dlfcn.h>
+#include <getopt.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "AllocationTracker.hpp"
 #include "generators/IGenerator.hpp"
 #include "parsers/IParser.hpp"
+#include "parsers/ModelFootprint.hpp"
+#include "parsers/ModelSet.hpp"
+#include "parsers/Snapshot.hpp"
 
 using namespace XMR;
 using namespace std;
 
+// A loaded generator plugin. Every run creates a generator object of its own that keeps its
+// working state, so runs of the same plugin are as concurrent as runs of different plugins.
+struct GeneratorLibrary {
+  void* handle = nullptr;
+  IGenerator* (*create)() = nullptr;
+  void (*destroy)(IGenerator*) = nullptr;
+};
+
 int main(int argc, char* argv[]) {
   // Below is the argument parser. Currently takes arg -f for filename
-  std::string file_name;
+  // -f may be repeated to generate from several resources at once
+  // -g and -o may be repeated, the nth -o is the output of the nth -g
+  // -O key=value may be repeated, every generator is given every option
+  std::vector<std::string> file_names;
   std::string parser_file;
-  std::string generator_file;
-  std::string out_file_name;
+  std::vector<std::string> generator_files;
+  std::vector<std::string> out_file_names;
+  std::string cache_dir;
+  std::vector<std::string> targets;
+  std::vector<std::pair<std::string, std::string>> generator_options;
+  bool stats = false;
+  unsigned parse_threads = 1;
   int c;
 
+  // Long only options, reported by getopt_long with their flag value
+  static const option long_options[] = {{"stats", no_argument, nullptr, 'S'}, {"only", required_argument, nullptr, 'T'}, {nullptr, 0, nullptr, 0}};
+
   opterr = 0;
-  while ((c = getopt(argc, argv, "f:p:g:o:")) != -1)  // The last arg contains a list of valid arguments
+  while ((c = getopt_long(argc, argv, "f:p:g:o:c:j:O:", long_options, nullptr)) != -1)  // The last arg contains a list of valid arguments
   {
     switch (c) {
+      case 'S':
+        stats = true;
+        break;
+      case 'T':
+        // Qualified name of a module or package to generate, i.e. Model::Pkg::Class
+        targets.push_back(optarg);
+        break;
       case 'o':
-        out_file_name = optarg;
+        out_file_names.push_back(optarg);
         break;
       case 'f':
-        file_name = optarg;
+        file_names.push_back(optarg);
         break;
       case 'p':
         parser_file = optarg;
         break;
       case 'g':
-        generator_file = optarg;
+        generator_files.push_back(optarg);
+        break;
+      case 'c':
+        cache_dir = optarg;
+        break;
+      case 'O': {
+        // Generator option as key=value, passed to every generator
+        const char* equals = strchr(optarg, '=');
+        if (equals == nullptr) {
+          cerr << "Generator option " << optarg << " is not key=value. Usage: -O <key>=<value>" << endl;
+          return 1;
+        }
+        generator_options.emplace_back(std::string(optarg, equals - optarg), std::string(equals + 1));
+        break;
+      }
+      case 'j':
+        // 0 uses every hardware thread
+        parse_threads = static_cast<unsigned>(strtoul(optarg, nullptr, 10));
+        if (parse_threads == 0) parse_threads = std::max(1u, std::thread::hardware_concurrency());
         break;
       case '?':
-        if (optopt == 'f' || optopt == 'p' || optopt == 'g' || optopt == 'o') {
+        if (optopt == 'f' || optopt == 'p' || optopt == 'g' || optopt == 'o' || optopt == 'c' || optopt == 'j' || optopt == 'O' || optopt == 'T') {
           cerr << "Option " << optopt << " requires an argument" << endl;
         } else if (isprint(optopt)) {
-          cerr << "Unknown option. Usage: -f <filename>" << endl;
+          cerr << "Unknown option. Usage: -f <filename> [-f <filename> ...] [-j <threads>] [-O <key>=<value> ...] [--only <Model::Pkg::Class> ...] [--stats]" << endl;
         } else {
           cerr << "Unkown character" << endl;
         }
@@ -72,21 +129,32 @@ int main(int argc, char* argv[]) {
   for (int index = optind; index < argc; ++index) {
     cout << "Non-option argument " << argv[index] << "\n" << endl;
   }
-  if (file_name.empty()) {
+  if (file_names.empty()) {
     cerr << "Must specify an input file. Usage: -f <filename>" << endl;
     abort();
   }
+  if (stats) {
+    AllocationTracker::enable();
+  }
+  if (parser_file.empty() && file_names[0].ends_with(SNAPSHOT_EXTENSION)) {
+    std::cout << "Using snapshot parser for " << SNAPSHOT_EXTENSION << " input" << std::endl;
+    parser_file = "./parsers/libSnapshotParser.so";
+  }
   if (parser_file.empty()) {
     std::cout << "Using default papyrus parser" << std::endl;
     parser_file = "./parsers/libPapyrusParser.so";
   }
-  if (generator_file.empty()) {
+  if (generator_files.empty()) {
     std::cout << "Using default cpp generator" << std::endl;
-    generator_file = "./generators/libCPPGenerator.so";
+    generator_files.push_back("./generators/libCPPGenerator.so");
   }
-  if (out_file_name.empty()) {
+  if (out_file_names.empty() && generator_files.size() == 1) {
     std::cout << "Default output file name to a.cpp" << std::endl;
-    out_file_name = "a.cpp";
+    out_file_names.push_back("a.cpp");
+  }
+  if (out_file_names.size() != generator_files.size()) {
+    cerr << "Each generator needs its own output file. Usage: -g <generator> -o <output> [-g <generator> -o <output> ...]" << endl;
+    return 1;
   }
 
   void* parser_handle = dlopen(parser_file.c_str(), RTLD_LAZY);
@@ -94,11 +162,13 @@ int main(int argc, char* argv[]) {
     cerr << "Could not load parser .so file. Error: " << dlerror() << endl;
     abort();
   }
-  std::ofstream outputFile;
-  outputFile.open(out_file_name);
-  if (!outputFile.is_open()) {
-    std::cerr << "Failed to create and open outputfile!";
-    abort();
+  std::vector<std::ofstream> outputFiles(out_file_names.size());
+  for (size_t i = 0; i < out_file_names.size(); i++) {
+    outputFiles[i].open(out_file_names[i]);
+    if (!outputFiles[i].is_open()) {
+      std::cerr << "Failed to create and open outputfile: " << out_file_names[i] << endl;
+      abort();
+    }
   }
 
   // Dynamically load the parser create and destroy methods
@@ -112,52 +182,139 @@ int main(int argc, char* argv[]) {
     cerr << "Could not load parse object delete method: " << dlerror() << endl;
     abort();
   }
-  IParser* parser = (IParser*)parser_create();  // create parser object
 
-  // Parsing the document
-  if (!parser->setInputFile(file_name.c_str())) {
-    cerr << "Failed to set input file" << file_name << endl;
-    parser_destroy(parser);
+  // Parsing the documents, every input and the libraries they reference share one id space.
+  // Loading the input is where parsers build their DOM if they have one.
+  ModelSet model_set(parser_create, parser_destroy);
+  model_set.setParallelism(parse_threads);
+  model_set.setStageHook([](ModelSet::Stage stage) { AllocationTracker::setPhase(stage == ModelSet::LOAD ? AllocationTracker::DOM_BUILD : AllocationTracker::TREE_BUILD); });
+  cout << "Starting Model Parse" << endl;
+  AllocationTracker::setPhase(AllocationTracker::DOM_BUILD);
+  if (!model_set.parseAll(file_names)) {
+    cerr << "Failed to parse input files" << endl;
     dlclose(parser_handle);
     return -1;
-  };
-  cout << "Starting Model Parse" << endl;
-  ModelNode* root = parser->parse();
+  }
+  ModelNode* root = model_set.combine();
   cout << "Finish Model Parse" << endl;
-  parser_destroy(parser);
-  dlclose(parser_handle);
-  // Done parsing the document
+  if (model_set.resources().size() > 1) {
+    cout << "Parsed " << model_set.resources().size() << " resources, " << model_set.ids().size() << " ids" << endl;
+  }
+  MemoryStats parser_stats;
+  const bool has_parser_stats = stats && model_set.memoryStats(parser_stats);
+  // Done parsing the documents. The parser plugin stays loaded until generation is done, the model
+  // still uses its code, i.e. the node vtables and the deleters of its storage.
 
-  void* generator_handle = dlopen(generator_file.c_str(), RTLD_LAZY);
-  if (generator_handle == NULL) {
-    cerr << "Could not load generator .so file. Error: " << dlerror() << endl;
-    abort();
+  if (root == nullptr) {
+    cerr << "Root returned is null" << endl;
+    dlclose(parser_handle);
+    return -1;
   }
+  // From here on the model is shared read only between the generator threads
+  root->freeze();
+  const ModelNode* model = root;
+  // Resolved once here, every generator prints from the same lowered model
+  AllocationTracker::setPhase(AllocationTracker::DEPENDENCY_ANALYSIS);
+  const LoweredModel lowered(model);
 
-  // Dynamically load the generator create and destroy methods
-  IGenerator* (*generator_create)() = (IGenerator * (*)()) dlsym(generator_handle, "create_generator");
-  if (generator_create == NULL) {
-    cerr << "Could not load generator object create method: " << dlerror() << endl;
-    abort();
+  // Load every requested generator plugin once
+  std::map<std::string, std::unique_ptr<GeneratorLibrary>> libraries;
+  for (auto& generator_file : generator_files) {
+    if (libraries.contains(generator_file)) continue;
+
+    auto library = std::make_unique<GeneratorLibrary>();
+    library->handle = dlopen(generator_file.c_str(), RTLD_LAZY);
+    if (library->handle == NULL) {
+      cerr << "Could not load generator .so file. Error: " << dlerror() << endl;
+      abort();
+    }
+
+    // Dynamically load the generator create and destroy methods
+    library->create = (IGenerator * (*)()) dlsym(library->handle, "create_generator");
+    if (library->create == NULL) {
+      cerr << "Could not load generator object create method: " << dlerror() << endl;
+      abort();
+    }
+    library->destroy = (void (*)(IGenerator*))dlsym(library->handle, "destroy_generator");
+    if (library->destroy == NULL) {
+      cerr << "Could not load generator object delete method: " << dlerror() << endl;
+      abort();
+    }
+    libraries[generator_file] = std::move(library);
   }
-  void (*generator_destroy)(IGenerator*) = (void (*)(IGenerator*))dlsym(generator_handle, "destroy_generator");
-  if (generator_destroy == NULL) {
-    cerr << "Could not load generator object delete method: " << dlerror() << endl;
-    abort();
+
+  // Optional on disk cache of rendered modules shared between runs
+  GenerationCache* cache = nullptr;
+  if (!cache_dir.empty()) {
+    cache = new GenerationCache(cache_dir);
+    if (!cache->valid()) {
+      delete cache;
+      cache = nullptr;
+    }
   }
-  IGenerator* generator = (IGenerator*)generator_create();  // create generator object
 
-  if (root != nullptr) {
-    cout << "Starting code generation" << endl;
-    bool genResult = generator->generate(outputFile, root);
-    cout << "Finished Generation with result: " << genResult << endl;
-  } else {
-    cerr << "Root returned is null" << endl;
-    generator_destroy(generator);
-    dlclose(generator_handle);
-    return -1;
+  // The model was parsed once, every generator reads it from its own thread
+  cout << "Starting code generation" << endl;
+  std::vector<std::thread> workers;
+  std::vector<char> results(generator_files.size(), false);
+  for (size_t i = 0; i < generator_files.size(); i++) {
+    workers.emplace_back([&, i]() {
+      GeneratorLibrary& library = *libraries.at(generator_files[i]);
+      IGenerator* generator = (IGenerator*)library.create();  // create generator object
+      if (cache != nullptr) {
+        generator->setCache(cache);
+      }
+      generator->setLowered(&lowered);
+      if (!targets.empty() && !generator->setTargets(targets)) {
+        cout << generator_files[i] << " does not support --only, generating the whole model" << endl;
+      }
+      // Generators writing files besides the output place them next to it, the others ignore it
+      generator->setOption("output", out_file_names[i]);
+      for (auto& [key, value] : generator_options) {
+        if (!generator->setOption(key, value)) {
+          cout << generator_files[i] << " ignores option " << key << "=" << value << endl;
+        }
+      }
+      AllocationTracker::setPhase(AllocationTracker::DEPENDENCY_ANALYSIS);
+      generator->check(model);
+      AllocationTracker::setPhase(AllocationTracker::GENERATION);
+      results[i] = generator->generate(outputFiles[i], model);
+      library.destroy(generator);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
   }
-  generator_destroy(generator);
-  dlclose(generator_handle);
+
+  for (size_t i = 0; i < generator_files.size(); i++) {
+    cout << "Finished Generation of " << out_file_names[i] << " with result: " << (bool)results[i] << endl;
+  }
+  if (cache != nullptr) {
+    cout << "Generation cache hits: " << cache->hits() << " misses: " << cache->misses() << endl;
+  }
+
+  if (stats) {
+    cout << endl << "Allocations by phase" << endl;
+    AllocationTracker::report(cout);
+    if (has_parser_stats) {
+      cout << "Parser backend: allocations " << parser_stats.allocations_ << " bytes " << parser_stats.bytes_ << " live bytes " << parser_stats.liveBytes_ << " peak live bytes "
+           << parser_stats.peakLiveBytes_ << endl;
+    }
+
+    ModelFootprint footprint = ModelFootprint::of(model);
+    cout << endl << "Model footprint by node kind" << endl;
+    cout << left << setw(22) << "kind" << right << setw(14) << "count" << setw(16) << "bytes" << endl;
+    for (int kind = 0; kind < ModelFootprint::NUM_KINDS; kind++) {
+      cout << left << setw(22) << ModelFootprint::KIND_NAMES[kind] << right << setw(14) << footprint.usage_[kind].count_ << setw(16) << footprint.usage_[kind].bytes_ << endl;
+    }
+    cout << left << setw(36) << "total bytes" << right << setw(16) << footprint.totalBytes() << endl;
+    cout << left << setw(36) << "lowered model bytes" << right << setw(16) << lowered.heapBytes() << endl;
+  }
+
+  for (auto& library : libraries) {
+    dlclose(library.second->handle);
+  }
+  dlclose(parser_handle);
+  delete cache;
   return 0;
-}
\ No newline at end of file
+}
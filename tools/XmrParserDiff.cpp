@@ -0,0 +1,184 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmrParserDiff.cpp
+ * @brief: Parses one input with two parser plugins and reports where the trees differ
+ *
+ ***********************************************************/
+#include <dlfcn.h>
+#include <getopt.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "parsers/IParser.hpp"
+#include "parsers/ModelDiff.hpp"
+
+using namespace XMR;
+using namespace std;
+
+static void usage() {
+  cerr << "Usage: xmr-parser-diff [options] -f <input>\n"
+          "  -f, --file <file>       input to parse with both parsers\n"
+          "  -a, --reference <lib>   reference parser plugin, ./parsers/libPapyrusParser.so by default\n"
+          "  -b, --candidate <lib>   candidate parser plugin, ./parsers/libFastXmiParser.so by default\n"
+          "  -n, --runs <n>          timed parses per parser, the fastest is reported\n"
+          "  -j, --threads <n>       threads the candidate may parse with, when it supports it\n"
+       << endl;
+}
+
+struct ParserPlugin {
+  void* handle_ = nullptr;
+  IParser* (*create_)() = nullptr;
+  void (*destroy_)(IParser*) = nullptr;
+
+  bool load(const string& path) {
+    handle_ = dlopen(path.c_str(), RTLD_LAZY);
+    if (handle_ == nullptr) {
+      cerr << "Failed to open parser " << path << ": " << dlerror() << endl;
+      return false;
+    }
+    create_ = (IParser * (*)()) dlsym(handle_, "create_parser");
+    destroy_ = (void (*)(IParser*))dlsym(handle_, "destroy_parser");
+    if (create_ == nullptr || destroy_ == nullptr) {
+      cerr << "Parser " << path << " does not export create_parser/destroy_parser" << endl;
+      return false;
+    }
+    return true;
+  }
+};
+
+// Parses the file once, the time covers loading the input and building the tree
+static ModelNode* parseFile(const ParserPlugin& plugin, const string& file, unsigned threads, double& milliseconds) {
+  IParser* parser = plugin.create_();
+  if (threads > 1) parser->setParallelism(threads);
+  const auto start = chrono::steady_clock::now();
+  ModelNode* model = parser->setInputFile(file.c_str()) ? parser->parse() : nullptr;
+  milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  plugin.destroy_(parser);
+  return model;
+}
+
+static size_t countDifferences(const ModelNode* reference, const ModelNode* candidate) {
+  size_t differences = 0;
+  auto report = [&differences](const string& what) {
+    cout << "  " << what << endl;
+    differences++;
+  };
+
+  if (strcmp(reference->name_, candidate->name_) != 0) report("model name differs");
+  if (strcmp(reference->id_, candidate->id_) != 0) report("model id differs");
+  if (*reference->scope_ != *candidate->scope_) report("model scope differs");
+
+  if (reference->packages_.size() != candidate->packages_.size()) {
+    report("top level package count differs: " + to_string(reference->packages_.size()) + " vs " + to_string(candidate->packages_.size()));
+  } else {
+    for (size_t i = 0; i < reference->packages_.size(); i++) {
+      if (reference->packages_[i]->hash_ != candidate->packages_[i]->hash_) report(string("package differs: ") + reference->packages_[i]->id_);
+    }
+  }
+  if (reference->modules_.size() != candidate->modules_.size()) report("top level module count differs");
+
+  // Pinpoints modules, package hashes only say that something below them changed
+  const ModelDiff diff = diffModels(reference, candidate);
+  for (auto& id : diff.removed_) report("module missing from candidate: " + id);
+  for (auto& id : diff.added_) report("module only in candidate: " + id);
+  for (auto& id : diff.changed_) report("module differs: " + id);
+
+  if (!reference->ids_.sameIds(candidate->ids_)) report("id index differs");
+  return differences;
+}
+
+int main(int argc, char* argv[]) {
+  static const option longOptions[] = {{"file", required_argument, nullptr, 'f'},
+                                       {"reference", required_argument, nullptr, 'a'},
+                                       {"candidate", required_argument, nullptr, 'b'},
+                                       {"runs", required_argument, nullptr, 'n'},
+                                       {"threads", required_argument, nullptr, 'j'},
+                                       {"help", no_argument, nullptr, 'h'},
+                                       {nullptr, 0, nullptr, 0}};
+
+  string file;
+  string referencePath = "./parsers/libPapyrusParser.so";
+  string candidatePath = "./parsers/libFastXmiParser.so";
+  int runs = 1;
+  unsigned threads = 1;
+  int c;
+  while ((c = getopt_long(argc, argv, "f:a:b:n:j:h", longOptions, nullptr)) != -1) {
+    switch (c) {
+      case 'f':
+        file = optarg;
+        break;
+      case 'a':
+        referencePath = optarg;
+        break;
+      case 'b':
+        candidatePath = optarg;
+        break;
+      case 'n':
+        runs = max(1, atoi(optarg));
+        break;
+      case 'j':
+        threads = static_cast<unsigned>(max(1, atoi(optarg)));
+        break;
+      default:
+        usage();
+        return c == 'h' ? 0 : 2;
+    }
+  }
+  if (file.empty()) {
+    usage();
+    return 2;
+  }
+
+  ParserPlugin reference, candidate;
+  if (!reference.load(referencePath) || !candidate.load(candidatePath)) return 2;
+
+  // Models are leaked on purpose, their storage may hold deleters that live in the plugins
+  double referenceMs = 0, candidateMs = 0;
+  ModelNode* referenceModel = parseFile(reference, file, 1, referenceMs);
+  ModelNode* candidateModel = parseFile(candidate, file, threads, candidateMs);
+  if (referenceModel == nullptr || candidateModel == nullptr) {
+    cerr << (referenceModel == nullptr ? referencePath : candidatePath) << " failed to parse " << file << endl;
+    return 1;
+  }
+
+  for (int run = 1; run < runs; run++) {
+    double milliseconds = 0;
+    parseFile(reference, file, 1, milliseconds);
+    referenceMs = min(referenceMs, milliseconds);
+    parseFile(candidate, file, threads, milliseconds);
+    candidateMs = min(candidateMs, milliseconds);
+  }
+
+  cout << "Comparing " << candidatePath << " against " << referencePath << endl;
+  const size_t differences = countDifferences(referenceModel, candidateModel);
+
+  const double megabytes = static_cast<double>(filesystem::file_size(file)) / (1 << 20);
+  cout << fixed << setprecision(2);
+  cout << "reference: " << referenceMs << " ms, " << megabytes / (referenceMs / 1000) << " MiB/s" << endl;
+  cout << "candidate: " << candidateMs << " ms, " << megabytes / (candidateMs / 1000) << " MiB/s (" << referenceMs / candidateMs << "x)" << endl;
+
+  if (differences != 0) {
+    cout << differences << " difference(s)" << endl;
+    return 1;
+  }
+  cout << "identical" << endl;
+  return 0;
+}
@@ -0,0 +1,379 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmrPerf.cpp
+ * @brief: Performance regression harness comparing runs against a stored baseline
+ *
+ ***********************************************************/
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "tools/Json.hpp"
+#include "tools/XmiSynth.hpp"
+
+using namespace XMR;
+using namespace std;
+
+// Bump when the corpus or the recorded metrics change, baselines of another version are rejected
+static constexpr double BASELINE_VERSION = 1;
+static constexpr uint64_t CORPUS_SEED = 42;
+static const unsigned CORPUS_CLASSES[] = {1000, 10000};
+
+struct Options {
+  string benchBinary_ = "./xmr_bench";
+  string xmrBinary_ = "./XMR";
+  string baselineFile_ = "perf/baseline.json";
+  string outFile_;
+  string filter_;
+  bool record_ = false;
+  unsigned runs_ = 3;
+  double timeThreshold_ = 0.15;    // allowed relative slowdown
+  double memoryThreshold_ = 0.05;  // allowed relative growth of peak RSS and allocations
+};
+
+struct RunResult {
+  bool ok_ = false;
+  double wallMs_ = 0;
+  double peakRssKb_ = 0;
+  double allocations_ = 0;
+};
+
+/**
+ * Runs a program to completion
+ *
+ * @param[in] args program followed by its arguments
+ * @param[in] workDir directory the program runs in
+ * @param[in] outputFile file receiving the program's standard output, discarded when empty
+ * @returns wall time and peak resident set size of the child
+ */
+static RunResult runProcess(const vector<string>& args, const string& workDir, const string& outputFile = "") {
+  RunResult result;
+  vector<char*> argv;
+  for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  const auto start = chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    cerr << "Failed to fork for " << args[0] << endl;
+    return result;
+  }
+  if (pid == 0) {
+    int devNull = open("/dev/null", O_WRONLY);
+    int output = outputFile.empty() ? devNull : open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output >= 0) dup2(output, STDOUT_FILENO);
+    if (devNull >= 0) dup2(devNull, STDERR_FILENO);
+    if (chdir(workDir.c_str()) != 0) _exit(126);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+
+  int status = 0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    cerr << "Failed to wait for " << args[0] << endl;
+    return result;
+  }
+  result.wallMs_ = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  result.peakRssKb_ = static_cast<double>(usage.ru_maxrss);
+  result.ok_ = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  if (!result.ok_) {
+    cerr << args[0] << " failed with status " << status << endl;
+  }
+  return result;
+}
+
+// Total allocations from the driver's --stats report, the row reads: total <allocations> <bytes> ...
+static double readAllocations(const filesystem::path& statsFile) {
+  ifstream in(statsFile);
+  string line;
+  while (getline(in, line)) {
+    if (line.starts_with("total ")) {
+      istringstream row(line.substr(6));
+      double allocations = 0;
+      row >> allocations;
+      return allocations;
+    }
+  }
+  return 0;
+}
+
+// End to end runs of the driver on the synthetic corpus, best wall time and worst RSS of all runs
+static bool measureXmr(const Options& options, const filesystem::path& scratch, JsonValue& entries) {
+  const filesystem::path xmr = filesystem::absolute(options.xmrBinary_);
+  for (auto classes : CORPUS_CLASSES) {
+    SynthOptions synthOptions;
+    synthOptions.depth_ = 2;
+    synthOptions.packagesPerLevel_ = 4;
+    synthOptions.classesPerPackage_ = classes / 20;
+    synthOptions.generalizationFanIn_ = 1;
+    synthOptions.seed_ = CORPUS_SEED;
+
+    const filesystem::path corpus = scratch / ("corpus_" + to_string(classes) + ".uml");
+    {
+      ofstream out(corpus);
+      XmiSynth(synthOptions).write(out);
+    }
+
+    RunResult best;
+    for (unsigned run = 0; run < options.runs_; run++) {
+      // The driver finds its plugins relative to the working directory, so it runs next to them
+      const filesystem::path statsFile = scratch / "stats.txt";
+      RunResult result = runProcess({xmr.string(), "-f", corpus.string(), "-o", (scratch / "out.cpp").string(), "--stats"}, xmr.parent_path().string(), statsFile.string());
+      if (!result.ok_) return false;
+      best.wallMs_ = run == 0 ? result.wallMs_ : min(best.wallMs_, result.wallMs_);
+      best.peakRssKb_ = max(best.peakRssKb_, result.peakRssKb_);
+      best.allocations_ = max(best.allocations_, readAllocations(statsFile));
+    }
+
+    JsonValue& entry = entries["xmr/cpp/" + to_string(classes)];
+    entry["wall_ms"] = best.wallMs_;
+    entry["peak_rss_kb"] = best.peakRssKb_;
+    if (best.allocations_ > 0) {
+      entry["allocs"] = best.allocations_;
+    }
+  }
+  return true;
+}
+
+static double toNanoseconds(double time, const string& unit) {
+  if (unit == "us") return time * 1e3;
+  if (unit == "ms") return time * 1e6;
+  if (unit == "s") return time * 1e9;
+  return time;
+}
+
+// Runs the benchmark suite with a JSON report and keeps time and allocations of every case
+static bool measureBench(const Options& options, const filesystem::path& scratch, JsonValue& entries) {
+  const filesystem::path bench = filesystem::absolute(options.benchBinary_);
+  const filesystem::path report = scratch / "bench.json";
+  vector<string> args = {bench.string(), "--benchmark_out=" + report.string(), "--benchmark_out_format=json"};
+  if (!options.filter_.empty()) args.push_back("--benchmark_filter=" + options.filter_);
+
+  RunResult run = runProcess(args, scratch.string());
+  if (!run.ok_) return false;
+
+  ifstream in(report);
+  stringstream text;
+  text << in.rdbuf();
+  JsonValue json;
+  if (!JsonValue::parse(text.str(), json) || json.find("benchmarks") == nullptr) {
+    cerr << "Failed to read benchmark report: " << report << endl;
+    return false;
+  }
+
+  for (auto& benchmark : json.find("benchmarks")->items()) {
+    const JsonValue* name = benchmark.find("name");
+    const JsonValue* realTime = benchmark.find("real_time");
+    const JsonValue* unit = benchmark.find("time_unit");
+    if (name == nullptr || realTime == nullptr || benchmark.find("error_occurred") != nullptr) continue;
+
+    JsonValue& entry = entries["bench/" + name->asString()];
+    entry["real_time_ns"] = toNanoseconds(realTime->asNumber(), unit == nullptr ? "ns" : unit->asString());
+    if (const JsonValue* allocs = benchmark.find("allocs")) {
+      entry["allocs"] = allocs->asNumber();
+    }
+  }
+  return true;
+}
+
+static bool isTimeMetric(const string& metric) { return metric == "wall_ms" || metric == "real_time_ns"; }
+
+/**
+ * Compares every metric of the baseline with the current run
+ *
+ * @returns number of metrics over their threshold
+ */
+static size_t compare(const Options& options, const JsonValue& baseline, const JsonValue& current) {
+  size_t regressions = 0;
+  cout << left << setw(48) << "entry" << setw(14) << "metric" << right << setw(16) << "baseline" << setw(16) << "current" << setw(10) << "change" << endl;
+  for (auto& entry : baseline.members()) {
+    const JsonValue* measured = current.find(entry.first);
+    if (measured == nullptr) {
+      cout << left << setw(48) << entry.first << "missing from this run" << endl;
+      continue;
+    }
+    for (auto& metric : entry.second.members()) {
+      const JsonValue* value = measured->find(metric.first);
+      if (value == nullptr || metric.second.asNumber() <= 0) continue;
+
+      const double change = value->asNumber() / metric.second.asNumber() - 1;
+      const double threshold = isTimeMetric(metric.first) ? options.timeThreshold_ : options.memoryThreshold_;
+      const bool regressed = change > threshold;
+      regressions += regressed;
+      cout << left << setw(48) << entry.first << setw(14) << metric.first << right << fixed << setprecision(1) << setw(16) << metric.second.asNumber() << setw(16) << value->asNumber()
+           << setw(9) << change * 100 << "%" << (regressed ? "  REGRESSION" : "") << endl;
+    }
+  }
+  return regressions;
+}
+
+// Writes the run as the new baseline, creating its directory
+static bool recordBaseline(const Options& options, const JsonValue& current) {
+  if (filesystem::path(options.baselineFile_).has_parent_path()) {
+    filesystem::create_directories(filesystem::path(options.baselineFile_).parent_path());
+  }
+  ofstream out(options.baselineFile_);
+  if (!out.is_open()) {
+    cerr << "Failed to create and open baseline: " << options.baselineFile_ << endl;
+    return false;
+  }
+  current.write(out);
+  out << endl;
+  return true;
+}
+
+static void usage() {
+  cerr << "Usage: xmr-perf [options]\n"
+          "  -b, --bench <path>             xmr_bench binary, empty to skip the benchmark suite\n"
+          "  -x, --xmr <path>               XMR binary, empty to skip end to end runs\n"
+          "  -B, --baseline <file>          stored baseline, recorded by the first run if missing\n"
+          "  -r, --record                   write this run as the new baseline instead of comparing\n"
+          "  -o, --output <file>            also write this run to a file\n"
+          "  -f, --filter <regex>           only run matching benchmarks\n"
+          "  -n, --runs <n>                 end to end runs per corpus file\n"
+          "  -t, --time-threshold <ratio>   allowed slowdown, 0.15 is 15%\n"
+          "  -m, --memory-threshold <ratio> allowed growth of peak RSS and allocations\n"
+       << endl;
+}
+
+int main(int argc, char* argv[]) {
+  static const option longOptions[] = {{"bench", required_argument, nullptr, 'b'},
+                                       {"xmr", required_argument, nullptr, 'x'},
+                                       {"baseline", required_argument, nullptr, 'B'},
+                                       {"record", no_argument, nullptr, 'r'},
+                                       {"output", required_argument, nullptr, 'o'},
+                                       {"filter", required_argument, nullptr, 'f'},
+                                       {"runs", required_argument, nullptr, 'n'},
+                                       {"time-threshold", required_argument, nullptr, 't'},
+                                       {"memory-threshold", required_argument, nullptr, 'm'},
+                                       {"help", no_argument, nullptr, 'h'},
+                                       {nullptr, 0, nullptr, 0}};
+
+  Options options;
+  int c;
+  while ((c = getopt_long(argc, argv, "b:x:B:ro:f:n:t:m:h", longOptions, nullptr)) != -1) {
+    switch (c) {
+      case 'b':
+        options.benchBinary_ = optarg;
+        break;
+      case 'x':
+        options.xmrBinary_ = optarg;
+        break;
+      case 'B':
+        options.baselineFile_ = optarg;
+        break;
+      case 'r':
+        options.record_ = true;
+        break;
+      case 'o':
+        options.outFile_ = optarg;
+        break;
+      case 'f':
+        options.filter_ = optarg;
+        break;
+      case 'n':
+        options.runs_ = max(1ul, stoul(optarg));
+        break;
+      case 't':
+        options.timeThreshold_ = stod(optarg);
+        break;
+      case 'm':
+        options.memoryThreshold_ = stod(optarg);
+        break;
+      case 'h':
+        usage();
+        return 0;
+      default:
+        usage();
+        return 1;
+    }
+  }
+
+  const filesystem::path scratch = filesystem::temp_directory_path() / ("xmr_perf_" + to_string(getpid()));
+  filesystem::create_directories(scratch);
+
+  JsonValue current = JsonValue::object();
+  current["version"] = BASELINE_VERSION;
+  current["corpus_seed"] = static_cast<double>(CORPUS_SEED);
+  JsonValue& entries = current["entries"];
+  entries = JsonValue::object();
+
+  bool ok = true;
+  if (!options.xmrBinary_.empty()) {
+    cout << "Running XMR on the synthetic corpus" << endl;
+    ok = measureXmr(options, scratch, entries) && ok;
+  }
+  if (!options.benchBinary_.empty()) {
+    cout << "Running benchmark suite" << endl;
+    ok = measureBench(options, scratch, entries) && ok;
+  }
+  filesystem::remove_all(scratch);
+  if (!ok) {
+    cerr << "Measurements failed" << endl;
+    return 1;
+  }
+
+  if (!options.outFile_.empty()) {
+    ofstream out(options.outFile_);
+    current.write(out);
+    out << endl;
+  }
+
+  if (options.record_) {
+    if (!recordBaseline(options, current)) return 1;
+    cout << "Recorded baseline " << options.baselineFile_ << endl;
+    return 0;
+  }
+
+  // Baselines are specific to the machine they were measured on so none ships with the sources,
+  // a first check records one rather than failing
+  ifstream in(options.baselineFile_);
+  if (!in.is_open()) {
+    if (!recordBaseline(options, current)) return 1;
+    cout << "No baseline at " << options.baselineFile_ << ", recorded this run as the baseline, later runs are compared against it" << endl;
+    return 0;
+  }
+  stringstream text;
+  text << in.rdbuf();
+  JsonValue baseline;
+  if (!JsonValue::parse(text.str(), baseline) || baseline.find("entries") == nullptr) {
+    cerr << "Failed to read baseline: " << options.baselineFile_ << endl;
+    return 1;
+  }
+  const JsonValue* version = baseline.find("version");
+  if (version == nullptr || version->asNumber() != BASELINE_VERSION) {
+    cerr << "Baseline was recorded by another version of the harness, record it again" << endl;
+    return 1;
+  }
+
+  const size_t regressions = compare(options, *baseline.find("entries"), entries);
+  if (regressions > 0) {
+    cerr << regressions << " metric(s) regressed past their threshold" << endl;
+    return 1;
+  }
+  cout << "No regressions against " << options.baselineFile_ << endl;
+  return 0;
+}
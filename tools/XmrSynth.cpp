@@ -0,0 +1,139 @@
+/**********************************************************
+ * Copyright 2025 Jason Cisneros & Lucas Van Der Heijden
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @filename: XmrSynth.cpp
+ * @brief: Command line front end of the synthetic XMI model generator
+ *
+ ***********************************************************/
+#include <getopt.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "tools/XmiSynth.hpp"
+
+using namespace XMR;
+using namespace std;
+
+static void usage() {
+  cerr << "Usage: xmr-synth [options]\n"
+          "  -o, --output <file>            output file, stdout when omitted\n"
+          "  -n, --name <name>              model name\n"
+          "  -d, --depth <n>                levels of nested packages\n"
+          "  -p, --packages <n>             packages per level\n"
+          "  -c, --classes <n>              classes per package\n"
+          "  -a, --attributes <n>           attributes per class\n"
+          "  -O, --operations <n>           operations per class\n"
+          "  -P, --params <n>               parameters per operation\n"
+          "  -G, --generalizations <n>      base classes per class\n"
+          "  -H, --hard-density <0..1>      chance an attribute or parameter is a hard dependency\n"
+          "  -S, --soft-density <0..1>      chance an attribute or parameter is a soft dependency\n"
+          "  -y, --cycles <n>               hard dependency cycles to inject\n"
+          "  -s, --seed <n>                 random seed\n"
+       << endl;
+}
+
+int main(int argc, char* argv[]) {
+  static const option longOptions[] = {
+      {"output", required_argument, nullptr, 'o'},      {"name", required_argument, nullptr, 'n'},
+      {"depth", required_argument, nullptr, 'd'},       {"packages", required_argument, nullptr, 'p'},
+      {"classes", required_argument, nullptr, 'c'},     {"attributes", required_argument, nullptr, 'a'},
+      {"operations", required_argument, nullptr, 'O'},  {"params", required_argument, nullptr, 'P'},
+      {"generalizations", required_argument, nullptr, 'G'}, {"hard-density", required_argument, nullptr, 'H'},
+      {"soft-density", required_argument, nullptr, 'S'}, {"cycles", required_argument, nullptr, 'y'},
+      {"seed", required_argument, nullptr, 's'},        {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  SynthOptions options;
+  string outFileName;
+  int c;
+  while ((c = getopt_long(argc, argv, "o:n:d:p:c:a:O:P:G:H:S:y:s:h", longOptions, nullptr)) != -1) {
+    // stoul and stod throw on values that are not numbers or do not fit
+    try {
+      switch (c) {
+        case 'o':
+          outFileName = optarg;
+          break;
+        case 'n':
+          options.modelName_ = optarg;
+          break;
+        case 'd':
+          options.depth_ = stoul(optarg);
+          break;
+        case 'p':
+          options.packagesPerLevel_ = stoul(optarg);
+          break;
+        case 'c':
+          options.classesPerPackage_ = stoul(optarg);
+          break;
+        case 'a':
+          options.attributesPerClass_ = stoul(optarg);
+          break;
+        case 'O':
+          options.operationsPerClass_ = stoul(optarg);
+          break;
+        case 'P':
+          options.paramsPerOperation_ = stoul(optarg);
+          break;
+        case 'G':
+          options.generalizationFanIn_ = stoul(optarg);
+          break;
+        case 'H':
+          options.hardDependencyDensity_ = stod(optarg);
+          break;
+        case 'S':
+          options.softDependencyDensity_ = stod(optarg);
+          break;
+        case 'y':
+          options.cycles_ = stoul(optarg);
+          break;
+        case 's':
+          options.seed_ = stoull(optarg);
+          break;
+        case 'h':
+          usage();
+          return 0;
+        default:
+          usage();
+          return 1;
+      }
+    } catch (const logic_error&) {
+      cerr << "Invalid value for option -" << static_cast<char>(c) << ": " << optarg << endl;
+      usage();
+      return 1;
+    }
+  }
+
+  if (options.hardDependencyDensity_ < 0 || options.softDependencyDensity_ < 0 || options.hardDependencyDensity_ + options.softDependencyDensity_ > 1) {
+    cerr << "Dependency densities must be positive and add up to at most 1" << endl;
+    return 1;
+  }
+
+  XmiSynth synth(options);
+  if (outFileName.empty()) {
+    synth.write(cout);
+  } else {
+    ofstream outputFile(outFileName);
+    if (!outputFile.is_open()) {
+      cerr << "Failed to create and open outputfile: " << outFileName << endl;
+      return 1;
+    }
+    synth.write(outputFile);
+  }
+
+  cerr << "Wrote " << synth.numPackages() << " packages and " << synth.numClasses() << " classes" << endl;
+  return 0;
+}